@@ -0,0 +1,124 @@
+#include "generators.h"
+
+#include "AnalyticTable.h"
+#include "AnalyticTableNumeric.h"
+#include "GroupBy.h"
+
+#include <benchmark/benchmark.h>
+
+namespace banalytic_table {
+
+/// Rows x number of distinct categories of the expanded column
+void categories(benchmark::internal::Benchmark *b) {
+  b->ArgsProduct({{1 << 12, 1 << 15, 1 << 18}, {4, 32}})->ArgNames({"rows", "categories"});
+}
+
+void BM_AnalyticTable_one_hot_expand(benchmark::State &state) {
+  auto table = bench::categorical_table(state.range(0), state.range(1));
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto input = table.clone();
+    state.ResumeTiming();
+
+    input.one_hot_expand(0);
+    benchmark::DoNotOptimize(input.arrow_table());
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <utl::NumericType T>
+void BM_AnalyticTable_sort(benchmark::State &state) {
+  auto table = bench::random_table<T>(state.range(0), state.range(1));
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto input = table.clone();
+    state.ResumeTiming();
+
+    input.sort(0);
+    benchmark::DoNotOptimize(input.arrow_table());
+  }
+
+  bench::set_throughput<T>(state);
+}
+
+template <utl::NumericType T>
+void BM_AnalyticTable_clone(benchmark::State &state) {
+  auto table = bench::random_table<T>(state.range(0), state.range(1));
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(table.clone());
+
+  bench::set_throughput<T>(state);
+}
+
+template <utl::NumericType T>
+void BM_AnalyticTableNumeric_argmax(benchmark::State &state) {
+  auto table = bench::random_table<T>(state.range(0), state.range(1));
+  auto axis = state.range(2) == 0 ? ttb::Axis::ROW : ttb::Axis::COLUMN;
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(table.argmax(axis));
+
+  bench::set_throughput<T>(state);
+}
+
+void argmax_shapes(benchmark::internal::Benchmark *b) {
+  b->ArgsProduct({{1 << 12, 1 << 15, 1 << 18}, {4, 32}, {0, 1}})
+      ->ArgNames({"rows", "cols", "axis"});
+}
+
+/// Dimension table with one row per category and a feature column
+ttb::AnalyticTable dimension_table(int64_t n_categories) {
+  arrow::Int64Builder keys;
+  arrow::DoubleBuilder values;
+  for (int64_t i{0}; i < n_categories; ++i) {
+    if (!keys.Append(i).ok() || !values.Append(static_cast<double>(i) / 2).ok())
+      throw std::runtime_error("Failed to build dimension table");
+  }
+
+  auto schema = arrow::schema(
+      {arrow::field("category", arrow::int64()), arrow::field("feature", arrow::float64())});
+  return ttb::AnalyticTable{
+      arrow::Table::Make(schema, {keys.Finish().ValueOrDie(), values.Finish().ValueOrDie()})};
+}
+
+void BM_AnalyticTable_join(benchmark::State &state) {
+  auto table = bench::categorical_table(state.range(0), state.range(1));
+  auto dimension = dimension_table(state.range(1));
+  auto strategy =
+      state.range(2) == 0 ? ttb::JoinStrategy::BROADCAST : ttb::JoinStrategy::PARTITIONED;
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(table.joined(dimension, {"category"}, ttb::JoinType::LEFT, strategy));
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void join_shapes(benchmark::internal::Benchmark *b) {
+  b->ArgsProduct({{1 << 15, 1 << 18}, {32, 1 << 12}, {0, 1}})
+      ->ArgNames({"rows", "categories", "partitioned"});
+}
+
+void BM_GroupBy_agg(benchmark::State &state) {
+  auto table = bench::categorical_table(state.range(0), state.range(1));
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(table.group_by({"category"}).agg(
+        {{"category", ttb::Aggregation::COUNT}, {"category", ttb::Aggregation::MEAN}}));
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+} // namespace banalytic_table
+
+BENCHMARK(banalytic_table::BM_AnalyticTable_one_hot_expand)->Apply(banalytic_table::categories);
+BENCHMARK(banalytic_table::BM_AnalyticTable_join)->Apply(banalytic_table::join_shapes);
+BENCHMARK(banalytic_table::BM_GroupBy_agg)->Apply(banalytic_table::categories);
+
+BENCHMARK_NUMERIC_TEMPLATES(banalytic_table::BM_AnalyticTable_sort, bench::shapes);
+BENCHMARK_NUMERIC_TEMPLATES(banalytic_table::BM_AnalyticTable_clone, bench::shapes);
+BENCHMARK_NUMERIC_TEMPLATES(banalytic_table::BM_AnalyticTableNumeric_argmax,
+                            banalytic_table::argmax_shapes);
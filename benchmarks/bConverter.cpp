@@ -0,0 +1,42 @@
+#include "generators.h"
+
+#include "Converter.h"
+
+#include <benchmark/benchmark.h>
+
+namespace bconverter {
+
+template <utl::NumericType T>
+void BM_Converter_torch_tensor(benchmark::State &state) {
+  auto table = bench::random_table<T>(state.range(0), state.range(1));
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    ttb::TbNumeric<T> input{table.clone()};
+    state.ResumeTiming();
+
+    benchmark::DoNotOptimize(ttb::Converter::torch_tensor<T>(std::move(input)));
+  }
+
+  bench::set_throughput<T>(state);
+}
+
+template <utl::NumericType T>
+void BM_Converter_analytic_table(benchmark::State &state) {
+  auto tensor = bench::random_tensor<T>(state.range(0), state.range(1));
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto input = tensor.clone();
+    state.ResumeTiming();
+
+    benchmark::DoNotOptimize(ttb::Converter::analytic_table<T>(std::move(input)));
+  }
+
+  bench::set_throughput<T>(state);
+}
+
+} // namespace bconverter
+
+BENCHMARK_NUMERIC_TEMPLATES(bconverter::BM_Converter_torch_tensor, bench::shapes);
+BENCHMARK_NUMERIC_TEMPLATES(bconverter::BM_Converter_analytic_table, bench::shapes);
@@ -0,0 +1,55 @@
+#include "generators.h"
+
+#include "CSV_IO.h"
+#include "Parquet_IO.h"
+
+#include <benchmark/benchmark.h>
+#include <filesystem>
+
+namespace bio {
+
+template <utl::NumericType T>
+void BM_CSV_IO_read(benchmark::State &state) {
+  auto path = bench::temp_path("csv_read", ".csv");
+  ttb::CSV_IO{path}.write(bench::random_table<T>(state.range(0), state.range(1)));
+
+  ttb::CSV_IO reader{path};
+  for (auto _ : state)
+    benchmark::DoNotOptimize(reader.read());
+
+  bench::set_throughput<T>(state);
+  state.counters["file_bytes"] = static_cast<double>(std::filesystem::file_size(path));
+  std::filesystem::remove(path);
+}
+
+template <utl::NumericType T>
+void BM_Parquet_IO_read(benchmark::State &state) {
+  auto path = bench::temp_path("parquet_read", ".parquet");
+  ttb::Parquet_IO{path}.write(bench::random_table<T>(state.range(0), state.range(1)));
+
+  ttb::Parquet_IO reader{path};
+  for (auto _ : state)
+    benchmark::DoNotOptimize(reader.read());
+
+  bench::set_throughput<T>(state);
+  std::filesystem::remove(path);
+}
+
+template <utl::NumericType T>
+void BM_Parquet_IO_write(benchmark::State &state) {
+  auto path = bench::temp_path("parquet_write", ".parquet");
+  auto table = bench::random_table<T>(state.range(0), state.range(1));
+
+  ttb::Parquet_IO writer{path};
+  for (auto _ : state)
+    writer.write(table);
+
+  bench::set_throughput<T>(state);
+  std::filesystem::remove(path);
+}
+
+} // namespace bio
+
+BENCHMARK_NUMERIC_TEMPLATES(bio::BM_CSV_IO_read, bench::shapes);
+BENCHMARK_NUMERIC_TEMPLATES(bio::BM_Parquet_IO_read, bench::shapes);
+BENCHMARK_NUMERIC_TEMPLATES(bio::BM_Parquet_IO_write, bench::shapes);
@@ -0,0 +1,44 @@
+#include "generators.h"
+
+#include "TrainingBundle.h"
+#include "XYMatrix.h"
+
+#include <benchmark/benchmark.h>
+
+namespace btraining_bundle {
+
+/// Normalizations are only defined on floating point X
+template <typename T>
+void run_normz(benchmark::State &state, ttb::Normalization normalization) {
+  auto bundle = ttb::XYMatrix::split(bench::random_xy<T>(state.range(0), state.range(1)), 20);
+
+  for (auto _ : state) {
+    for (int j{0}; j < state.range(1); ++j)
+      benchmark::DoNotOptimize(normalization == ttb::Normalization::MIN_MAX
+                                   ? bundle.min_max_normz(j)
+                                   : bundle.z_score_normz(j));
+  }
+
+  bench::set_throughput<T>(state);
+}
+
+template <typename T>
+void BM_TrainingBundle_min_max_normz(benchmark::State &state) {
+  run_normz<T>(state, ttb::Normalization::MIN_MAX);
+}
+
+template <typename T>
+void BM_TrainingBundle_z_score_normz(benchmark::State &state) {
+  run_normz<T>(state, ttb::Normalization::Z_SCORE);
+}
+
+} // namespace btraining_bundle
+
+BENCHMARK_TEMPLATE(btraining_bundle::BM_TrainingBundle_min_max_normz, float)
+    ->Apply(bench::shapes);
+BENCHMARK_TEMPLATE(btraining_bundle::BM_TrainingBundle_min_max_normz, double)
+    ->Apply(bench::shapes);
+BENCHMARK_TEMPLATE(btraining_bundle::BM_TrainingBundle_z_score_normz, float)
+    ->Apply(bench::shapes);
+BENCHMARK_TEMPLATE(btraining_bundle::BM_TrainingBundle_z_score_normz, double)
+    ->Apply(bench::shapes);
@@ -0,0 +1,74 @@
+#include "generators.h"
+
+#include "TrainingBundle.h"
+#include "XYMatrix.h"
+
+#include <benchmark/benchmark.h>
+
+namespace bxy_matrix {
+
+inline constexpr int PCT_EVAL{20};
+
+template <utl::NumericType T>
+void BM_XYMatrix_shuffle(benchmark::State &state) {
+  auto xy = bench::random_xy<T>(state.range(0), state.range(1));
+
+  for (auto _ : state) {
+    xy.shuffle(bench::SEED);
+    benchmark::DoNotOptimize(xy.X());
+  }
+
+  bench::set_throughput<T>(state);
+}
+
+template <utl::NumericType T, typename Split>
+void run_split(benchmark::State &state, Split split) {
+  auto xy = bench::random_xy<T>(state.range(0), state.range(1));
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    ttb::XYMatrix input{xy.X().clone(), xy.Y().clone()};
+    state.ResumeTiming();
+
+    benchmark::DoNotOptimize(split(std::move(input)));
+  }
+
+  bench::set_throughput<T>(state);
+}
+
+template <utl::NumericType T>
+void BM_XYMatrix_split(benchmark::State &state) {
+  run_split<T>(state,
+               [](ttb::XYMatrix &&xy) { return ttb::XYMatrix::split(std::move(xy), PCT_EVAL); });
+}
+
+template <utl::NumericType T>
+void BM_XYMatrix_shuffle_split(benchmark::State &state) {
+  run_split<T>(state, [](ttb::XYMatrix &&xy) {
+    return ttb::XYMatrix::shuffle_split(std::move(xy), PCT_EVAL, bench::SEED);
+  });
+}
+
+template <utl::NumericType T>
+void BM_XYMatrix_stratified_split_from_one_hot(benchmark::State &state) {
+  run_split<T>(state, [](ttb::XYMatrix &&xy) {
+    return ttb::XYMatrix::stratified_split_from_one_hot(std::move(xy), PCT_EVAL, bench::SEED);
+  });
+}
+
+template <utl::NumericType T>
+void BM_XYMatrix_shuffle_stratified_split_from_one_hot(benchmark::State &state) {
+  run_split<T>(state, [](ttb::XYMatrix &&xy) {
+    return ttb::XYMatrix::shuffle_stratified_split_from_one_hot(std::move(xy), PCT_EVAL,
+                                                                bench::SEED);
+  });
+}
+
+} // namespace bxy_matrix
+
+BENCHMARK_NUMERIC_TEMPLATES(bxy_matrix::BM_XYMatrix_shuffle, bench::shapes);
+BENCHMARK_NUMERIC_TEMPLATES(bxy_matrix::BM_XYMatrix_split, bench::shapes);
+BENCHMARK_NUMERIC_TEMPLATES(bxy_matrix::BM_XYMatrix_shuffle_split, bench::shapes);
+BENCHMARK_NUMERIC_TEMPLATES(bxy_matrix::BM_XYMatrix_stratified_split_from_one_hot, bench::shapes);
+BENCHMARK_NUMERIC_TEMPLATES(bxy_matrix::BM_XYMatrix_shuffle_stratified_split_from_one_hot,
+                            bench::shapes);
@@ -0,0 +1,98 @@
+#ifndef BENCH_GENERATORS_H
+#define BENCH_GENERATORS_H
+#pragma once
+
+#include "AnalyticTableNumeric.h"
+#include "Converter.h"
+#include "XYMatrix.h"
+#include "detail/utils.h"
+
+#include <arrow/api.h>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+
+/**
+ * @brief Synthetic data shared by the benchmarks; every generator is seeded so runs across
+ * releases see the same data
+ *
+ */
+namespace bench {
+
+inline constexpr uint64_t SEED{42};
+inline constexpr int64_t N_CLASSES{4};
+
+/// rows x cols grid every table benchmark runs on
+inline void shapes(benchmark::internal::Benchmark *b) {
+  b->ArgsProduct({{1 << 12, 1 << 15, 1 << 18}, {4, 32}})->ArgNames({"rows", "cols"});
+}
+
+template <utl::NumericType T>
+void set_throughput(benchmark::State &state) {
+  auto n_rows = state.range(0);
+  auto n_cols = state.range(1);
+  state.SetItemsProcessed(state.iterations() * n_rows);
+  state.SetBytesProcessed(state.iterations() * n_rows * n_cols *
+                          static_cast<int64_t>(sizeof(T)));
+}
+
+template <utl::NumericType T>
+torch::Tensor random_tensor(int64_t n_rows, int64_t n_cols) {
+  torch::manual_seed(SEED);
+  auto options = torch::TensorOptions().dtype(utl::torch_type<T>());
+  if constexpr (std::is_floating_point_v<T>)
+    return torch::rand({n_rows, n_cols}, options);
+  else
+    return torch::randint(0, 1000, {n_rows, n_cols}, options);
+}
+
+template <utl::NumericType T>
+ttb::TbNumeric<T> random_table(int64_t n_rows, int64_t n_cols) {
+  return ttb::Converter::analytic_table<T>(random_tensor<T>(n_rows, n_cols));
+}
+
+/// X of n_cols random features and a one-hot Y of N_CLASSES classes
+template <utl::NumericType T>
+ttb::XYMatrix random_xy(int64_t n_rows, int64_t n_cols) {
+  auto X = random_tensor<T>(n_rows, n_cols);
+  auto labels = torch::randint(0, N_CLASSES, {n_rows}, torch::kLong);
+  auto Y = torch::one_hot(labels, N_CLASSES).to(utl::torch_type<T>());
+  return ttb::XYMatrix{std::move(X), std::move(Y)};
+}
+
+/// Single int64 column of n_categories distinct values, in random order
+inline ttb::AnalyticTable categorical_table(int64_t n_rows, int64_t n_categories) {
+  torch::manual_seed(SEED);
+  auto codes = torch::randint(0, n_categories, {n_rows}, torch::kLong);
+  auto accessor = codes.accessor<int64_t, 1>();
+
+  arrow::Int64Builder builder;
+  if (!builder.Reserve(n_rows).ok())
+    throw std::runtime_error("Failed to reserve categorical column");
+  for (int64_t i{0}; i < n_rows; ++i)
+    builder.UnsafeAppend(accessor[i]);
+
+  auto column = builder.Finish().ValueOrDie();
+  return ttb::AnalyticTable{
+      arrow::Table::Make(arrow::schema({arrow::field("category", arrow::int64())}), {column})};
+}
+
+inline std::filesystem::path temp_path(const std::string &stem, const std::string &ext) {
+  auto base = std::filesystem::temp_directory_path() / "torchtb_bench";
+  std::filesystem::create_directories(base);
+  return base / (stem + "_" + std::to_string(::getpid()) + ext);
+}
+
+} // namespace bench
+
+/// Registers a benchmark template for every utl::NumericType, applying the given arguments
+// NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
+#define BENCHMARK_NUMERIC_TEMPLATES(fn, args)                                                      \
+  BENCHMARK_TEMPLATE(fn, int)->Apply(args);                                                        \
+  BENCHMARK_TEMPLATE(fn, int64_t)->Apply(args);                                                    \
+  BENCHMARK_TEMPLATE(fn, float)->Apply(args);                                                      \
+  BENCHMARK_TEMPLATE(fn, double)->Apply(args)
+
+#endif
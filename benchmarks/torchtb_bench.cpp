@@ -0,0 +1,17 @@
+#include <ATen/Parallel.h>
+#include <benchmark/benchmark.h>
+#include <string>
+
+/// Results are written as JSON with --benchmark_out=<file> --benchmark_out_format=json
+int main(int argc, char **argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    return 1;
+
+  benchmark::AddCustomContext("torchtb_version", TORCHTB_VERSION);
+  benchmark::AddCustomContext("torch_threads", std::to_string(at::get_num_threads()));
+
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -2,10 +2,13 @@
 #define ANALYTICTABLE_H
 #pragma once
 
+#include "ColumnSketch.h"
 #include "detail/utils.h"
 
+#include <arrow/compute/type_fwd.h>
 #include <arrow/type.h>
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <utility>
 
@@ -14,6 +17,32 @@ namespace ttb {
 enum class Axis { ROW = 0, COLUMN = 1 };
 
 enum class SortOrder { ASC = 0, DESC = 1 };
+
+/**
+ * @brief DEEP copies every buffer; COPY_ON_WRITE shares them in O(1). Arrow buffers are
+ * immutable and every AnalyticTable operation builds new ones, so shared buffers are only ever
+ * duplicated by the operations that actually modify them. Prefer DEEP when the table wraps
+ * memory that may change elsewhere (e.g. a tensor converted without copying)
+ *
+ */
+enum class CopyMode { DEEP = 0, COPY_ON_WRITE = 1 };
+
+enum class JoinType { INNER = 0, LEFT = 1 };
+
+/// Row kept among rows with equal keys
+enum class Keep { FIRST = 0, LAST = 1 };
+
+/**
+ * @brief BROADCAST builds a single hash table from the right table, for small dimension tables;
+ * PARTITIONED splits the build by key hash into partitions built in parallel. Both probe the
+ * left table in parallel. AUTO broadcasts right tables of up to BROADCAST_MAX_ROWS rows
+ *
+ */
+enum class JoinStrategy { AUTO = 0, BROADCAST = 1, PARTITIONED = 2 };
+
+class GroupBy;
+class HashingEncoder;
+
 /**
  * @brief Analytics Base Table (ABT), in the sense defined by Kelleher et al. in
  * "Fundamentals of Machine Learning for Predictive Data Analytics".
@@ -39,7 +68,8 @@ class AnalyticTable {
     void keep_cols(std::vector<int> indices);
     void append(const AnalyticTable &table, const ttb::Axis &axis);
     void rename_cols(const std::vector<std::string> &names);
-    void slice(int64_t row_offset, int64_t row_length);
+    void slice(int64_t row_offset, int64_t row_length,
+               ttb::CopyMode mode = ttb::CopyMode::COPY_ON_WRITE);
     void reorder_cols(const std::vector<int> &indices);
     void move_column(int from_index, int to_index);
     void sort(int col_index, ttb::SortOrder mode = ttb::SortOrder::ASC);
@@ -49,9 +79,23 @@ class AnalyticTable {
      * int values
      *
      * @param col_index Column to be one-hot encoded
+     * @param top_k When the column has more distinct values (as estimated by a ColumnSketch),
+     * only its top_k most frequent ones get a column, the others (and nulls) falling in a
+     * <name>_other column
      * @return utl::ReturnCode
      */
-    virtual void one_hot_expand(int col_index);
+    virtual void one_hot_expand(int col_index, std::optional<int> top_k = std::nullopt);
+
+    /**
+     * @brief Replaces a categorical column by the dense block of an encoder, one int column per
+     * bucket named <name>_0 ..., whatever the number of categories
+     *
+     */
+    virtual void hash_expand(int col_index, const ttb::HashingEncoder &encoder);
+
+    /// Distinct count and most frequent values of a column, fitted in one parallel pass
+    [[nodiscard]] ttb::ColumnSketch sketch(int col_index,
+                                           int top_k = ttb::ColumnSketch::DEFAULT_TOP_K) const;
 
     /**
      * @brief Extracts the specified column from this table
@@ -70,16 +114,85 @@ class AnalyticTable {
     ttb::AnalyticTable right_extract_of(int col_index);
 
     /**
-     * @brief Returns a row-wise portion of this table
+     * @brief Returns a row-wise portion of this table, by default a zero-copy view whose columns
+     * may span several chunks
      *
      * @param row_offset Starting row index (inclusive)
      * @param row_length Number of rows to slice (final_index=row_offset + row_length)
+     * @param mode DEEP copies the rows into one contiguous chunk per column
      * @return std::expected<ttb::DataTable, utl::ReturnCode>
      */
-    [[nodiscard]] ttb::AnalyticTable sliced(int64_t row_offset, int64_t row_length) const;
+    [[nodiscard]] ttb::AnalyticTable
+    sliced(int64_t row_offset, int64_t row_length,
+           ttb::CopyMode mode = ttb::CopyMode::COPY_ON_WRITE) const;
+
+    /**
+     * @brief Splits the rows into n_parts consecutive slices at once, the first n_rows % n_parts
+     * of them one row longer
+     *
+     */
+    [[nodiscard]] std::vector<ttb::AnalyticTable>
+    split_rows(int n_parts, ttb::CopyMode mode = ttb::CopyMode::COPY_ON_WRITE) const;
+
+    /// Concatenates the chunks of every multi-chunk column, for consumers needing contiguous data
+    void combine_chunks();
     [[nodiscard]] ttb::AnalyticTable copy_cols(std::vector<int> indices) const;
 
-    [[nodiscard]] ttb::AnalyticTable clone() const;
+    /**
+     * @brief Rows for which a boolean Arrow compute expression holds, e.g.
+     * and_(greater(field_ref("age"), literal(18)), not_(is_null(field_ref("label")))). The
+     * expression is evaluated on every chunk in parallel; rows where it is null are dropped
+     *
+     */
+    [[nodiscard]] ttb::AnalyticTable filtered(const arrow::compute::Expression &predicate) const;
+    /// When at most FILTER_MAX_SLICES runs of rows are kept, they are kept as zero-copy slices
+    void filter(const arrow::compute::Expression &predicate);
+
+    static constexpr int64_t FILTER_MAX_SLICES{64};
+
+    /// Drops the rows with a null in any of the given columns, all of them by default
+    void drop_nulls(const std::vector<std::string> &col_names = {});
+
+    /**
+     * @brief Selection bitmap keeping one row, the first or last, of every distinct combination of
+     * values of the key columns (all of them by default); nulls equal nulls, and values compare
+     * bytewise (-0.0 differs from 0.0). Rows are hash partitioned and every partition is
+     * deduplicated in parallel, without sorting. When the table is still sorted by sort() on the
+     * only key, not a floating point one, duplicates are adjacent and only neighbours are compared
+     *
+     */
+    [[nodiscard]] utl::shp<arrow::BooleanArray>
+    unique_rows(const std::vector<std::string> &keys = {}, ttb::Keep keep = ttb::Keep::FIRST) const;
+    [[nodiscard]] ttb::AnalyticTable deduplicated(const std::vector<std::string> &keys = {},
+                                                  ttb::Keep keep = ttb::Keep::FIRST) const;
+    /// Rows keep their order; few dropped rows leave zero-copy slices as in filter()
+    void drop_duplicates(const std::vector<std::string> &keys = {},
+                         ttb::Keep keep = ttb::Keep::FIRST);
+
+    /**
+     * @brief Hash join on equal values of the key columns, which must exist with the same types
+     * in both tables (a dictionary key matching plain keys of its values). Rows keep the order of
+     * this table, followed by their matches in the order of the right table. Null keys never
+     * match; a LEFT join fills the right columns of unmatched rows with nulls
+     *
+     * @param right Table whose non-key columns are appended, suffixed by "_right" on name clashes
+     * @param keys Names of the key columns
+     * @return ttb::AnalyticTable Key and other columns of this table, then right non-key columns
+     */
+    [[nodiscard]] ttb::AnalyticTable
+    joined(const AnalyticTable &right, const std::vector<std::string> &keys,
+           ttb::JoinType type = ttb::JoinType::INNER,
+           ttb::JoinStrategy strategy = ttb::JoinStrategy::AUTO) const;
+    void join(const AnalyticTable &right, const std::vector<std::string> &keys,
+              ttb::JoinType type = ttb::JoinType::INNER,
+              ttb::JoinStrategy strategy = ttb::JoinStrategy::AUTO);
+
+    static constexpr int64_t BROADCAST_MAX_ROWS{1 << 20};
+
+    /// Groups rows by the key columns, to be aggregated with GroupBy::agg
+    [[nodiscard]] ttb::GroupBy group_by(const std::vector<std::string> &keys) const;
+
+    [[nodiscard]] ttb::AnalyticTable clone(ttb::CopyMode mode = ttb::CopyMode::DEEP) const;
 
     void print_head(int64_t n_rows = 20) const;
     void print_tail(int64_t n_rows = 20) const;
@@ -91,6 +204,8 @@ class AnalyticTable {
     AnalyticTable() = default;
 
     utl::shp<arrow::Table> _arrow_tb{nullptr};
+    /// Column the rows were last sorted on by sort(), as long as the table still holds it
+    utl::wkp<arrow::ChunkedArray> _sorted_column;
 
     void bottom_append(const AnalyticTable &table);
     void right_append(const AnalyticTable &table);
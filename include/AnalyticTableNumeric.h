@@ -3,10 +3,19 @@
 #pragma once
 
 #include "AnalyticTable.h"
+#include "Binner.h"
 #include "detail/utils.h"
 
 namespace ttb {
 
+/**
+ * @brief Replacement of nulls: a CONSTANT value, the MEAN or MEDIAN of the non-null values of the
+ * column (rounded for integer types), or the previous non-null value (FORWARD). The constant is
+ * also used for leading nulls of FORWARD and for columns without any value
+ *
+ */
+enum class FillStrategy { CONSTANT = 0, MEAN = 1, MEDIAN = 2, FORWARD = 3 };
+
 template <utl::NumericType T>
 class AnalyticTableNumeric : public ttb::AnalyticTable {
   public:
@@ -28,7 +37,8 @@ class AnalyticTableNumeric : public ttb::AnalyticTable {
 
     AnalyticTableNumeric(std::unordered_map<std::string, std::vector<T>> &&field_and_data);
 
-    void one_hot_expand(int col_index) override;
+    void one_hot_expand(int col_index, std::optional<int> top_k = std::nullopt) override;
+    void hash_expand(int col_index, const ttb::HashingEncoder &encoder) override;
 
     /**
      * @brief Finds the index of the max value in specified axis
@@ -38,6 +48,18 @@ class AnalyticTableNumeric : public ttb::AnalyticTable {
      */
     [[nodiscard]] std::vector<int64_t> argmax(ttb::Axis axis) const;
 
+    /// Replaces the nulls of every column, columns being filled in parallel
+    void fill_nulls(ttb::FillStrategy strategy, T value = T{});
+
+    /// Value replacing the nulls of a column under a CONSTANT, MEAN or MEDIAN strategy
+    [[nodiscard]] T null_fill(int col_index, ttb::FillStrategy strategy, T value = T{}) const;
+
+    /// Binner of the given kind fitted on a column in one pass, nulls skipped
+    [[nodiscard]] ttb::Binner fit_binner(int col_index, ttb::Binning binning, int n_bins) const;
+
+    /// Replaces the values of a column by their bin indices, nulls staying null
+    void bin(int col_index, const ttb::Binner &binner);
+
     static utl::shp<arrow::Table>
     make_numeric_table(std::unordered_map<std::string, std::vector<T>> &&field_and_data);
 
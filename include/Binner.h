@@ -0,0 +1,89 @@
+#ifndef BINNER_H
+#define BINNER_H
+#pragma once
+
+#include "detail/kll_sketch.h"
+#include "detail/utils.h"
+
+#include <arrow/chunked_array.h>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace ttb {
+
+/**
+ * @brief EQUAL_WIDTH splits [min, max] into bins of the same width; QUANTILE places edges at
+ * approximate quantiles from a KLL sketch, so bins hold about the same number of values; CUSTOM
+ * takes the edges as given
+ *
+ */
+enum class Binning { EQUAL_WIDTH = 0, QUANTILE = 1, CUSTOM = 2 };
+
+/**
+ * @brief Discretizes values into bins fitted in a single pass, in parallel within each batch and
+ * across any number of batches (e.g. read one at a time from a stream). Values below the first
+ * edge fall in the first bin and values above the last edge in the last one
+ *
+ */
+class Binner {
+  public:
+    Binner() = delete;
+    Binner(const Binner &) = default;
+    Binner(Binner &&) = default;
+    Binner &operator=(const Binner &) = default;
+    Binner &operator=(Binner &&) = default;
+    ~Binner() = default;
+
+    Binner(ttb::Binning binning, int n_bins, int sketch_k = utl::KllSketch::DEFAULT_K);
+
+    /// CUSTOM binning over at least two ascending edges
+    explicit Binner(std::vector<double> edges);
+
+    /// Fits a batch of values, NaNs skipped, reading every stride-th value
+    template <utl::NumericType T>
+    void update(const T *values, int64_t n_values, int64_t stride = 1);
+
+    /// Fits a numeric column, nulls skipped
+    void update(const arrow::ChunkedArray &values);
+
+    [[nodiscard]] ttb::Binning binning() const { return _binning; }
+    [[nodiscard]] int n_bins() const { return _n_bins; }
+    [[nodiscard]] int64_t count() const { return _count; }
+
+    /// The n_bins + 1 ascending edges fitted so far
+    [[nodiscard]] std::vector<double> edges() const;
+
+    /**
+     * @brief Writes the bin index of every value into bins (which may be values itself), with a
+     * branch-free search over the edges, in parallel. NaNs fall in the first bin
+     *
+     */
+    template <utl::NumericType T>
+    void transform(const T *values, T *bins, int64_t n_values, int64_t stride = 1) const;
+
+    /// Number of values in every bin, NaNs skipped
+    template <utl::NumericType T>
+    [[nodiscard]] std::vector<int64_t> histogram(const T *values, int64_t n_values,
+                                                 int64_t stride = 1) const;
+
+  private:
+    ttb::Binning _binning;
+    int _n_bins;
+    int _sketch_k{utl::KllSketch::DEFAULT_K};
+    std::vector<double> _edges;
+    int64_t _count{0};
+    double _min{std::numeric_limits<double>::infinity()};
+    double _max{-std::numeric_limits<double>::infinity()};
+    /// Only fed by QUANTILE binners
+    utl::KllSketch _sketch;
+};
+
+class BinnerError : public std::runtime_error {
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+} // namespace ttb
+#endif
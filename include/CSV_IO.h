@@ -6,28 +6,115 @@
 #include "detail/utils.h"
 
 #include <arrow/table.h>
+#include <arrow/util/type_fwd.h>
 #include <filesystem>
+#include <optional>
+#include <string>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #pragma once
 
 namespace ttb {
 
+struct CSVOptions {
+    /// Explicit types of some columns, which are not type-inferred
+    std::unordered_map<std::string, utl::shp<arrow::DataType>> column_types{};
+
+    /// Type of the columns absent from column_types; if set, no column is type-inferred
+    utl::shp<arrow::DataType> default_column_type{nullptr};
+
+    /// Whether read_numeric<T> parses the columns absent from column_types straight as T (unless
+    /// default_column_type is set), skipping inference. Values that are not valid T, such as
+    /// decimals or booleans read as int, then fail the read instead of being cast
+    bool parse_numeric_directly{false};
+
+    /// Columns to be parsed, in this order (all columns if empty)
+    std::vector<std::string> include_columns{};
+
+    /// Spellings of null values (arrow defaults if empty)
+    std::vector<std::string> null_values{};
+
+    /// Bytes read per block, the unit of parsing parallelism
+    int32_t block_size{1 << 20};
+
+    /// Whether blocks are parsed (by arrow's CPU thread pool) and formatted in parallel
+    bool use_threads{true};
+
+    /// Size of a thread pool dedicated to the reads of this object, if positive and no
+    /// io_executor is given (arrow's shared I/O pool otherwise)
+    int io_threads{0};
+
+    /// Executor for I/O tasks, owned by the caller
+    arrow::internal::Executor *io_executor{nullptr};
+
+    /// Rows formatted per block when writing
+    int64_t batch_size{1 << 16};
+
+    /// Digits after the decimal point of written floating point values, in fixed notation
+    /// (shortest round-trip representation if unset)
+    std::optional<int> float_precision{};
+
+    /// Compression of read and written files; if unset, inferred from the .gz, .zst, .bz2 or .lz4
+    /// extensions (and, when reading, from the leading magic bytes)
+    std::optional<arrow::Compression::type> compression{};
+};
+
+struct CSVReadStats {
+    /// Size of the file on disk, compressed if the file is
+    int64_t n_bytes{0};
+    int64_t n_rows{0};
+    double seconds{0.0};
+
+    [[nodiscard]] double mb_per_second() const {
+      return seconds > 0.0 ? static_cast<double>(n_bytes) / (1 << 20) / seconds : 0.0;
+    }
+};
+
 class CSV_IO {
   public:
-    CSV_IO(std::filesystem::path path, bool has_header = true)
-        : _path{std::move(path)}, _has_header{has_header} {};
+    CSV_IO(std::filesystem::path path, bool has_header = true, CSVOptions options = {})
+        : _path{std::move(path)}, _has_header{has_header}, _options{std::move(options)} {};
 
-    [[nodiscard]] ttb::AnalyticTable read(char separator = ',') const;
+    /// stats, if given, receives the size, rows and parsing throughput of the read
+    [[nodiscard]] ttb::AnalyticTable read(char separator = ',',
+                                          ttb::CSVReadStats *stats = nullptr) const;
 
+    /**
+     * @brief Reads the file and casts every column to T, inferred types being truncated (e.g.
+     * decimals or booleans to int). With CSVOptions::parse_numeric_directly, columns not in
+     * CSVOptions::column_types are parsed directly as T instead, skipping type inference
+     *
+     * @param separator Field delimiter
+     * @param stats If given, receives the size, rows and parsing throughput of the read
+     * @return ttb::AnalyticTableNumeric<T>
+     */
     template <utl::NumericType T>
-    ttb::AnalyticTableNumeric<T> read_numeric(char separator = ',') const;
+    ttb::AnalyticTableNumeric<T> read_numeric(char separator = ',',
+                                              ttb::CSVReadStats *stats = nullptr) const;
 
+    /**
+     * @brief Writes the table, formatting blocks of CSVOptions::batch_size rows in parallel while
+     * previously formatted blocks are written (and compressed) in order
+     *
+     * @param table Table to be written
+     * @param separator Field delimiter
+     */
     void write(const ttb::AnalyticTable &table, char separator = ',') const;
 
+    /**
+     * @brief Sets the capacity of arrow's CPU thread pool, which parses the blocks of every read.
+     * The pool is shared by the whole process (and other arrow users), so this is meant to be
+     * called once, at startup
+     *
+     */
+    static void set_cpu_threads(int n_threads);
+
   private:
     std::filesystem::path _path;
     bool _has_header;
+    CSVOptions _options;
 };
 
 class CSV_IOError : public std::runtime_error {
@@ -0,0 +1,100 @@
+#ifndef CATEGORYENCODER_H
+#define CATEGORYENCODER_H
+#pragma once
+
+#include "AnalyticTable.h"
+#include "detail/utils.h"
+
+#include <arrow/array.h>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ttb {
+
+/**
+ * @brief MEAN_TARGET replaces a category by the mean target of its rows, smoothed towards the
+ * mean target of all rows (the prior); FREQUENCY by the share of rows holding it
+ *
+ */
+enum class CategoryEncoding { MEAN_TARGET = 0, FREQUENCY = 1 };
+
+/**
+ * @brief Replaces a categorical column by a float64 column <name>_mean_target or <name>_frequency.
+ * Statistics come from the training rows only, either the leading rows XYMatrix::split() keeps
+ * for training or explicit row indices, and are aggregated per category with a parallel hash
+ * group by. Training rows get
+ * out-of-fold MEAN_TARGET values (row i being in fold i % n_folds), so that no row sees its own
+ * target; eval rows get the values fitted on all training rows. The fitted mapping is kept to
+ * encode new data at inference, unseen categories getting the prior (MEAN_TARGET) or 0
+ *
+ */
+class CategoryEncoder {
+  public:
+    CategoryEncoder(const CategoryEncoder &) = default;
+    CategoryEncoder(CategoryEncoder &&) = default;
+    CategoryEncoder &operator=(const CategoryEncoder &) = default;
+    CategoryEncoder &operator=(CategoryEncoder &&) = default;
+    ~CategoryEncoder() = default;
+
+    static constexpr int DEFAULT_N_FOLDS{5};
+    static constexpr double DEFAULT_SMOOTHING{10.0};
+
+    /// smoothing is the weight of the prior, in rows
+    explicit CategoryEncoder(ttb::CategoryEncoding encoding = ttb::CategoryEncoding::MEAN_TARGET,
+                             int n_folds = DEFAULT_N_FOLDS, double smoothing = DEFAULT_SMOOTHING);
+
+    /// Encoder restoring a stored mapping(), for inference
+    CategoryEncoder(ttb::CategoryEncoding encoding, const ttb::AnalyticTable &mapping,
+                    double unseen_value);
+
+    /**
+     * @brief Fits the encoding of a column and replaces it in place
+     *
+     * @param target Numeric target column (unused by FREQUENCY); rows with a null target are
+     * encoded but not fitted on
+     * @param pct_eval Percentage of trailing rows that XYMatrix::split() will hold out for eval
+     */
+    void fit_transform(ttb::AnalyticTable &table, const std::string &col, const std::string &target,
+                       int pct_eval = 0);
+
+    /**
+     * @brief Fits the encoding of a column on the given training rows and replaces it in place,
+     * for splits other than the leading rows, e.g. shuffled or stratified ones
+     *
+     * @param target Numeric target column (unused by FREQUENCY); rows with a null target are
+     * encoded but not fitted on
+     * @param train_rows Indices of the training rows, in any order (duplicates count once); all
+     * other rows are encoded as eval rows
+     */
+    void fit_transform(ttb::AnalyticTable &table, const std::string &col, const std::string &target,
+                       const std::vector<int64_t> &train_rows);
+
+    /// Replaces a column by its fitted encoding
+    void transform(ttb::AnalyticTable &table, const std::string &col) const;
+
+    [[nodiscard]] ttb::CategoryEncoding encoding() const { return _encoding; }
+    [[nodiscard]] double unseen_value() const { return _unseen_value; }
+
+    /// The fitted categories (column "category") and their values (column "encoding")
+    [[nodiscard]] ttb::AnalyticTable mapping() const;
+
+  private:
+    ttb::CategoryEncoding _encoding;
+    int _n_folds{DEFAULT_N_FOLDS};
+    double _smoothing{DEFAULT_SMOOTHING};
+    utl::shp<arrow::Array> _categories;
+    std::vector<double> _encodings;
+    double _unseen_value{0.0};
+
+    [[nodiscard]] std::string encoded_name(const std::string &col) const;
+};
+
+class CategoryEncoderError : public std::runtime_error {
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+} // namespace ttb
+#endif
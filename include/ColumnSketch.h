@@ -0,0 +1,94 @@
+#ifndef COLUMNSKETCH_H
+#define COLUMNSKETCH_H
+#pragma once
+
+#include "detail/hll_sketch.h"
+#include "detail/row_keys.h"
+#include "detail/top_k_sketch.h"
+#include "detail/utils.h"
+
+#include <arrow/array.h>
+#include <arrow/chunked_array.h>
+#include <arrow/scalar.h>
+#include <cstdint>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace ttb {
+
+/// A frequent value of a column: it occurred between count - error and count times
+struct HeavyHitter {
+    utl::shp<arrow::Scalar> value;
+    int64_t count;
+    int64_t error;
+};
+
+/**
+ * @brief Bounded-memory summary of the values of a column, to decide how to encode it without
+ * materializing its distinct values: a HyperLogLog distinct count, plus the most frequent values
+ * from a SpaceSaving summary whose counts are tightened by a Count-Min sketch. Values are
+ * identified by the 64-bit hashes of utl::RowKeys. Fitted in one parallel pass per batch; sketches
+ * of several batches or tables merge into the sketch of their union
+ *
+ */
+class ColumnSketch {
+  public:
+    ColumnSketch(const ColumnSketch &) = default;
+    ColumnSketch(ColumnSketch &&) = default;
+    ColumnSketch &operator=(const ColumnSketch &) = default;
+    ColumnSketch &operator=(ColumnSketch &&) = default;
+    ~ColumnSketch() = default;
+
+    static constexpr int DEFAULT_TOP_K{20};
+    /// SpaceSaving counters kept per reported value, bounding count errors by rows / (8 top_k)
+    static constexpr int COUNTERS_PER_VALUE{8};
+
+    explicit ColumnSketch(int top_k = DEFAULT_TOP_K,
+                          int precision = utl::HllSketch::DEFAULT_PRECISION);
+
+    /// Fits a batch of values, nulls counted apart. Every batch must have the same type, dictionary
+    /// batches being sketched (and reported) as their decoded values
+    void update(const utl::shp<arrow::Array> &values);
+    void update(const arrow::ChunkedArray &values);
+    void merge(const ColumnSketch &other);
+
+    [[nodiscard]] int top_k() const { return _top_k; }
+    [[nodiscard]] int64_t count() const { return _count; }
+    [[nodiscard]] int64_t null_count() const { return _null_count; }
+
+    /// Approximate number of distinct non-null values
+    [[nodiscard]] int64_t distinct_count() const;
+
+    /// Upper bound of the number of occurrences of a value of the sketched type
+    [[nodiscard]] int64_t frequency(const arrow::Scalar &value) const;
+
+    /// Up to top_k most frequent values, most frequent first
+    [[nodiscard]] std::vector<ttb::HeavyHitter> heavy_hitters() const;
+
+    /// Values of heavy_hitters() as an array of the sketched type, e.g. as a compute value set
+    [[nodiscard]] utl::shp<arrow::Array> heavy_hitter_values() const;
+
+  private:
+    int _top_k;
+    int64_t _count{0};
+    int64_t _null_count{0};
+    utl::shp<arrow::DataType> _type;
+    utl::HllSketch _distinct;
+    utl::CountMinSketch _frequencies;
+    utl::SpaceSaving _heavy_hitters;
+    /// Values of the keys tracked by _heavy_hitters
+    std::unordered_map<uint64_t, utl::shp<arrow::Scalar>> _values;
+
+    void update_rows(const arrow::Array &values, const utl::RowKeys &keys, int64_t begin,
+                     int64_t end);
+    void drop_untracked_values();
+};
+
+class ColumnSketchError : public std::runtime_error {
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+} // namespace ttb
+#endif
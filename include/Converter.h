@@ -8,6 +8,7 @@
 #include <torch/data/dataloader_options.h>
 
 #include "Parquet_IO.h"
+#include "XYMatrix.h"
 #include <ATen/core/TensorBody.h>
 #include <arrow/array/array_base.h>
 #include <torch/data/dataloader.h>
@@ -26,14 +27,47 @@ class Converter {
     template <utl::NumericType T>
     static torch::Tensor torch_tensor(ttb::AnalyticTableNumeric<T> &&data);
 
+    /**
+     * @brief Converts a table whose columns may hold nulls, writing the fill value of each column
+     * into its null slots during the copy rather than materializing a filled table first
+     *
+     * @param strategy How nulls are replaced, see ttb::FillStrategy
+     * @param value Constant fill, also used for leading nulls of FORWARD and empty columns
+     */
+    template <utl::NumericType T>
+    static torch::Tensor torch_tensor(ttb::AnalyticTableNumeric<T> &&data,
+                                      ttb::FillStrategy strategy, T value = T{});
+
+    /// Boolean [n_rows, n_cols] tensor, true where the table holds a value and false on nulls
+    static torch::Tensor validity_mask(const ttb::AnalyticTable &data);
+
     template <utl::NumericType T>
     static torch::Tensor torch_tensor(ttb::CSV_IO &&reader);
 
     template <utl::NumericType T>
     static torch::Tensor torch_tensor(ttb::Parquet_IO &&reader);
 
+    /**
+     * @brief Converts a second order CPU tensor into a numeric table, one column per tensor
+     * column. Column-major tensors (e.g. transposed contiguous ones) are wrapped without copying
+     * and the resulting table keeps their storage alive; other layouts are transposed in parallel
+     * into arrow buffers.
+     *
+     * @param tensor Tensor to be converted
+     * @return ttb::AnalyticTableNumeric<T> Table with columns named col_1 ... col_n
+     */
     template <utl::NumericType T>
     static ttb::AnalyticTableNumeric<T> analytic_table(torch::Tensor &&tensor);
+
+    /**
+     * @brief Converts the X and Y columns of the matrix, side by side, into a numeric table
+     * without concatenating them into a single tensor
+     *
+     * @param xy_matrix Matrix to be converted
+     * @return ttb::AnalyticTableNumeric<T> Table with columns named col_1 ... col_n, X first
+     */
+    template <utl::NumericType T>
+    static ttb::AnalyticTableNumeric<T> analytic_table(ttb::XYMatrix &&xy_matrix);
 };
 
 class ConverterError : public std::runtime_error {
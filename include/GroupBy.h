@@ -0,0 +1,89 @@
+#ifndef GROUPBY_H
+#define GROUPBY_H
+#pragma once
+
+#include "AnalyticTable.h"
+#include "detail/row_keys.h"
+
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ttb {
+
+enum class Aggregation {
+  SUM = 0,
+  MEAN = 1,
+  MIN = 2,
+  MAX = 3,
+  COUNT = 4,
+  COUNT_DISTINCT = 5,
+  STD = 6
+};
+
+/**
+ * @brief One output column of GroupBy::agg. COUNT and COUNT_DISTINCT take any key-able column and
+ * give int64; the others take numeric columns and give float64. Nulls are skipped; groups without
+ * values get a null (SUM gives 0), as does STD (sample, ddof 1) for groups of a single value
+ *
+ */
+struct Aggregate {
+    std::string column;
+    ttb::Aggregation aggregation;
+    /// Defaults to <column>_<aggregation>, e.g. amount_sum
+    std::optional<std::string> name{};
+};
+
+/**
+ * @brief Rows of a table grouped by equal values of the key columns (nulls form their own group),
+ * in order of first appearance. Rows are hash partitioned once, at construction, and each
+ * aggregation then runs on every partition in parallel
+ *
+ */
+class GroupBy {
+  public:
+    GroupBy() = delete;
+    GroupBy(const GroupBy &) = delete;
+    GroupBy(GroupBy &&) = default;
+    GroupBy &operator=(const GroupBy &) = delete;
+    GroupBy &operator=(GroupBy &&) = default;
+    ~GroupBy() = default;
+
+    GroupBy(const ttb::AnalyticTable &table, const std::vector<std::string> &keys);
+
+    [[nodiscard]] int64_t n_groups() const { return static_cast<int64_t>(_group_rows.size()); }
+
+    /// Key columns, one row per group, followed by one column per aggregate
+    [[nodiscard]] ttb::AnalyticTable agg(const std::vector<ttb::Aggregate> &aggregates) const;
+
+    /// Group of every row
+    [[nodiscard]] const std::vector<int64_t> &row_groups() const { return _row_groups; }
+    /// First row of every group
+    [[nodiscard]] const std::vector<int64_t> &group_rows() const { return _group_rows; }
+
+    /// Rows of every hash partition; one task per partition may update per-group state unlocked
+    [[nodiscard]] const std::vector<std::vector<int64_t>> &partition_rows() const {
+      return _partition_rows;
+    }
+
+  private:
+    utl::shp<arrow::Table> _arrow_tb;
+    std::vector<int> _key_indices;
+    /// Group of every row
+    std::vector<int64_t> _row_groups;
+    /// First row of every group
+    std::vector<int64_t> _group_rows;
+    /// Rows of every hash partition, ascending; partitions hold disjoint groups
+    std::vector<std::vector<int64_t>> _partition_rows;
+
+    void assign_groups(const utl::RowKeys &keys);
+};
+
+class GroupByError : public std::runtime_error {
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+} // namespace ttb
+#endif
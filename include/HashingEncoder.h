@@ -0,0 +1,74 @@
+#ifndef HASHINGENCODER_H
+#define HASHINGENCODER_H
+#pragma once
+
+#include "AnalyticTableNumeric.h"
+#include "detail/utils.h"
+
+#include <ATen/core/TensorBody.h>
+#include <arrow/chunked_array.h>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+namespace ttb {
+
+/**
+ * @brief Hashing trick (Weinberger et al., "Feature Hashing for Large Scale Multitask
+ * Learning"): maps the values of a string, binary, integer or dictionary column into n_buckets
+ * buckets, so memory is bounded by the bucket count rather than the category count. Strings are
+ * hashed straight from the offsets and data buffers of the chunks, in parallel, by the CRC32C
+ * string kernels. Hashes do not depend on the run, platform or instruction set, so an encoder
+ * rebuilt from the same parameters encodes the same way at inference. Signed hashing gives every
+ * value a +1/-1 sign from an independent hash bit, so that colliding values tend to cancel out
+ * instead of adding up
+ *
+ */
+class HashingEncoder {
+  public:
+    HashingEncoder() = delete;
+    HashingEncoder(const HashingEncoder &) = default;
+    HashingEncoder(HashingEncoder &&) = default;
+    HashingEncoder &operator=(const HashingEncoder &) = default;
+    HashingEncoder &operator=(HashingEncoder &&) = default;
+    ~HashingEncoder() = default;
+
+    explicit HashingEncoder(int64_t n_buckets, bool signed_hashing = false, uint64_t seed = 0);
+
+    [[nodiscard]] int64_t n_buckets() const { return _n_buckets; }
+    [[nodiscard]] bool signed_hashing() const { return _signed_hashing; }
+    [[nodiscard]] uint64_t seed() const { return _seed; }
+
+    /// Bucket of every value as an int64 column, e.g. indices of an embedding; nulls stay null
+    [[nodiscard]] utl::shp<arrow::ChunkedArray> buckets(const arrow::ChunkedArray &values) const;
+
+    /**
+     * @brief Dense block of n_buckets columns named <prefix>0 ... holding, for every row, the
+     * sign of its value (1 without signed hashing) in the bucket of the value and 0 elsewhere.
+     * Null rows are all zeros
+     *
+     */
+    template <utl::NumericType T>
+    [[nodiscard]] ttb::AnalyticTableNumeric<T> dense(const arrow::ChunkedArray &values,
+                                                     const std::string &prefix) const;
+
+    /// The dense block as a sparse COO [n_rows, n_buckets] tensor, one entry per non-null row
+    template <utl::NumericType T>
+    [[nodiscard]] torch::Tensor sparse(const arrow::ChunkedArray &values) const;
+
+  private:
+    int64_t _n_buckets;
+    bool _signed_hashing;
+    uint64_t _seed;
+
+    /// Writes the bucket (-1 for nulls) and, when signs is not null, the sign of every value
+    void encode(const arrow::Array &values, int64_t *buckets, int8_t *signs) const;
+};
+
+class HashingEncoderError : public std::runtime_error {
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+} // namespace ttb
+#endif
@@ -0,0 +1,56 @@
+#ifndef IPC_IO_H
+#define IPC_IO_H
+#include "XYMatrix.h"
+#pragma once
+
+#include "AnalyticTable.h"
+#include "AnalyticTableNumeric.h"
+
+#include "detail/utils.h"
+#include <ATen/core/TensorBody.h>
+#include <filesystem>
+
+#include <arrow/util/type_fwd.h>
+
+namespace ttb {
+
+/**
+ * @brief Reads and writes tables in the Arrow IPC file format (Feather v2). Reads are memory
+ * mapped, so uncompressed files are loaded without copying their buffers.
+ *
+ */
+class IPC_IO {
+  public:
+    /**
+     * @param path File path
+     * @param compression Buffer compression used on writing: UNCOMPRESSED, LZ4_FRAME or ZSTD
+     */
+    IPC_IO(std::filesystem::path path,
+           arrow::Compression::type compression = arrow::Compression::UNCOMPRESSED)
+        : _path{std::move(path)}, _compression{compression} {};
+
+    [[nodiscard]] ttb::AnalyticTable read() const;
+
+    template <utl::NumericType T>
+    [[nodiscard]] ttb::AnalyticTableNumeric<T> read_numeric() const;
+
+    void write(const ttb::AnalyticTable &table) const;
+
+    template <utl::NumericType T>
+    void write(torch::Tensor &&tensor) const;
+
+    template <utl::NumericType T>
+    void write(ttb::XYMatrix &&xy_matrix) const;
+
+  private:
+    std::filesystem::path _path;
+    arrow::Compression::type _compression;
+};
+
+class IPC_IOError : public std::runtime_error {
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+} // namespace ttb
+#endif
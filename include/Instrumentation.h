@@ -0,0 +1,120 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ttb {
+
+/// One timed scope, as recorded by ScopedTimer
+struct TimedEvent {
+    const char *name;
+    uint32_t thread;
+    int64_t start_ns;
+    int64_t duration_ns;
+    int64_t n_rows;
+    int64_t n_bytes;
+};
+
+/// Timed scopes of the same name aggregated across all threads
+struct TimedSummary {
+    std::string name;
+    int64_t calls{0};
+    double seconds{0.0};
+    double max_seconds{0.0};
+    int64_t n_rows{0};
+    int64_t n_bytes{0};
+};
+
+/**
+ * @brief Records the wall time of the enclosing scope, plus the rows and bytes it reports, in a
+ * buffer owned by the calling thread. Use it through the TTB_TIMED_SCOPE macros, which compile
+ * to nothing unless the library is built with TORCHTB_INSTRUMENTATION
+ *
+ */
+class ScopedTimer {
+  public:
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer(ScopedTimer &&) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(ScopedTimer &&) = delete;
+
+    explicit ScopedTimer(const char *name)
+        : _name{name}, _start{std::chrono::steady_clock::now()} {};
+    ~ScopedTimer();
+
+    void add_rows(int64_t n_rows) { _n_rows += n_rows; }
+    void add_bytes(int64_t n_bytes) { _n_bytes += n_bytes; }
+
+  private:
+    const char *_name;
+    std::chrono::steady_clock::time_point _start;
+    int64_t _n_rows{0};
+    int64_t _n_bytes{0};
+};
+
+class Instrumentation {
+  public:
+    Instrumentation() = delete;
+    Instrumentation(const Instrumentation &) = delete;
+    Instrumentation(Instrumentation &&) = delete;
+    Instrumentation &operator=(const Instrumentation &) = delete;
+    Instrumentation &operator=(Instrumentation &&) = delete;
+    ~Instrumentation() = default;
+
+    /// Whether the library was built with TORCHTB_INSTRUMENTATION
+    static constexpr bool enabled() {
+#ifdef TORCHTB_INSTRUMENTATION
+      return true;
+#else
+      return false;
+#endif
+    }
+
+    /// Totals per scope name, sorted by descending time
+    [[nodiscard]] static std::vector<ttb::TimedSummary> summary();
+
+    /// Individual scopes, oldest first; each thread keeps its latest MAX_EVENTS_PER_THREAD
+    [[nodiscard]] static std::vector<ttb::TimedEvent> events();
+
+    [[nodiscard]] static std::string to_json();
+
+    /// Trace Event Format, loadable in chrome://tracing or Perfetto
+    [[nodiscard]] static std::string to_chrome_trace();
+
+    static void dump_json(const std::filesystem::path &path);
+    static void dump_chrome_trace(const std::filesystem::path &path);
+
+    static void reset();
+
+    static constexpr size_t MAX_EVENTS_PER_THREAD{1 << 16};
+};
+
+class InstrumentationError : public std::runtime_error {
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+} // namespace ttb
+
+#ifdef TORCHTB_INSTRUMENTATION
+// NOLINTBEGIN(cppcoreguidelines-macro-usage)
+#define TTB_TIMED_SCOPE(name) ttb::ScopedTimer ttb_scoped_timer_ { name }
+#define TTB_COUNT_ROWS(n_rows) ttb_scoped_timer_.add_rows(static_cast<int64_t>(n_rows))
+#define TTB_COUNT_BYTES(n_bytes) ttb_scoped_timer_.add_bytes(static_cast<int64_t>(n_bytes))
+// NOLINTEND(cppcoreguidelines-macro-usage)
+#else
+// NOLINTBEGIN(cppcoreguidelines-macro-usage)
+/// Counts stay unevaluated operands, so disabled counters cost nothing nor warn as unused
+#define TTB_TIMED_SCOPE(name) static_cast<void>(0)
+#define TTB_COUNT_ROWS(n_rows) static_cast<void>(sizeof(n_rows))
+#define TTB_COUNT_BYTES(n_bytes) static_cast<void>(sizeof(n_bytes))
+// NOLINTEND(cppcoreguidelines-macro-usage)
+#endif
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef MEMORYPOOL_H
+#define MEMORYPOOL_H
+#pragma once
+
+#include <array>
+#include <arrow/memory_pool.h>
+#include <arrow/status.h>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace ttb {
+
+/**
+ * @brief Pool every torchtb arrow allocation goes through: the innermost MemoryPoolScope of the
+ * calling thread, otherwise the global pool set by set_memory_pool, otherwise arrow's default
+ *
+ */
+[[nodiscard]] arrow::MemoryPool *memory_pool();
+
+/// Sets the global pool (not owned); nullptr restores arrow's default
+void set_memory_pool(arrow::MemoryPool *pool);
+
+/**
+ * @brief Routes torchtb calls made by this thread, while in scope, to the given pool (not owned)
+ *
+ */
+class MemoryPoolScope {
+  public:
+    MemoryPoolScope(const MemoryPoolScope &) = delete;
+    MemoryPoolScope(MemoryPoolScope &&) = delete;
+    MemoryPoolScope &operator=(const MemoryPoolScope &) = delete;
+    MemoryPoolScope &operator=(MemoryPoolScope &&) = delete;
+
+    explicit MemoryPoolScope(arrow::MemoryPool *pool);
+    ~MemoryPoolScope();
+
+  private:
+    arrow::MemoryPool *_previous;
+};
+
+/**
+ * @brief Pool that forwards to an upstream pool while accounting current and peak bytes, overall
+ * and per MemoryOperation, and refuses allocations over an optional budget with an OutOfMemory
+ * status (see throw_if_budget_exceeded). It must outlive every buffer allocated from it.
+ * Allocations only update atomics; up to MAX_OPERATIONS operations are tracked at once
+ *
+ */
+class TrackingMemoryPool : public arrow::MemoryPool {
+  public:
+    TrackingMemoryPool(const TrackingMemoryPool &) = delete;
+    TrackingMemoryPool(TrackingMemoryPool &&) = delete;
+    TrackingMemoryPool &operator=(const TrackingMemoryPool &) = delete;
+    TrackingMemoryPool &operator=(TrackingMemoryPool &&) = delete;
+    ~TrackingMemoryPool() override = default;
+
+    /// Throws std::invalid_argument if upstream is null
+    explicit TrackingMemoryPool(std::optional<int64_t> limit = std::nullopt,
+                                arrow::MemoryPool *upstream = arrow::default_memory_pool());
+
+    /// Operations open at once beyond this number are not tracked
+    static constexpr int MAX_OPERATIONS{64};
+
+    using arrow::MemoryPool::Allocate;
+    using arrow::MemoryPool::Reallocate;
+    using arrow::MemoryPool::Free;
+
+    arrow::Status Allocate(int64_t size, int64_t alignment, uint8_t **out) override;
+    arrow::Status Reallocate(int64_t old_size, int64_t new_size, int64_t alignment,
+                             uint8_t **ptr) override;
+    void Free(uint8_t *buffer, int64_t size, int64_t alignment) override;
+    void ReleaseUnused() override { _upstream->ReleaseUnused(); }
+
+    [[nodiscard]] int64_t bytes_allocated() const override { return _current.load(); }
+    [[nodiscard]] int64_t max_memory() const override { return _peak.load(); }
+    [[nodiscard]] int64_t total_bytes_allocated() const override { return _total.load(); }
+    [[nodiscard]] int64_t num_allocations() const override { return _n_allocations.load(); }
+    [[nodiscard]] std::string backend_name() const override { return _upstream->backend_name(); }
+
+    [[nodiscard]] std::optional<int64_t> limit() const;
+    void set_limit(std::optional<int64_t> limit);
+
+    /// Highest growth above the usage at its start, per operation name, over all its runs
+    [[nodiscard]] std::unordered_map<std::string, int64_t> operation_peaks() const;
+
+    /// Restarts the overall peak from the current usage and forgets operation peaks
+    void reset_peaks();
+
+  private:
+    friend class MemoryOperation;
+
+    /// Usage at the start of an open operation and highest usage since
+    struct Operation {
+        std::string name;
+        int64_t baseline{0};
+        std::atomic<int64_t> high{0};
+    };
+
+    static constexpr int64_t NO_LIMIT{-1};
+    static constexpr int NO_OPERATION{-1};
+
+    arrow::MemoryPool *_upstream;
+    std::atomic<int64_t> _limit;
+    std::atomic<int64_t> _current{0};
+    std::atomic<int64_t> _peak{0};
+    std::atomic<int64_t> _total{0};
+    std::atomic<int64_t> _n_allocations{0};
+
+    /// Bit i of _claimed_operations marks _operations[i] as taken by a MemoryOperation, and bit
+    /// i of _open_operations as ready to be updated by allocations
+    std::array<Operation, MAX_OPERATIONS> _operations;
+    std::atomic<uint64_t> _claimed_operations{0};
+    std::atomic<uint64_t> _open_operations{0};
+
+    /// Guards _operation_peaks, which is only updated when an operation closes
+    mutable std::mutex _mutex;
+    std::unordered_map<std::string, int64_t> _operation_peaks;
+
+    arrow::Status reserve(int64_t n_bytes);
+    void release(int64_t n_bytes);
+    void track_operations(int64_t current);
+    int open_operation(const char *name);
+    void close_operation(int index);
+};
+
+/**
+ * @brief Attributes, while in scope, the peak usage of the current memory_pool() to a named
+ * operation; does nothing unless that pool is a TrackingMemoryPool
+ *
+ */
+class MemoryOperation {
+  public:
+    MemoryOperation(const MemoryOperation &) = delete;
+    MemoryOperation(MemoryOperation &&) = delete;
+    MemoryOperation &operator=(const MemoryOperation &) = delete;
+    MemoryOperation &operator=(MemoryOperation &&) = delete;
+
+    explicit MemoryOperation(const char *name);
+    ~MemoryOperation();
+
+  private:
+    ttb::TrackingMemoryPool *_pool{nullptr};
+    int _operation{ttb::TrackingMemoryPool::NO_OPERATION};
+};
+
+class MemoryBudgetError : public std::runtime_error {
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+/// Throws MemoryBudgetError if the status stems from a TrackingMemoryPool over its budget
+void throw_if_budget_exceeded(const arrow::Status &status);
+
+} // namespace ttb
+#endif
@@ -0,0 +1,42 @@
+#ifndef SNAPSHOT_IO_H
+#define SNAPSHOT_IO_H
+#pragma once
+
+#include "TrainingBundle.h"
+#include "XYMatrix.h"
+
+#include <filesystem>
+
+namespace ttb {
+
+/**
+ * @brief Native binary snapshots of XYMatrix and TrainingBundle objects.
+ *
+ * X and Y tensors are stored as separate raw blobs, aligned to page boundaries, after a small
+ * metadata header (shapes, dtypes and normalization statistics). Reading maps the file in
+ * private (copy-on-write) mode and the tensors are created with torch::from_blob over the mapped
+ * pages, so nothing is copied until a page is written to. Files are written in the host byte
+ * order.
+ *
+ */
+class Snapshot_IO {
+  public:
+    Snapshot_IO(std::filesystem::path path) : _path{std::move(path)} {};
+
+    void write(const ttb::XYMatrix &xy_matrix) const;
+    void write(const ttb::TrainingBundle &bundle) const;
+
+    [[nodiscard]] ttb::XYMatrix read_xy_matrix() const;
+    [[nodiscard]] ttb::TrainingBundle read_training_bundle() const;
+
+  private:
+    std::filesystem::path _path;
+};
+
+class Snapshot_IOError : public std::runtime_error {
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+} // namespace ttb
+#endif
@@ -0,0 +1,80 @@
+#ifndef TENSORPOOL_H
+#define TENSORPOOL_H
+#pragma once
+
+#include <ATen/core/TensorBody.h>
+#include <c10/core/ScalarType.h>
+#include <c10/util/ArrayRef.h>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+namespace ttb {
+
+struct TensorPoolStats {
+    /// Requests served by an idle buffer
+    int64_t hits{0};
+    /// Requests that allocated a new buffer
+    int64_t misses{0};
+    /// Bytes held by buffers waiting to be reused
+    int64_t idle_bytes{0};
+    /// Bytes held by pooled buffers backing live tensors
+    int64_t live_bytes{0};
+};
+
+/**
+ * @brief Reusable storage for the large tensors produced by Converter, XYMatrix and
+ * TrainingBundle. Buffers are 2 MiB (huge page) aligned, keyed by their size rounded up to a whole
+ * number of huge pages, and go back to the pool when the last tensor referencing them dies, so
+ * steady-state epochs stop hitting the system allocator. Disabled by default
+ *
+ */
+class TensorPool {
+  public:
+    TensorPool() = delete;
+    TensorPool(const TensorPool &) = delete;
+    TensorPool(TensorPool &&) = delete;
+    TensorPool &operator=(const TensorPool &) = delete;
+    TensorPool &operator=(TensorPool &&) = delete;
+    ~TensorPool() = default;
+
+    /// Uninitialized contiguous CPU tensor, pooled when enabled and large enough
+    [[nodiscard]] static torch::Tensor empty(c10::IntArrayRef sizes, c10::ScalarType dtype);
+
+    /// Contiguous pooled copy of the tensor (e.g. of a view)
+    [[nodiscard]] static torch::Tensor copy(const torch::Tensor &tensor);
+
+    /// Rows (dim 0) of the tensor at the given indices, gathered into a pooled tensor
+    [[nodiscard]] static torch::Tensor index_select(const torch::Tensor &tensor,
+                                                    const torch::Tensor &indices);
+
+    /**
+     * @brief Starts pooling
+     *
+     * @param max_idle_bytes Idle bytes kept for reuse; buffers released beyond it are freed
+     */
+    static void enable(int64_t max_idle_bytes = std::numeric_limits<int64_t>::max());
+
+    /// Stops pooling and frees idle buffers; buffers of live tensors are freed on release
+    static void disable();
+
+    [[nodiscard]] static bool enabled();
+
+    /// Frees idle buffers
+    static void trim();
+
+    [[nodiscard]] static ttb::TensorPoolStats stats();
+
+    static constexpr int64_t HUGE_PAGE_SIZE{1 << 21};
+
+    /// Smaller tensors are left to torch's allocator
+    static constexpr int64_t MIN_POOLED_BYTES{1 << 20};
+};
+
+class TensorPoolError : public std::runtime_error {
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+} // namespace ttb
+#endif
@@ -2,14 +2,35 @@
 #define TRAININGBUNDLE_H
 #pragma once
 
+#include "Binner.h"
 #include "XYMatrix.h"
 
 namespace ttb {
+
+enum class Normalization { MIN_MAX = 0, Z_SCORE = 1 };
+
+/**
+ * @brief Statistics of a normalization applied to an X column: (min, max) for MIN_MAX and
+ * (mean, standard deviation) for Z_SCORE
+ *
+ */
+struct NormzStats {
+    int X_col;
+    ttb::Normalization normalization;
+    double first;
+    double second;
+};
+
 class TrainingBundle {
   public:
     TrainingBundle(ttb::XYMatrix &&XY_train, ttb::XYMatrix &&XY_eval)
         : _XY_train{std::move(XY_train)}, _XY_eval{std::move(XY_eval)} {}
 
+    TrainingBundle(ttb::XYMatrix &&XY_train, ttb::XYMatrix &&XY_eval,
+                   std::vector<ttb::NormzStats> &&normz_stats)
+        : _XY_train{std::move(XY_train)}, _XY_eval{std::move(XY_eval)},
+          _normz_stats{std::move(normz_stats)} {}
+
     [[nodiscard]] const ttb::XYMatrix &XY_train() const { return this->_XY_train; }
     [[nodiscard]] const ttb::XYMatrix &XY_eval() const { return this->_XY_eval; }
 
@@ -36,9 +57,34 @@ class TrainingBundle {
      */
     std::pair<double, double> z_score_normz(int X_col);
 
+    /**
+     * @brief Replaces the specified X column of both matrices by its quantile bin indices (as
+     * floating point values), the bins being fitted on the training rows only
+     *
+     * @param X_col Column to be binned
+     * @param n_bins Number of bins
+     * @return std::vector<double> The n_bins + 1 edges of the bins
+     */
+    std::vector<double> quantile_bin(int X_col, int n_bins);
+
+    /**
+     * @brief Number of training rows in every bin of the specified X column
+     *
+     */
+    [[nodiscard]] std::vector<int64_t> histogram(int X_col, const ttb::Binner &binner) const;
+
+    /**
+     * @brief Statistics of the normalizations performed so far, in the order they were applied
+     *
+     */
+    [[nodiscard]] const std::vector<ttb::NormzStats> &normz_stats() const {
+      return this->_normz_stats;
+    }
+
   private:
     ttb::XYMatrix _XY_train;
     ttb::XYMatrix _XY_eval;
+    std::vector<ttb::NormzStats> _normz_stats;
 
     void check_X_index_floating_point(int X_col);
 };
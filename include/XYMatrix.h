@@ -35,6 +35,12 @@ class XYMatrix {
 
     void shuffle(std::optional<unsigned> seed = std::nullopt);
 
+    /// Whether X or Y only views part of a larger storage, e.g. after split
+    [[nodiscard]] bool is_view() const;
+
+    /// Copies X and Y into storage of their own if they are views, releasing the rest
+    void compact();
+
     static ttb::TrainingBundle
     stratified_split_from_one_hot(XYMatrix &&XY_matrix, int pct_eval,
                                   std::optional<unsigned> seed = std::nullopt);
@@ -43,8 +49,17 @@ class XYMatrix {
     shuffle_stratified_split_from_one_hot(XYMatrix &&XY_matrix, int pct_eval,
                                           std::optional<unsigned> seed = std::nullopt);
 
+    /**
+     * @brief Splits the first rows into train and the rest into eval, without copying: both are
+     * views of the storage of XY_matrix, which they keep alive. Call compact() on either to give
+     * it storage of its own
+     *
+     */
     static ttb::TrainingBundle split(XYMatrix &&XY_matrix, int pct_eval);
 
+    /// Number of leading rows split() keeps for training
+    [[nodiscard]] static int64_t train_rows(int64_t n_rows, int pct_eval);
+
     static ttb::TrainingBundle shuffle_split(XYMatrix &&XY_matrix, int pct_eval,
                                              std::optional<unsigned> seed = std::nullopt);
 
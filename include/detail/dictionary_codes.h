@@ -0,0 +1,31 @@
+#ifndef DICTIONARY_CODES_H
+#define DICTIONARY_CODES_H
+#pragma once
+
+#include "detail/utils.h"
+
+#include <arrow/array.h>
+#include <arrow/chunked_array.h>
+#include <arrow/memory_pool.h>
+#include <arrow/result.h>
+#include <cstdint>
+#include <vector>
+
+namespace utl {
+
+/**
+ * @brief A dictionary column as one dictionary, shared by all its chunks once unified, and the
+ * index of the value of every row in it, -1 for null rows and null dictionary values. Lets
+ * categorical operations work on int32 codes and visit every distinct value once
+ *
+ */
+struct DictionaryCodes {
+    utl::shp<arrow::Array> dictionary;
+    std::vector<int32_t> codes;
+};
+
+[[nodiscard]] arrow::Result<utl::DictionaryCodes>
+dictionary_codes(const arrow::ChunkedArray &column, arrow::MemoryPool *pool);
+
+} // namespace utl
+#endif
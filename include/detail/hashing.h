@@ -0,0 +1,24 @@
+#ifndef HASHING_H
+#define HASHING_H
+#pragma once
+
+#include <cstdint>
+
+namespace utl {
+
+/// Finalizer of splitmix64, a bijection spreading every input bit over the whole word
+inline uint64_t mix64(uint64_t value) {
+  value ^= value >> 30U;
+  value *= 0xbf58476d1ce4e5b9ULL;
+  value ^= value >> 27U;
+  value *= 0x94d049bb133111ebULL;
+  return value ^ (value >> 31U);
+}
+
+/// Seeded hash of an integer, equal for equal values of any integer type
+inline uint64_t hash_int(int64_t value, uint64_t seed) {
+  return mix64(static_cast<uint64_t>(value) ^ mix64(seed));
+}
+
+} // namespace utl
+#endif
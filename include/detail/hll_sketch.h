@@ -0,0 +1,36 @@
+#ifndef HLL_SKETCH_H
+#define HLL_SKETCH_H
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace utl {
+
+/**
+ * @brief HyperLogLog distinct counter (Flajolet et al., "HyperLogLog: the analysis of a
+ * near-optimal cardinality estimation algorithm") over 64-bit hashes. Keeps 2^precision one-byte
+ * registers, for a relative error of about 1.04 / sqrt(2^precision), i.e. 0.8% with the default
+ * precision. Small counts are linearly counted. Sketches of the same precision merge losslessly
+ *
+ */
+class HllSketch {
+  public:
+    static constexpr int DEFAULT_PRECISION{14};
+
+    explicit HllSketch(int precision = DEFAULT_PRECISION);
+
+    /// The hash must be well mixed: its top bits pick the register
+    void update(uint64_t hash);
+    void merge(const HllSketch &other);
+
+    [[nodiscard]] int precision() const { return _precision; }
+    [[nodiscard]] double estimate() const;
+
+  private:
+    int _precision;
+    std::vector<uint8_t> _registers;
+};
+
+} // namespace utl
+#endif
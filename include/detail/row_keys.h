@@ -0,0 +1,81 @@
+#ifndef ROW_KEYS_H
+#define ROW_KEYS_H
+#pragma once
+
+#include "detail/utils.h"
+
+#include <arrow/array.h>
+#include <arrow/memory_pool.h>
+#include <arrow/result.h>
+#include <arrow/table.h>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace utl {
+
+/**
+ * @brief Composite keys made of some columns of a table, hashed row by row in parallel, for
+ * hash-based operations (joins, group by, duplicate detection). Supports fixed-width, boolean,
+ * (large) binary/string columns and dictionaries of those; rows with a null in any key column
+ * are flagged. Values are hashed and compared with the string kernels; the values of a
+ * dictionary are hashed once and its rows gather the hashes of their indices
+ *
+ */
+class RowKeys {
+  public:
+    RowKeys(const RowKeys &) = delete;
+    RowKeys(RowKeys &&) = default;
+    RowKeys &operator=(const RowKeys &) = delete;
+    RowKeys &operator=(RowKeys &&) = default;
+    ~RowKeys() = default;
+
+    /// Multi-chunk key columns are concatenated with the given pool, after unifying the
+    /// dictionaries of dictionary columns
+    static arrow::Result<utl::RowKeys> Make(const arrow::Table &table,
+                                            const std::vector<int> &indices,
+                                            arrow::MemoryPool *pool);
+
+    [[nodiscard]] static bool supports(const arrow::DataType &type);
+
+    [[nodiscard]] int64_t n_rows() const { return _n_rows; }
+    [[nodiscard]] uint64_t hash(int64_t row) const { return _hashes[row]; }
+    [[nodiscard]] bool has_null(int64_t row) const { return _null_rows[row] != 0; }
+
+    /// Nulls only equal nulls; key columns of both sides must have the same value types, a
+    /// dictionary column matching plain columns of its values
+    [[nodiscard]] bool equal(int64_t row, const RowKeys &other, int64_t other_row) const;
+
+    [[nodiscard]] const std::vector<utl::shp<arrow::Array>> &columns() const { return _columns; }
+
+  private:
+    enum class Kind { FIXED_WIDTH = 0, BIT = 1, BINARY = 2, LARGE_BINARY = 3 };
+
+    /// Kind and byte_width describe values, the key column itself or its dictionary
+    struct KeyColumn {
+        Kind kind;
+        int32_t byte_width;
+        const arrow::Array *array;
+        const arrow::Array *values;
+        std::vector<uint64_t> dictionary_hashes;
+    };
+
+    std::vector<utl::shp<arrow::Array>> _columns;
+    std::vector<KeyColumn> _key_columns;
+    std::vector<uint64_t> _hashes;
+    std::vector<uint8_t> _null_rows;
+    int64_t _n_rows{0};
+
+    RowKeys(std::vector<utl::shp<arrow::Array>> &&columns, int64_t n_rows);
+
+    [[nodiscard]] static KeyColumn key_column(const arrow::Array &array,
+                                              const arrow::Array &values);
+    [[nodiscard]] static std::string_view bytes(const KeyColumn &column, int64_t row);
+    /// Hashes of the values of rows [begin, end), whatever their validity
+    static void hash_values(const KeyColumn &column, int64_t begin, int64_t end,
+                            uint64_t *hashes);
+    void hash_rows();
+};
+
+} // namespace utl
+#endif
@@ -0,0 +1,82 @@
+#ifndef STRING_KERNELS_H
+#define STRING_KERNELS_H
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace utl {
+
+/// Instruction sets the string kernels are dispatched on, each level implying the previous ones
+enum class SimdLevel { SCALAR = 0, SSE4_2 = 1, AVX2 = 2, AVX512 = 3 };
+
+/// Highest level supported by the CPU (and OS), detected once
+[[nodiscard]] utl::SimdLevel detected_simd_level();
+
+/// Level the kernels currently run at, the detected one unless lowered by set_simd_level()
+[[nodiscard]] utl::SimdLevel simd_level();
+
+/// Runs the kernels at level, capped at the detected one (e.g. to compare levels)
+void set_simd_level(utl::SimdLevel level);
+
+/**
+ * @brief Seeded 64-bit hash of a byte string from two CRC32C lanes, eight bytes at a time, with
+ * the SSE4.2 crc32 instruction or a slicing-by-8 table. Every level gives the same value, on
+ * every run and (little-endian) platform, so buckets derived from it can be stored with a model
+ *
+ */
+[[nodiscard]] uint64_t hash_string(const uint8_t *data, int64_t n_bytes, uint64_t seed);
+
+/// hash_string() of the n strings of an Arrow string/binary array, from its offsets and data
+void hash_strings(const int32_t *offsets, const uint8_t *data, int64_t n, uint64_t seed,
+                  uint64_t *hashes);
+/// hash_string() of the n strings of an Arrow large string/binary array
+void hash_strings(const int64_t *offsets, const uint8_t *data, int64_t n, uint64_t seed,
+                  uint64_t *hashes);
+/// hash_string() of n contiguous values of byte_width bytes each
+void hash_fixed(const uint8_t *values, int32_t byte_width, int64_t n, uint64_t seed,
+                uint64_t *hashes);
+
+/**
+ * @brief Dictionary lookup: hashes[i] = table[codes[i]], with 0 for codes outside
+ * [0, table_size) such as the arbitrary codes under null rows. Gathers 4 (AVX2) or 8 (AVX-512)
+ * hashes per instruction
+ *
+ */
+void gather_hashes(const uint64_t *table, int64_t table_size, const int32_t *codes, int64_t n,
+                   uint64_t *hashes);
+
+/// Out-of-line part of bytes_equal(), comparing 16, 32 or 64 bytes at a time
+[[nodiscard]] bool long_bytes_equal(const uint8_t *lhs, const uint8_t *rhs, int64_t n_bytes);
+
+/**
+ * @brief Equality of two byte strings of n_bytes each. Short strings, the bulk of categorical
+ * values, are compared inline with two overlapping loads and no call; none reads out of bounds
+ *
+ */
+inline bool bytes_equal(const uint8_t *lhs, const uint8_t *rhs, int64_t n_bytes) {
+  if (n_bytes > 16)
+    return utl::long_bytes_equal(lhs, rhs, n_bytes);
+
+  auto words_equal = [&]<typename Word>(Word) {
+    Word lhs_head, rhs_head, lhs_tail, rhs_tail;
+    std::memcpy(&lhs_head, lhs, sizeof(Word));
+    std::memcpy(&rhs_head, rhs, sizeof(Word));
+    std::memcpy(&lhs_tail, lhs + n_bytes - sizeof(Word), sizeof(Word));
+    std::memcpy(&rhs_tail, rhs + n_bytes - sizeof(Word), sizeof(Word));
+    return ((lhs_head ^ rhs_head) | (lhs_tail ^ rhs_tail)) == 0;
+  };
+
+  if (n_bytes >= 8)
+    return words_equal(uint64_t{});
+  if (n_bytes >= 4)
+    return words_equal(uint32_t{});
+  if (n_bytes == 0)
+    return true;
+
+  return lhs[0] == rhs[0] && lhs[n_bytes / 2] == rhs[n_bytes / 2] &&
+         lhs[n_bytes - 1] == rhs[n_bytes - 1];
+}
+
+} // namespace utl
+#endif
@@ -0,0 +1,88 @@
+#ifndef TOP_K_SKETCH_H
+#define TOP_K_SKETCH_H
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace utl {
+
+/**
+ * @brief Count-Min sketch (Cormode and Muthukrishnan) over 64-bit hashes: depth rows of width
+ * counters, a key counting in one counter per row. The smallest of its counters overestimates
+ * the frequency of a key by at most e / width of the total count with probability
+ * 1 - exp(-depth). Sketches of the same shape merge by adding counters
+ *
+ */
+class CountMinSketch {
+  public:
+    static constexpr int DEFAULT_WIDTH{1 << 11};
+    static constexpr int DEFAULT_DEPTH{4};
+
+    /// The width is rounded up to a power of two
+    explicit CountMinSketch(int width = DEFAULT_WIDTH, int depth = DEFAULT_DEPTH);
+
+    void update(uint64_t hash, int64_t count = 1);
+    void merge(const CountMinSketch &other);
+
+    [[nodiscard]] int64_t estimate(uint64_t hash) const;
+
+  private:
+    uint64_t _mask;
+    int _depth;
+    std::vector<int64_t> _counters;
+
+    [[nodiscard]] size_t cell(uint64_t hash, int row) const;
+};
+
+/**
+ * @brief SpaceSaving heavy hitters (Metwally et al., "Efficient Computation of Frequent and
+ * Top-k Elements in Data Streams"): at most capacity counters, kept in a min-heap by count. An
+ * untracked key takes over the smallest counter, inheriting its count as error, so every key
+ * more frequent than total / capacity is tracked. Summaries merge as in Agarwal et al.,
+ * "Mergeable Summaries"
+ *
+ */
+class SpaceSaving {
+  public:
+    struct Counter {
+        uint64_t key;
+        int64_t count;
+        /// count - error is a lower bound of the frequency of the key
+        int64_t error;
+        /// Set by the caller when the key starts being tracked, e.g. the row it was read from
+        int64_t tag;
+    };
+
+    explicit SpaceSaving(int capacity);
+
+    /// True when the key was not tracked before
+    bool update(uint64_t key, int64_t tag);
+    void merge(const SpaceSaving &other);
+
+    [[nodiscard]] int capacity() const { return _capacity; }
+    [[nodiscard]] bool full() const { return std::cmp_equal(_heap.size(), _capacity); }
+    [[nodiscard]] int64_t min_count() const;
+
+    /// Tracked counters, in heap order
+    [[nodiscard]] const std::vector<Counter> &counters() const { return _heap; }
+    void clear_tags();
+
+    /// The k counters of highest counts, most frequent first
+    [[nodiscard]] std::vector<Counter> top(int k) const;
+
+  private:
+    int _capacity;
+    std::vector<Counter> _heap;
+    std::unordered_map<uint64_t, size_t> _positions;
+
+    void swap_nodes(size_t i, size_t j);
+    void sift_up(size_t i);
+    void sift_down(size_t i);
+    void rebuild();
+};
+
+} // namespace utl
+#endif
@@ -1,21 +1,39 @@
 #include "AnalyticTable.h"
+#include "GroupBy.h"
+#include "HashingEncoder.h"
+#include "Instrumentation.h"
+#include "MemoryPool.h"
+#include "detail/dictionary_codes.h"
+#include "detail/row_keys.h"
 #include "detail/utils.h"
 
+#include <ATen/Parallel.h>
 #include <algorithm>
 #include <arrow/api.h>
 #include <arrow/chunked_array.h>
 #include <arrow/compute/api.h>
 #include <arrow/compute/api_vector.h>
 #include <arrow/compute/cast.h>
+#include <arrow/compute/expression.h>
 #include <arrow/pretty_print.h>
 #include <arrow/table.h>
 #include <arrow/type_fwd.h>
+#include <arrow/util/bit_util.h>
+#include <arrow/util/bitmap_ops.h>
+#include <atomic>
+#include <bit>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <iterator>
+#include <limits>
 #include <memory>
 #include <optional>
+#include <ranges>
+#include <span>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 std::vector<std::string> ttb::AnalyticTable::col_names() const {
   return _arrow_tb->schema()->field_names();
@@ -65,13 +83,53 @@ void ttb::AnalyticTable::keep_cols(std::vector<int> indices) {
   _arrow_tb = aux.MoveValueUnsafe();
 }
 
+namespace bottom_append {
+
+/**
+ * @brief The table with the dictionary columns decoded where the other table holds plain values
+ * of the same type, e.g. a Parquet read appended to a CSV read
+ *
+ */
+utl::shp<arrow::Table> decoded_like(const utl::shp<arrow::Table> &table,
+                                    const arrow::Schema &other) {
+  auto resp = table;
+  for (int i{0}; i < table->num_columns(); ++i) {
+    const auto &field = table->schema()->field(i);
+    const auto &other_type = other.field(i)->type();
+    if (field->type()->id() != arrow::Type::DICTIONARY ||
+        !static_cast<const arrow::DictionaryType &>(*field->type())
+             .value_type()
+             ->Equals(other_type))
+      continue;
+
+    arrow::compute::ExecContext ctx{ttb::memory_pool()};
+    auto r_decoded = arrow::compute::Cast(table->column(i), other_type,
+                                          arrow::compute::CastOptions::Safe(), &ctx);
+    ttb::throw_if_budget_exceeded(r_decoded.status());
+    if (!r_decoded.ok())
+      throw ttb::AnalyticTableError(r_decoded.status().ToString());
+
+    auto r_table =
+        resp->SetColumn(i, field->WithType(other_type), r_decoded.ValueUnsafe().chunked_array());
+    if (!r_table.ok())
+      throw ttb::AnalyticTableError(r_table.status().ToString());
+    resp = r_table.MoveValueUnsafe();
+  }
+
+  return resp;
+}
+
+} // namespace bottom_append
+
 void ttb::AnalyticTable::bottom_append(const AnalyticTable &table) {
   if (this->n_cols() != table.n_cols())
     throw AnalyticTableError("Number of columns do not match");
 
   arrow::ConcatenateTablesOptions opts;
 
-  auto resp = arrow::ConcatenateTables({_arrow_tb, table._arrow_tb});
+  auto top = bottom_append::decoded_like(_arrow_tb, *table._arrow_tb->schema());
+  auto bottom = bottom_append::decoded_like(table._arrow_tb, *_arrow_tb->schema());
+  auto resp = arrow::ConcatenateTables({top, bottom});
   if (!resp.ok())
     throw AnalyticTableError(resp.status().ToString());
 
@@ -123,8 +181,8 @@ void ttb::AnalyticTable::rename_cols(const std::vector<std::string> &names) {
   _arrow_tb = r_table.MoveValueUnsafe();
 }
 
-void ttb::AnalyticTable::slice(int64_t row_offset, int64_t row_length) {
-  auto sliced = this->sliced(row_offset, row_length);
+void ttb::AnalyticTable::slice(int64_t row_offset, int64_t row_length, ttb::CopyMode mode) {
+  auto sliced = this->sliced(row_offset, row_length, mode);
 
   _arrow_tb = std::move(sliced._arrow_tb);
 }
@@ -168,6 +226,45 @@ void ttb::AnalyticTable::move_column(int from_index, int to_index) {
   this->reorder_cols(indexes);
 }
 
+namespace dictionary_sort {
+
+/// Minimum number of rows ranked by each parallel task
+constexpr int64_t GRAIN_ROWS{1 << 14};
+
+/**
+ * @brief Sort indices of a dictionary column, which arrow cannot sort a table on: the dictionary
+ * is sorted once, then rows are sorted on the rank of their value, nulls last
+ *
+ */
+arrow::Result<utl::shp<arrow::Array>> indices(const arrow::ChunkedArray &column,
+                                              arrow::compute::SortOrder order,
+                                              arrow::compute::ExecContext *ctx) {
+  ARROW_ASSIGN_OR_RAISE(auto codes, utl::dictionary_codes(column, ctx->memory_pool()));
+  ARROW_ASSIGN_OR_RAISE(auto dictionary_order,
+                        arrow::compute::SortIndices(*codes.dictionary, order, ctx));
+
+  const auto &value_order = static_cast<const arrow::UInt64Array &>(*dictionary_order);
+  auto n_values = static_cast<int32_t>(value_order.length());
+  std::vector<int32_t> value_ranks(n_values);
+  for (int32_t r{0}; r < n_values; ++r)
+    value_ranks[value_order.Value(r)] = r;
+
+  auto n_rows = static_cast<int64_t>(codes.codes.size());
+  ARROW_ASSIGN_OR_RAISE(auto buffer, arrow::AllocateBuffer(
+                                         n_rows * static_cast<int64_t>(sizeof(int32_t)),
+                                         ctx->memory_pool()));
+  auto *ranks = reinterpret_cast<int32_t *>(buffer->mutable_data());
+  at::parallel_for(0, n_rows, GRAIN_ROWS, [&](int64_t begin, int64_t end) {
+    for (auto i{begin}; i < end; ++i)
+      ranks[i] = codes.codes[i] < 0 ? n_values : value_ranks[codes.codes[i]];
+  });
+
+  arrow::Int32Array rank_array{n_rows, std::move(buffer)};
+  return arrow::compute::SortIndices(rank_array, arrow::compute::SortOrder::Ascending, ctx);
+}
+
+} // namespace dictionary_sort
+
 void ttb::AnalyticTable::sort(int col_index, ttb::SortOrder mode) {
   if (col_index < 0 || col_index >= this->n_cols())
     throw AnalyticTableError("Index out of bounds");
@@ -180,17 +277,24 @@ void ttb::AnalyticTable::sort(int col_index, ttb::SortOrder mode) {
                                            : arrow::compute::SortOrder::Descending;
   arrow::compute::SortOptions opts{{arrow::compute::SortKey{col_name, order}}};
 
-  auto r_indices = arrow::compute::SortIndices(_arrow_tb, opts);
+  arrow::compute::ExecContext ctx{ttb::memory_pool()};
+  const auto &column = *_arrow_tb->column(col_index);
+  auto r_indices = column.type()->id() == arrow::Type::DICTIONARY
+                       ? dictionary_sort::indices(column, order, &ctx)
+                       : arrow::compute::SortIndices(_arrow_tb, opts, &ctx);
+  ttb::throw_if_budget_exceeded(r_indices.status());
   if (!r_indices.ok())
     throw AnalyticTableError(r_indices.status().ToString());
 
   auto r_datum = arrow::compute::Take(_arrow_tb, r_indices.MoveValueUnsafe(),
-                                      arrow::compute::TakeOptions::NoBoundsCheck());
+                                      arrow::compute::TakeOptions::NoBoundsCheck(), &ctx);
 
+  ttb::throw_if_budget_exceeded(r_datum.status());
   if (!r_datum.ok())
     throw AnalyticTableError(r_datum.status().ToString());
 
   _arrow_tb = r_datum.MoveValueUnsafe().table();
+  _sorted_column = _arrow_tb->column(col_index);
 }
 
 namespace one_hot_expand {
@@ -198,7 +302,8 @@ namespace one_hot_expand {
 utl::shp<arrow::Array> to_array(const ttb::AnalyticTable &col_clone) {
   auto chunks = col_clone.arrow_table()->column(0)->chunks();
 
-  auto r_col_as_array = arrow::Concatenate(chunks, arrow::default_memory_pool());
+  auto r_col_as_array = arrow::Concatenate(chunks, ttb::memory_pool());
+  ttb::throw_if_budget_exceeded(r_col_as_array.status());
   if (!r_col_as_array.ok())
     throw ttb::AnalyticTableError(r_col_as_array.status().ToString());
 
@@ -207,67 +312,286 @@ utl::shp<arrow::Array> to_array(const ttb::AnalyticTable &col_clone) {
   return column;
 }
 
-utl::shp<arrow::Array> build_one_hot_col(const utl::shp<arrow::Array> &col_as_array,
-                                         const utl::shp<arrow::Scalar> &distinct_value) {
-  arrow::Int32Builder builder(arrow::default_memory_pool());
+/// Minimum number of rows encoded by each parallel task
+constexpr int64_t GRAIN_ROWS{1 << 14};
+
+/// n_cols int32 columns flagging, for every row i, column col_of(i)
+template <typename ColOf>
+std::vector<utl::shp<arrow::Array>> flag_cols(int64_t n_rows, int64_t n_cols, ColOf col_of) {
+  std::vector<utl::shp<arrow::Buffer>> buffers;
+  std::vector<int32_t *> flags;
+  for (int64_t j{0}; j < n_cols; ++j) {
+    auto r_buffer = arrow::AllocateBuffer(n_rows * static_cast<int64_t>(sizeof(int32_t)),
+                                          ttb::memory_pool());
+    ttb::throw_if_budget_exceeded(r_buffer.status());
+    if (!r_buffer.ok())
+      throw ttb::AnalyticTableError(r_buffer.status().ToString());
+
+    utl::shp<arrow::Buffer> buffer = r_buffer.MoveValueUnsafe();
+    flags.emplace_back(reinterpret_cast<int32_t *>(buffer->mutable_data()));
+    buffers.emplace_back(std::move(buffer));
+  }
+
+  at::parallel_for(0, n_rows, GRAIN_ROWS, [&](int64_t begin, int64_t end) {
+    for (auto *col_flags : flags)
+      std::fill(col_flags + begin, col_flags + end, 0);
+    for (auto i{begin}; i < end; ++i)
+      flags[col_of(i)][i] = 1;
+  });
+
+  std::vector<utl::shp<arrow::Array>> resp;
+  resp.reserve(n_cols);
+  for (auto &buffer : buffers)
+    resp.emplace_back(std::make_shared<arrow::Int32Array>(n_rows, std::move(buffer)));
+
+  return resp;
+}
+
+/// Index of the value of every row of col_as_array in values, null when absent
+utl::shp<arrow::Int32Array> index_in(const utl::shp<arrow::Array> &col_as_array,
+                                     const utl::shp<arrow::Array> &values) {
+  utl::initialize_arrow_compute();
+  arrow::compute::ExecContext ctx{ttb::memory_pool()};
+  arrow::compute::SetLookupOptions options{values};
+  auto r_indices = arrow::compute::IndexIn(col_as_array, options, &ctx);
+  ttb::throw_if_budget_exceeded(r_indices.status());
+  if (!r_indices.ok())
+    throw ttb::AnalyticTableError(r_indices.status().ToString());
+
+  return std::static_pointer_cast<arrow::Int32Array>(r_indices.MoveValueUnsafe().make_array());
+}
+
+/// Codes of the dictionary column of a one-column table
+utl::DictionaryCodes codes(const ttb::AnalyticTable &col_clone) {
+  auto r_codes = utl::dictionary_codes(*col_clone.arrow_table()->column(0), ttb::memory_pool());
+  ttb::throw_if_budget_exceeded(r_codes.status());
+  if (!r_codes.ok())
+    throw ttb::AnalyticTableError(r_codes.status().ToString());
+
+  return r_codes.MoveValueUnsafe();
+}
+
+bool is_dictionary(const ttb::AnalyticTable &col_clone) {
+  return col_clone.arrow_table()->column(0)->type()->id() == arrow::Type::DICTIONARY;
+}
+
+/**
+ * @brief One int32 column per value of values, in order, flagging the rows equal to it, and a
+ * last column flagging the other rows (nulls included). Dictionary columns only look their
+ * dictionary up, rows then going to the column of their code
+ *
+ */
+std::vector<utl::shp<arrow::Array>> top_k_cols(const ttb::AnalyticTable &col_clone,
+                                               const utl::shp<arrow::Array> &values) {
+  auto n_cols = values->length() + 1;
+  if (is_dictionary(col_clone)) {
+    auto col_codes = codes(col_clone);
+    auto indices = index_in(col_codes.dictionary, values);
+
+    // Slot 0 holds null rows, slot code + 1 the rows of a code
+    std::vector<int64_t> slot_cols(col_codes.dictionary->length() + 1, n_cols - 1);
+    for (int64_t code{0}; code < indices->length(); ++code)
+      if (indices->IsValid(code))
+        slot_cols[code + 1] = indices->Value(code);
+
+    return flag_cols(col_clone.n_rows(), n_cols,
+                     [&](int64_t i) { return slot_cols[col_codes.codes[i] + 1]; });
+  }
+
+  auto col_as_array = to_array(col_clone);
+  auto indices = index_in(col_as_array, values);
+  return flag_cols(col_as_array->length(), n_cols, [&](int64_t i) {
+    return indices->IsValid(i) ? int64_t{indices->Value(i)} : n_cols - 1;
+  });
+}
+
+/**
+ * @brief distinct_cols() of a dictionary column, from its codes: the first row of every code is
+ * found in parallel, and only the dictionary values present are decoded
+ *
+ */
+std::pair<utl::shp<arrow::Array>, std::vector<utl::shp<arrow::Array>>>
+dictionary_cols(const ttb::AnalyticTable &col_clone) {
+  auto col_codes = codes(col_clone);
+  const auto &row_codes = col_codes.codes;
+  auto n_rows = static_cast<int64_t>(row_codes.size());
+
+  // Slot 0 holds null rows, slot code + 1 the rows of a code. Every task finds the first row of
+  // every slot in a contiguous range, the first task seeing a slot holding its first row
+  auto n_slots = col_codes.dictionary->length() + 1;
+  auto n_tasks = std::clamp<int64_t>(n_rows / GRAIN_ROWS, 1, at::get_num_threads());
+  auto task_rows = (n_rows + n_tasks - 1) / n_tasks;
+  std::vector<std::vector<int64_t>> task_first_rows(n_tasks);
+  at::parallel_for(0, n_tasks, 1, [&](int64_t begin, int64_t end) {
+    for (auto t{begin}; t < end; ++t) {
+      auto &first_rows = task_first_rows[t];
+      first_rows.assign(n_slots, n_rows);
+      for (auto i{t * task_rows}; i < std::min(n_rows, (t + 1) * task_rows); ++i) {
+        auto &first_row = first_rows[row_codes[i] + 1];
+        if (first_row == n_rows)
+          first_row = i;
+      }
+    }
+  });
+
+  std::vector<int64_t> first_rows(n_slots, n_rows);
+  for (const auto &task : task_first_rows)
+    for (int64_t slot{0}; slot < n_slots; ++slot)
+      first_rows[slot] = std::min(first_rows[slot], task[slot]);
+
+  std::vector<int64_t> slots;
+  for (int64_t slot{0}; slot < n_slots; ++slot)
+    if (first_rows[slot] < n_rows)
+      slots.emplace_back(slot);
+  std::ranges::sort(slots, {}, [&](int64_t slot) { return first_rows[slot]; });
+
+  std::vector<int64_t> slot_cols(n_slots, 0);
+  arrow::Int32Builder value_codes{ttb::memory_pool()};
+  for (size_t j{0}; j < slots.size(); ++j) {
+    slot_cols[slots[j]] = static_cast<int64_t>(j);
+    auto status = slots[j] == 0 ? value_codes.AppendNull()
+                                : value_codes.Append(static_cast<int32_t>(slots[j] - 1));
+    ttb::throw_if_budget_exceeded(status);
+    if (!status.ok())
+      throw ttb::AnalyticTableError(status.ToString());
+  }
+
+  auto r_value_codes = value_codes.Finish();
+  ttb::throw_if_budget_exceeded(r_value_codes.status());
+  if (!r_value_codes.ok())
+    throw ttb::AnalyticTableError(r_value_codes.status().ToString());
+
+  arrow::compute::ExecContext ctx{ttb::memory_pool()};
+  auto r_values = arrow::compute::Take(col_codes.dictionary, r_value_codes.MoveValueUnsafe(),
+                                       arrow::compute::TakeOptions::NoBoundsCheck(), &ctx);
+  ttb::throw_if_budget_exceeded(r_values.status());
+  if (!r_values.ok())
+    throw ttb::AnalyticTableError(r_values.status().ToString());
+
+  return {r_values.MoveValueUnsafe().make_array(),
+          flag_cols(n_rows, static_cast<int64_t>(slots.size()),
+                    [&](int64_t i) { return slot_cols[row_codes[i] + 1]; })};
+}
+
+/**
+ * @brief Distinct values of a one-column table in order of first appearance (nulls being one of
+ * them), and one int32 column per value flagging the rows equal to it. Dictionary columns work on
+ * their codes; other supported key types are grouped in a single pass, hashed and compared by
+ * the string kernels; others go through Unique and IndexIn
+ *
+ */
+std::pair<utl::shp<arrow::Array>, std::vector<utl::shp<arrow::Array>>>
+distinct_cols(const ttb::AnalyticTable &col_clone) {
+  if (is_dictionary(col_clone))
+    return dictionary_cols(col_clone);
+
+  auto col_as_array = to_array(col_clone);
   auto n_rows = col_as_array->length();
-  auto status = builder.Resize(n_rows);
+  if (!utl::RowKeys::supports(*col_as_array->type())) {
+    utl::initialize_arrow_compute();
+    auto r_values = arrow::compute::Unique(col_as_array);
+    ttb::throw_if_budget_exceeded(r_values.status());
+    if (!r_values.ok())
+      throw ttb::AnalyticTableError(r_values.status().ToString());
+
+    auto values = r_values.MoveValueUnsafe();
+    auto indices = index_in(col_as_array, values);
+    return {values, flag_cols(n_rows, values->length(),
+                              [&](int64_t i) { return int64_t{indices->Value(i)}; })};
+  }
+
+  ttb::GroupBy groups{col_clone, col_clone.col_names()};
+  const auto &row_groups = groups.row_groups();
+  arrow::Int64Builder first_rows{ttb::memory_pool()};
+  auto status = first_rows.AppendValues(groups.group_rows());
+  ttb::throw_if_budget_exceeded(status);
   if (!status.ok())
     throw ttb::AnalyticTableError(status.ToString());
 
-  for (int64_t i{0}; i < n_rows; ++i) {
-    auto r_value = col_as_array->GetScalar(i);
-    if (!r_value.ok())
-      throw ttb::AnalyticTableError(r_value.status().ToString());
+  auto r_first_rows = first_rows.Finish();
+  ttb::throw_if_budget_exceeded(r_first_rows.status());
+  if (!r_first_rows.ok())
+    throw ttb::AnalyticTableError(r_first_rows.status().ToString());
 
-    auto value = r_value.MoveValueUnsafe();
-    auto flag = value->Equals(*distinct_value) ? 1 : 0;
-    builder.UnsafeAppend(flag);
-  }
+  arrow::compute::ExecContext ctx{ttb::memory_pool()};
+  auto r_values = arrow::compute::Take(col_as_array, r_first_rows.MoveValueUnsafe(),
+                                       arrow::compute::TakeOptions::NoBoundsCheck(), &ctx);
+  ttb::throw_if_budget_exceeded(r_values.status());
+  if (!r_values.ok())
+    throw ttb::AnalyticTableError(r_values.status().ToString());
 
-  auto r_array = builder.Finish();
-  if (!r_array.ok())
-    throw ttb::AnalyticTableError(r_array.status().ToString());
-
-  return r_array.ValueUnsafe();
-};
+  return {r_values.MoveValueUnsafe().make_array(),
+          flag_cols(n_rows, groups.n_groups(), [&](int64_t i) { return row_groups[i]; })};
+}
 
 } // namespace one_hot_expand
 
-void ttb::AnalyticTable::one_hot_expand(int col_index) {
+void ttb::AnalyticTable::one_hot_expand(int col_index, std::optional<int> top_k) {
+  TTB_TIMED_SCOPE("AnalyticTable::one_hot_expand");
+  ttb::MemoryOperation memory_operation{"AnalyticTable::one_hot_expand"};
+  TTB_COUNT_ROWS(this->n_rows());
   if (col_index < 0 || col_index >= this->n_cols())
     throw AnalyticTableError("Index out of bounds");
 
   auto col_clone = this->copy_cols({col_index});
-  auto col_array = one_hot_expand::to_array(col_clone);
-  auto field_names = arrow::compute::Unique(col_array).ValueOrDie();
-
-  auto n_fields = field_names->length();
   auto prefix = this->col_names()[col_index] + "_";
   std::vector<utl::shp<arrow::Field>> fields;
   std::vector<utl::shp<arrow::Array>> one_hot_cols;
-  fields.reserve(n_fields);
-  one_hot_cols.reserve(n_fields);
-
-  for (int64_t j{0}; j < n_fields; ++j) {
-    auto r_field_name = field_names->GetScalar(j);
-    if (!r_field_name.ok())
-      throw AnalyticTableError(r_field_name.status().ToString());
-
-    auto field_name = r_field_name.ValueUnsafe();
-    fields.emplace_back(arrow::field(prefix + field_name->ToString(), arrow::int32()));
-
-    auto one_hot_col = one_hot_expand::build_one_hot_col(col_array, field_name);
 
-    one_hot_cols.emplace_back(std::move(one_hot_col));
+  // Sketching first bounds the work on high-cardinality columns by top_k
+  auto sketch = top_k.has_value() ? std::optional{this->sketch(col_index, top_k.value())}
+                                  : std::nullopt;
+  if (sketch.has_value() && sketch->distinct_count() > top_k.value()) {
+    auto values = sketch->heavy_hitter_values();
+    one_hot_cols = one_hot_expand::top_k_cols(col_clone, values);
+    for (int64_t j{0}; j < values->length(); ++j) {
+      auto r_value = values->GetScalar(j);
+      if (!r_value.ok())
+        throw AnalyticTableError(r_value.status().ToString());
+      fields.emplace_back(arrow::field(prefix + r_value.ValueUnsafe()->ToString(), arrow::int32()));
+    }
+    fields.emplace_back(arrow::field(prefix + "other", arrow::int32()));
+  } else {
+    auto [values, value_cols] = one_hot_expand::distinct_cols(col_clone);
+    one_hot_cols = std::move(value_cols);
+    fields.reserve(values->length());
+    for (int64_t j{0}; j < values->length(); ++j) {
+      auto r_value = values->GetScalar(j);
+      if (!r_value.ok())
+        throw AnalyticTableError(r_value.status().ToString());
+      fields.emplace_back(arrow::field(prefix + r_value.ValueUnsafe()->ToString(), arrow::int32()));
+    }
   }
 
   auto schema = arrow::schema(fields);
-  ttb::AnalyticTable table{arrow::Table::Make(schema, one_hot_cols, col_array->length())};
+  ttb::AnalyticTable table{arrow::Table::Make(schema, one_hot_cols, col_clone.n_rows())};
   this->append(table, ttb::Axis::COLUMN);
   this->remove_col(col_index);
 }
 
+void ttb::AnalyticTable::hash_expand(int col_index, const ttb::HashingEncoder &encoder) {
+  TTB_TIMED_SCOPE("AnalyticTable::hash_expand");
+  ttb::MemoryOperation memory_operation{"AnalyticTable::hash_expand"};
+  TTB_COUNT_ROWS(this->n_rows());
+  if (col_index < 0 || col_index >= this->n_cols())
+    throw AnalyticTableError("Index out of bounds");
+
+  auto prefix = this->col_names()[col_index] + "_";
+  auto block = encoder.dense<int>(*_arrow_tb->column(col_index), prefix);
+  this->append(block, ttb::Axis::COLUMN);
+  this->remove_col(col_index);
+}
+
+ttb::ColumnSketch ttb::AnalyticTable::sketch(int col_index, int top_k) const {
+  if (col_index < 0 || col_index >= this->n_cols())
+    throw AnalyticTableError("Index out of bounds");
+
+  ttb::ColumnSketch resp{top_k};
+  resp.update(*_arrow_tb->column(col_index));
+
+  return resp;
+}
+
 ttb::AnalyticTable ttb::AnalyticTable::extract_column(int col_index) {
   auto ncols = this->n_cols();
   if (ncols == 1)
@@ -281,17 +605,59 @@ ttb::AnalyticTable ttb::AnalyticTable::extract_column(int col_index) {
   return this->right_extract_of(ncols - 2);
 }
 
-ttb::AnalyticTable ttb::AnalyticTable::sliced(int64_t row_offset, int64_t row_length) const {
+namespace deep_copy {
+utl::shp<arrow::Table> copy_table(const arrow::Table &table, bool combine_chunks,
+                                  arrow::MemoryPool *pool);
+} // namespace deep_copy
+
+ttb::AnalyticTable ttb::AnalyticTable::sliced(int64_t row_offset, int64_t row_length,
+                                              ttb::CopyMode mode) const {
   if (row_offset < 0 || row_length < 0 ||
-      std::cmp_greater_equal(row_offset + row_length, this->n_rows()))
+      std::cmp_greater(row_offset + row_length, this->n_rows()))
     throw AnalyticTableError("Invalid parameters");
 
   auto sliced_view = _arrow_tb->Slice(row_offset, row_length);
-  auto r_sliced_cp = sliced_view->CombineChunks(arrow::default_memory_pool());
-  if (!r_sliced_cp.ok())
-    throw ttb::AnalyticTableError(r_sliced_cp.status().ToString());
+  if (mode == ttb::CopyMode::DEEP)
+    return AnalyticTable{deep_copy::copy_table(*sliced_view, true, ttb::memory_pool())};
+
+  return AnalyticTable{std::move(sliced_view)};
+}
+
+std::vector<ttb::AnalyticTable> ttb::AnalyticTable::split_rows(int n_parts,
+                                                               ttb::CopyMode mode) const {
+  if (n_parts <= 0)
+    throw AnalyticTableError("Number of parts must be positive");
+
+  // The first n_rows % n_parts parts take one extra row
+  auto base_length = this->n_rows() / n_parts;
+  auto n_longer = this->n_rows() % n_parts;
+
+  std::vector<ttb::AnalyticTable> resp;
+  resp.reserve(n_parts);
+  int64_t row_offset{0};
+  for (int64_t i{0}; i < n_parts; ++i) {
+    auto row_length = base_length + (i < n_longer ? 1 : 0);
+    auto part = _arrow_tb->Slice(row_offset, row_length);
+    if (mode == ttb::CopyMode::DEEP)
+      part = deep_copy::copy_table(*part, true, ttb::memory_pool());
+    resp.emplace_back(std::move(part));
+    row_offset += row_length;
+  }
 
-  return AnalyticTable{r_sliced_cp.MoveValueUnsafe()};
+  return resp;
+}
+
+void ttb::AnalyticTable::combine_chunks() {
+  auto is_combined = [](const auto &column) { return column->num_chunks() <= 1; };
+  if (std::ranges::all_of(_arrow_tb->columns(), is_combined))
+    return;
+
+  auto r_combined = _arrow_tb->CombineChunks(ttb::memory_pool());
+  ttb::throw_if_budget_exceeded(r_combined.status());
+  if (!r_combined.ok())
+    throw ttb::AnalyticTableError(r_combined.status().ToString());
+
+  _arrow_tb = r_combined.MoveValueUnsafe();
 }
 
 void ttb::AnalyticTable::print_head(int64_t n_rows) const {
@@ -344,27 +710,786 @@ ttb::AnalyticTable ttb::AnalyticTable::right_extract_of(int col_index) {
   return AnalyticTable{r_extracted.MoveValueUnsafe()};
 }
 
-ttb::AnalyticTable ttb::AnalyticTable::clone() const {
+namespace deep_copy {
+
+utl::shp<arrow::Buffer> copy_bytes(const uint8_t *data, int64_t n_bytes, arrow::MemoryPool *pool) {
+  auto r_buf = arrow::AllocateBuffer(n_bytes, pool);
+  ttb::throw_if_budget_exceeded(r_buf.status());
+  if (!r_buf.ok())
+    throw ttb::AnalyticTableError(r_buf.status().ToString());
+
+  utl::shp<arrow::Buffer> buf = r_buf.MoveValueUnsafe();
+  if (n_bytes > 0)
+    std::memcpy(buf->mutable_data(), data, n_bytes);
+
+  return buf;
+}
+
+utl::shp<arrow::Buffer> copy_bits(const uint8_t *bitmap, int64_t offset, int64_t length,
+                                  arrow::MemoryPool *pool) {
+  auto r_buf = arrow::internal::CopyBitmap(pool, bitmap, offset, length);
+  ttb::throw_if_budget_exceeded(r_buf.status());
+  if (!r_buf.ok())
+    throw ttb::AnalyticTableError(r_buf.status().ToString());
+
+  return r_buf.MoveValueUnsafe();
+}
+
+/**
+ * @brief Deep copy of the array data. Fixed-width arrays are compacted to the rows they expose;
+ * other layouts copy their buffers whole and keep their offset
+ *
+ */
+utl::shp<arrow::ArrayData> copy_array_data(const arrow::ArrayData &data, arrow::MemoryPool *pool) {
+  auto resp = data.Copy();
+  const auto *fixed_width = dynamic_cast<const arrow::FixedWidthType *>(data.type.get());
+
+  for (size_t i{0}; i < data.buffers.size(); ++i) {
+    const auto &buf = data.buffers[i];
+    if (buf == nullptr)
+      continue;
+
+    if (fixed_width == nullptr)
+      resp->buffers[i] = copy_bytes(buf->data(), buf->size(), pool);
+    else if (i == 0 || fixed_width->bit_width() == 1)
+      resp->buffers[i] = copy_bits(buf->data(), data.offset, data.length, pool);
+    else {
+      auto byte_width = fixed_width->bit_width() / 8;
+      resp->buffers[i] =
+          copy_bytes(buf->data() + data.offset * byte_width, data.length * byte_width, pool);
+    }
+  }
+  if (fixed_width != nullptr)
+    resp->offset = 0;
+
+  for (auto &child : resp->child_data)
+    child = copy_array_data(*child, pool);
+  if (data.dictionary != nullptr)
+    resp->dictionary = copy_array_data(*data.dictionary, pool);
+
+  return resp;
+}
+
+utl::shp<arrow::ChunkedArray> copy_column(const arrow::ChunkedArray &column,
+                                          arrow::MemoryPool *pool) {
+  arrow::ArrayVector chunks;
+  chunks.reserve(column.num_chunks());
+  for (const auto &chunk : column.chunks())
+    chunks.emplace_back(arrow::MakeArray(copy_array_data(*chunk->data(), pool)));
+
+  return std::make_shared<arrow::ChunkedArray>(std::move(chunks), column.type());
+}
+
+/// Deep copy of the column in a single contiguous chunk
+utl::shp<arrow::ChunkedArray> combined_column(const arrow::ChunkedArray &column,
+                                              arrow::MemoryPool *pool) {
+  if (column.num_chunks() <= 1)
+    return copy_column(column, pool);
+
+  auto r_combined = arrow::Concatenate(column.chunks(), pool);
+  ttb::throw_if_budget_exceeded(r_combined.status());
+  if (!r_combined.ok())
+    throw ttb::AnalyticTableError(r_combined.status().ToString());
+
+  return std::make_shared<arrow::ChunkedArray>(r_combined.MoveValueUnsafe());
+}
+
+/// Deep copy of the table, optionally combining the chunks of each column, one column per task
+utl::shp<arrow::Table> copy_table(const arrow::Table &table, bool combine_chunks,
+                                  arrow::MemoryPool *pool) {
+  std::vector<utl::shp<arrow::ChunkedArray>> cols(table.num_columns());
+  at::parallel_for(0, table.num_columns(), 1, [&](int64_t begin, int64_t end) {
+    for (auto j{begin}; j < end; ++j) {
+      const auto &column = *table.column(static_cast<int>(j));
+      cols[j] = combine_chunks ? combined_column(column, pool) : copy_column(column, pool);
+    }
+  });
+
+  return arrow::Table::Make(table.schema(), std::move(cols), table.num_rows());
+}
+
+} // namespace deep_copy
+
+ttb::AnalyticTable ttb::AnalyticTable::clone(ttb::CopyMode mode) const {
+  if (mode == ttb::CopyMode::COPY_ON_WRITE) {
+    auto shared = _arrow_tb;
+    return AnalyticTable{std::move(shared)};
+  }
+
+  TTB_TIMED_SCOPE("AnalyticTable::clone");
+  TTB_COUNT_ROWS(this->n_rows());
+
+  // Chunks are copied straight from their buffers
+  return AnalyticTable{deep_copy::copy_table(*_arrow_tb, false, ttb::memory_pool())};
+}
+
+namespace filter {
+
+/// Boolean selection of every row, one chunk per record batch of the table, evaluated in parallel
+utl::shp<arrow::ChunkedArray> selection(const arrow::Table &table,
+                                        const arrow::compute::Expression &predicate) {
+  // Worker threads do not inherit the caller's MemoryPoolScope
+  auto *pool = ttb::memory_pool();
+  arrow::compute::ExecContext ctx{pool};
+  auto r_bound = predicate.Bind(*table.schema(), &ctx);
+  if (!r_bound.ok())
+    throw ttb::AnalyticTableError(r_bound.status().ToString());
+
+  auto bound = r_bound.MoveValueUnsafe();
+  if (bound.type()->id() != arrow::Type::BOOL)
+    throw ttb::AnalyticTableError("Predicate is not boolean: " + bound.type()->ToString());
+
+  arrow::TableBatchReader reader{table};
+  auto r_batches = reader.ToRecordBatches();
+  if (!r_batches.ok())
+    throw ttb::AnalyticTableError(r_batches.status().ToString());
+
+  auto batches = r_batches.MoveValueUnsafe();
+  arrow::ArrayVector chunks(batches.size());
+  at::parallel_for(0, static_cast<int64_t>(batches.size()), 1, [&](int64_t begin, int64_t end) {
+    arrow::compute::ExecContext batch_ctx{pool};
+    for (auto i{begin}; i < end; ++i) {
+      const auto &batch = batches[i];
+      auto r_input = arrow::compute::MakeExecBatch(*table.schema(), batch);
+      if (!r_input.ok())
+        throw ttb::AnalyticTableError(r_input.status().ToString());
+
+      auto r_selected = arrow::compute::ExecuteScalarExpression(bound, *r_input, &batch_ctx);
+      ttb::throw_if_budget_exceeded(r_selected.status());
+      if (!r_selected.ok())
+        throw ttb::AnalyticTableError(r_selected.status().ToString());
+
+      // Predicates not depending on any column give a single scalar
+      auto selected = r_selected.MoveValueUnsafe();
+      if (selected.is_scalar()) {
+        auto r_array = arrow::MakeArrayFromScalar(*selected.scalar(), batch->num_rows(), pool);
+        ttb::throw_if_budget_exceeded(r_array.status());
+        if (!r_array.ok())
+          throw ttb::AnalyticTableError(r_array.status().ToString());
+        chunks[i] = r_array.MoveValueUnsafe();
+      } else
+        chunks[i] = selected.make_array();
+    }
+  });
+
+  return std::make_shared<arrow::ChunkedArray>(std::move(chunks), arrow::boolean());
+}
+
+/// Rows combined into each parallel task of valid_rows, a multiple of 8 so tasks own whole bytes
+constexpr int64_t GRAIN_ROWS{1 << 16};
+
+/**
+ * @brief Selection of the rows valid in every given column, one chunk per record batch of the
+ * table: the validity bitmaps are ANDed word by word, in parallel over blocks of rows
+ *
+ */
+utl::shp<arrow::ChunkedArray> valid_rows(const arrow::Table &table,
+                                         const std::vector<int> &indices) {
+  arrow::TableBatchReader reader{table};
+  auto r_batches = reader.ToRecordBatches();
+  if (!r_batches.ok())
+    throw ttb::AnalyticTableError(r_batches.status().ToString());
+
+  arrow::ArrayVector chunks;
+  for (const auto &batch : r_batches.ValueUnsafe()) {
+    auto n_rows = batch->num_rows();
+    auto r_bitmap = arrow::AllocateBitmap(n_rows, ttb::memory_pool());
+    ttb::throw_if_budget_exceeded(r_bitmap.status());
+    if (!r_bitmap.ok())
+      throw ttb::AnalyticTableError(r_bitmap.status().ToString());
+
+    // Null counts are resolved up front, as they may be computed lazily
+    std::vector<const arrow::Array *> nullable;
+    for (auto j : indices)
+      if (batch->column(j)->null_count() != 0)
+        nullable.emplace_back(batch->column(j).get());
+
+    utl::shp<arrow::Buffer> bitmap = r_bitmap.MoveValueUnsafe();
+    auto *bits = bitmap->mutable_data();
+    auto n_blocks = (n_rows + GRAIN_ROWS - 1) / GRAIN_ROWS;
+    at::parallel_for(0, n_blocks, 1, [&](int64_t begin, int64_t end) {
+      for (auto b{begin}; b < end; ++b) {
+        auto row_offset = b * GRAIN_ROWS;
+        auto row_length = std::min(GRAIN_ROWS, n_rows - row_offset);
+        arrow::bit_util::SetBitsTo(bits, row_offset, row_length, true);
+        for (const auto *column : nullable) {
+          // Null typed columns have no bitmap, all their rows are null
+          if (column->null_bitmap_data() == nullptr) {
+            arrow::bit_util::SetBitsTo(bits, row_offset, row_length, false);
+            break;
+          }
+          arrow::internal::BitmapAnd(bits, row_offset, column->null_bitmap_data(),
+                                     column->offset() + row_offset, row_length, row_offset, bits);
+        }
+      }
+    });
+    chunks.emplace_back(std::make_shared<arrow::BooleanArray>(n_rows, std::move(bitmap)));
+  }
+
+  return std::make_shared<arrow::ChunkedArray>(std::move(chunks), arrow::boolean());
+}
+
+/// Runs of consecutive selected rows as (offset, length), or nothing past max_runs of them
+std::optional<std::vector<std::pair<int64_t, int64_t>>>
+selected_runs(const arrow::ChunkedArray &selection, int64_t max_runs) {
+  std::vector<std::pair<int64_t, int64_t>> resp;
+  int64_t row{0};
+  for (const auto &chunk : selection.chunks()) {
+    const auto &mask = static_cast<const arrow::BooleanArray &>(*chunk);
+    for (int64_t i{0}; i < mask.length(); ++i, ++row) {
+      if (!mask.IsValid(i) || !mask.Value(i))
+        continue;
+      if (!resp.empty() && resp.back().first + resp.back().second == row) {
+        ++resp.back().second;
+        continue;
+      }
+      if (std::cmp_equal(resp.size(), max_runs))
+        return std::nullopt;
+      resp.emplace_back(row, 1);
+    }
+  }
+
+  return resp;
+}
+
+/// Keeps the selected rows, as zero-copy slices when they form at most max_slices runs
+void keep_selected(utl::shp<arrow::Table> &table, const utl::shp<arrow::ChunkedArray> &selection,
+                   int64_t max_slices) {
+  auto runs = selected_runs(*selection, max_slices);
+  if (!runs.has_value()) {
+    arrow::compute::ExecContext ctx{ttb::memory_pool()};
+    auto r_filtered = arrow::compute::Filter(table, selection,
+                                             arrow::compute::FilterOptions::Defaults(), &ctx);
+    ttb::throw_if_budget_exceeded(r_filtered.status());
+    if (!r_filtered.ok())
+      throw ttb::AnalyticTableError(r_filtered.status().ToString());
+
+    table = r_filtered.MoveValueUnsafe().table();
+    return;
+  }
+
+  if (runs->size() == 1 && runs->front().second == table->num_rows())
+    return;
+
+  // Few dropped rows leave few runs of kept ones, chained as zero-copy slices
+  std::vector<utl::shp<arrow::Table>> slices;
+  for (auto [row_offset, row_length] : runs.value())
+    slices.emplace_back(table->Slice(row_offset, row_length));
+  if (slices.empty())
+    slices.emplace_back(table->Slice(0, 0));
+
+  auto r_chained = arrow::ConcatenateTables(slices);
+  if (!r_chained.ok())
+    throw ttb::AnalyticTableError(r_chained.status().ToString());
+
+  table = r_chained.MoveValueUnsafe();
+}
+
+} // namespace filter
+
+ttb::AnalyticTable ttb::AnalyticTable::filtered(const arrow::compute::Expression &predicate) const {
+  TTB_TIMED_SCOPE("AnalyticTable::filtered");
+  TTB_COUNT_ROWS(this->n_rows());
+
+  /// Required by arrow for some compute functions
+  utl::initialize_arrow_compute();
+
+  auto selection = filter::selection(*_arrow_tb, predicate);
+
+  // Null selections drop their rows
+  arrow::compute::ExecContext ctx{ttb::memory_pool()};
+  auto r_filtered = arrow::compute::Filter(_arrow_tb, selection,
+                                           arrow::compute::FilterOptions::Defaults(), &ctx);
+  ttb::throw_if_budget_exceeded(r_filtered.status());
+  if (!r_filtered.ok())
+    throw ttb::AnalyticTableError(r_filtered.status().ToString());
+
+  auto filtered = r_filtered.MoveValueUnsafe().table();
+  return AnalyticTable{std::move(filtered)};
+}
+
+void ttb::AnalyticTable::filter(const arrow::compute::Expression &predicate) {
+  TTB_TIMED_SCOPE("AnalyticTable::filter");
+  TTB_COUNT_ROWS(this->n_rows());
+
+  /// Required by arrow for some compute functions
+  utl::initialize_arrow_compute();
+
+  auto selection = filter::selection(*_arrow_tb, predicate);
+  filter::keep_selected(_arrow_tb, selection, FILTER_MAX_SLICES);
+}
+
+void ttb::AnalyticTable::drop_nulls(const std::vector<std::string> &col_names) {
+  TTB_TIMED_SCOPE("AnalyticTable::drop_nulls");
+  TTB_COUNT_ROWS(this->n_rows());
+
+  std::vector<int> indices;
+  for (const auto &name : col_names) {
+    auto index = this->col_index(name);
+    if (!index.has_value())
+      throw ttb::AnalyticTableError("Column not found: " + name);
+    indices.emplace_back(index.value());
+  }
+  if (col_names.empty())
+    for (int j{0}; j < this->n_cols(); ++j)
+      indices.emplace_back(j);
+
+  auto has_nulls = [&](int j) { return _arrow_tb->column(j)->null_count() != 0; };
+  if (std::ranges::none_of(indices, has_nulls))
+    return;
+
+  /// Required by arrow for some compute functions
+  utl::initialize_arrow_compute();
+
+  auto selection = filter::valid_rows(*_arrow_tb, indices);
+  filter::keep_selected(_arrow_tb, selection, FILTER_MAX_SLICES);
+}
+
+namespace drop_duplicates {
+
+/// Minimum number of rows handled by each parallel task, a whole number of selection bytes
+constexpr int64_t GRAIN_ROWS{1 << 14};
+
+utl::RowKeys row_keys(const arrow::Table &table, const std::vector<int> &indices) {
+  auto r_keys = utl::RowKeys::Make(table, indices, ttb::memory_pool());
+  ttb::throw_if_budget_exceeded(r_keys.status());
+  if (!r_keys.ok())
+    throw ttb::AnalyticTableError(r_keys.status().ToString());
+
+  return r_keys.MoveValueUnsafe();
+}
+
+/// Uninitialized room for n values of T, from the caller's pool so that its budget applies
+template <typename T>
+utl::shp<arrow::Buffer> allocate(int64_t n, arrow::MemoryPool *pool) {
+  auto r_buffer = arrow::AllocateBuffer(n * static_cast<int64_t>(sizeof(T)), pool);
+  ttb::throw_if_budget_exceeded(r_buffer.status());
+  if (!r_buffer.ok())
+    throw ttb::AnalyticTableError(r_buffer.status().ToString());
+
+  return r_buffer.MoveValueUnsafe();
+}
+
+/// Rows of every hash partition, ascending, partition p spanning [offsets[p], offsets[p + 1])
+template <typename Row>
+struct Partitions {
+    utl::shp<arrow::Buffer> rows;
+    std::vector<int64_t> offsets;
+};
+
+/**
+ * @brief Rows of every hash partition, as Row (32 bits whenever the table allows). Every task
+ * counts then scatters the rows of a contiguous range, so partitions are filled in parallel and
+ * in row order
+ *
+ */
+template <typename Row>
+Partitions<Row> partition_rows(const utl::RowKeys &keys, int64_t n_partitions,
+                               arrow::MemoryPool *pool) {
+  auto n_rows = keys.n_rows();
+  auto n_tasks = std::clamp<int64_t>(n_rows / GRAIN_ROWS, 1, at::get_num_threads());
+  auto task_rows = (n_rows + n_tasks - 1) / n_tasks;
+  auto task_range = [&](int64_t t) {
+    return std::pair{t * task_rows, std::min(n_rows, (t + 1) * task_rows)};
+  };
+
+  std::vector<int64_t> offsets(n_tasks * n_partitions, 0);
+  at::parallel_for(0, n_tasks, 1, [&](int64_t begin, int64_t end) {
+    for (auto t{begin}; t < end; ++t) {
+      auto [row_begin, row_end] = task_range(t);
+      for (auto i{row_begin}; i < row_end; ++i)
+        ++offsets[t * n_partitions + keys.hash(i) % n_partitions];
+    }
+  });
+
+  // Counts become the position of the first row of every task in every partition
+  Partitions<Row> resp{allocate<Row>(n_rows, pool), std::vector<int64_t>(n_partitions + 1, 0)};
+  int64_t position{0};
+  for (int64_t p{0}; p < n_partitions; ++p) {
+    resp.offsets[p] = position;
+    for (int64_t t{0}; t < n_tasks; ++t)
+      position += std::exchange(offsets[t * n_partitions + p], position);
+  }
+  resp.offsets[n_partitions] = position;
+
+  auto *rows = reinterpret_cast<Row *>(resp.rows->mutable_data());
+  at::parallel_for(0, n_tasks, 1, [&](int64_t begin, int64_t end) {
+    for (auto t{begin}; t < end; ++t) {
+      auto [row_begin, row_end] = task_range(t);
+      for (auto i{row_begin}; i < row_end; ++i)
+        rows[offsets[t * n_partitions + keys.hash(i) % n_partitions]++] = static_cast<Row>(i);
+    }
+  });
+
+  return resp;
+}
+
+/**
+ * @brief Sets the selection bit of the first (or, scanning backwards, last) row of every distinct
+ * key of a partition. Rows are inserted in an open-addressing table of row indices, at most half
+ * full, so no per-key allocation is made however many distinct keys there are
+ *
+ */
+template <typename Row>
+void mark_distinct(const utl::RowKeys &keys, const Row *rows, int64_t n_rows, ttb::Keep keep,
+                   uint8_t *bits, arrow::MemoryPool *pool) {
+  constexpr auto EMPTY = std::numeric_limits<Row>::max();
+  auto n_bits = std::bit_width(std::max<uint64_t>(2 * n_rows, 2) - 1);
+  auto mask = (uint64_t{1} << n_bits) - 1;
+  auto slots_buffer = allocate<Row>(static_cast<int64_t>(mask + 1), pool);
+  auto *slots = reinterpret_cast<Row *>(slots_buffer->mutable_data());
+  std::fill_n(slots, mask + 1, EMPTY);
+
+  auto insert = [&](Row i) {
+    auto hash = keys.hash(i);
+    // Partitions share their low hash bits, slots come from the high ones
+    for (auto s = hash >> (64 - n_bits);; s = (s + 1) & mask) {
+      auto row = slots[s];
+      if (row == EMPTY) {
+        slots[s] = i;
+        // Rows of other partitions, marked concurrently, share the byte
+        std::atomic_ref<uint8_t>{bits[i / 8]}.fetch_or(arrow::bit_util::kBitmask[i % 8],
+                                                       std::memory_order_relaxed);
+        return;
+      }
+      if (keys.hash(row) == hash && keys.equal(i, keys, row))
+        return;
+    }
+  };
+
+  std::span<const Row> partition{rows, static_cast<size_t>(n_rows)};
+  if (keep == ttb::Keep::FIRST)
+    std::ranges::for_each(partition, insert);
+  else
+    std::ranges::for_each(partition | std::views::reverse, insert);
+}
+
+/// Marks of every hash partition, each partition deduplicated by its own task
+template <typename Row>
+void mark_partitions(const utl::RowKeys &keys, ttb::Keep keep, uint8_t *bits) {
+  // Worker threads do not inherit the caller's MemoryPoolScope
+  auto *pool = ttb::memory_pool();
+  auto partitions = partition_rows<Row>(keys, std::max(1, at::get_num_threads()), pool);
+  const auto *rows = reinterpret_cast<const Row *>(partitions.rows->data());
+  auto n_partitions = static_cast<int64_t>(partitions.offsets.size()) - 1;
+
+  // Partitions hold disjoint keys, so each task marks its rows unlocked
+  at::parallel_for(0, n_partitions, 1, [&](int64_t begin, int64_t end) {
+    for (auto p{begin}; p < end; ++p) {
+      auto offset = partitions.offsets[p];
+      mark_distinct(keys, rows + offset, partitions.offsets[p + 1] - offset, keep, bits, pool);
+    }
+  });
+}
+
+/**
+ * @brief Whether sorting on a key column leaves equal keys in runs of equal bytes. Not so for
+ * floating point keys: sorting treats -0.0 and 0.0 (and NaNs of any payload) as equal and leaves
+ * them interleaved, while keys compare bytewise
+ *
+ */
+bool sorts_into_runs(const arrow::DataType &type) {
+  const auto &value_type = type.id() == arrow::Type::DICTIONARY
+                               ? *static_cast<const arrow::DictionaryType &>(type).value_type()
+                               : type;
+  return !arrow::is_floating(value_type.id());
+}
+
+/// Same marks when equal keys are adjacent, as in a table sorted on them
+void mark_runs(const utl::RowKeys &keys, ttb::Keep keep, uint8_t *bits) {
+  auto n_rows = keys.n_rows();
+  auto step = keep == ttb::Keep::FIRST ? int64_t{-1} : int64_t{1};
+  // Every task sets whole bytes
+  auto n_bytes = arrow::bit_util::BytesForBits(n_rows);
+  at::parallel_for(0, n_bytes, GRAIN_ROWS / 8, [&](int64_t begin, int64_t end) {
+    for (auto i{begin * 8}; i < std::min(end * 8, n_rows); ++i) {
+      auto neighbour = i + step;
+      arrow::bit_util::SetBitTo(bits, i,
+                                neighbour < 0 || neighbour >= n_rows ||
+                                    !keys.equal(i, keys, neighbour));
+    }
+  });
+}
+
+} // namespace drop_duplicates
+
+utl::shp<arrow::BooleanArray> ttb::AnalyticTable::unique_rows(const std::vector<std::string> &keys,
+                                                              ttb::Keep keep) const {
+  TTB_TIMED_SCOPE("AnalyticTable::unique_rows");
+  ttb::MemoryOperation memory_operation{"AnalyticTable::unique_rows"};
+  TTB_COUNT_ROWS(this->n_rows());
+
+  std::vector<int> indices;
+  for (const auto &key : keys) {
+    auto index = this->col_index(key);
+    if (!index.has_value())
+      throw ttb::AnalyticTableError("Column not found: " + key);
+    indices.emplace_back(index.value());
+  }
+  if (keys.empty())
+    for (int j{0}; j < this->n_cols(); ++j)
+      indices.emplace_back(j);
+
+  auto row_keys = drop_duplicates::row_keys(*_arrow_tb, indices);
   auto n_rows = this->n_rows();
+  auto r_bitmap = arrow::AllocateEmptyBitmap(n_rows, ttb::memory_pool());
+  ttb::throw_if_budget_exceeded(r_bitmap.status());
+  if (!r_bitmap.ok())
+    throw ttb::AnalyticTableError(r_bitmap.status().ToString());
+
+  utl::shp<arrow::Buffer> bitmap = r_bitmap.MoveValueUnsafe();
+  auto *bits = bitmap->mutable_data();
+  auto sorted_column = _sorted_column.lock();
+  if (indices.size() == 1 && sorted_column && sorted_column == _arrow_tb->column(indices[0]) &&
+      drop_duplicates::sorts_into_runs(*sorted_column->type()))
+    drop_duplicates::mark_runs(row_keys, keep, bits);
+  else if (std::cmp_less(n_rows, std::numeric_limits<uint32_t>::max()))
+    drop_duplicates::mark_partitions<uint32_t>(row_keys, keep, bits);
+  else
+    drop_duplicates::mark_partitions<int64_t>(row_keys, keep, bits);
+
+  return std::make_shared<arrow::BooleanArray>(n_rows, std::move(bitmap));
+}
+
+ttb::AnalyticTable ttb::AnalyticTable::deduplicated(const std::vector<std::string> &keys,
+                                                    ttb::Keep keep) const {
+  auto selection = this->unique_rows(keys, keep);
+
+  arrow::compute::ExecContext ctx{ttb::memory_pool()};
+  auto r_filtered = arrow::compute::Filter(_arrow_tb, selection,
+                                           arrow::compute::FilterOptions::Defaults(), &ctx);
+  ttb::throw_if_budget_exceeded(r_filtered.status());
+  if (!r_filtered.ok())
+    throw ttb::AnalyticTableError(r_filtered.status().ToString());
+
+  auto deduplicated = r_filtered.MoveValueUnsafe().table();
+  return AnalyticTable{std::move(deduplicated)};
+}
+
+void ttb::AnalyticTable::drop_duplicates(const std::vector<std::string> &keys, ttb::Keep keep) {
+  auto selection = std::make_shared<arrow::ChunkedArray>(this->unique_rows(keys, keep));
+
+  // Dropping rows keeps the others in order, sorted ones included
+  auto sorted_column = _sorted_column.lock();
+  auto sorted_index = std::optional<int>{};
+  for (int j{0}; sorted_column && j < this->n_cols() && !sorted_index.has_value(); ++j)
+    if (sorted_column == _arrow_tb->column(j))
+      sorted_index = j;
+
+  filter::keep_selected(_arrow_tb, selection, FILTER_MAX_SLICES);
+  if (sorted_index.has_value())
+    _sorted_column = _arrow_tb->column(sorted_index.value());
+}
+
+namespace join {
+
+/// Minimum number of left rows probed by each parallel task
+constexpr int64_t GRAIN_ROWS{1 << 14};
+
+using Buckets = std::unordered_map<uint64_t, std::vector<int64_t>>;
+
+/// Matching row pairs; right rows are -1 for unmatched left rows of a LEFT join
+struct Matches {
+    std::vector<int64_t> left;
+    std::vector<int64_t> right;
+};
+
+/// Type of the values of a key column, so that dictionary keys match plain keys of their values
+const arrow::DataType &value_type(const arrow::DataType &type) {
+  if (type.id() != arrow::Type::DICTIONARY)
+    return type;
+
+  return *static_cast<const arrow::DictionaryType &>(type).value_type();
+}
+
+utl::RowKeys row_keys(const arrow::Table &table, const std::vector<std::string> &keys) {
+  std::vector<int> indices;
+  indices.reserve(keys.size());
+  for (const auto &key : keys) {
+    auto index = table.schema()->GetFieldIndex(key);
+    if (index < 0)
+      throw ttb::AnalyticTableError("Join key not found: " + key);
+    indices.emplace_back(index);
+  }
+
+  auto r_keys = utl::RowKeys::Make(table, indices, ttb::memory_pool());
+  ttb::throw_if_budget_exceeded(r_keys.status());
+  if (!r_keys.ok())
+    throw ttb::AnalyticTableError(r_keys.status().ToString());
+
+  return r_keys.MoveValueUnsafe();
+}
+
+/// Right rows with non-null keys, bucketed by key hash within each partition
+std::vector<Buckets> build(const utl::RowKeys &right, int64_t n_partitions) {
+  std::vector<std::vector<int64_t>> partition_rows(n_partitions);
+  for (int64_t j{0}; j < right.n_rows(); ++j)
+    if (!right.has_null(j))
+      partition_rows[right.hash(j) % n_partitions].emplace_back(j);
+
+  std::vector<Buckets> resp(n_partitions);
+  at::parallel_for(0, n_partitions, 1, [&](int64_t begin, int64_t end) {
+    for (auto p{begin}; p < end; ++p) {
+      resp[p].reserve(partition_rows[p].size());
+      for (auto j : partition_rows[p])
+        resp[p][right.hash(j)].emplace_back(j);
+    }
+  });
+
+  return resp;
+}
 
-  arrow::Int64Builder b;
-  auto status = b.Resize(n_rows);
+Matches probe(const utl::RowKeys &left, const utl::RowKeys &right,
+              const std::vector<Buckets> &partitions, ttb::JoinType type) {
+  auto n_partitions = static_cast<int64_t>(partitions.size());
+  auto n_tasks = (left.n_rows() + GRAIN_ROWS - 1) / GRAIN_ROWS;
+  std::vector<Matches> task_matches(n_tasks);
+
+  at::parallel_for(0, n_tasks, 1, [&](int64_t task_begin, int64_t task_end) {
+    for (auto t{task_begin}; t < task_end; ++t) {
+      auto &matches = task_matches[t];
+      auto row_end = std::min(left.n_rows(), (t + 1) * GRAIN_ROWS);
+      for (auto i{t * GRAIN_ROWS}; i < row_end; ++i) {
+        auto matched{false};
+        if (!left.has_null(i)) {
+          const auto &buckets = partitions[left.hash(i) % n_partitions];
+          if (auto it = buckets.find(left.hash(i)); it != buckets.end())
+            for (auto j : it->second)
+              if (left.equal(i, right, j)) {
+                matches.left.emplace_back(i);
+                matches.right.emplace_back(j);
+                matched = true;
+              }
+        }
+        if (!matched && type == ttb::JoinType::LEFT) {
+          matches.left.emplace_back(i);
+          matches.right.emplace_back(-1);
+        }
+      }
+    }
+  });
+
+  // Tasks cover consecutive row ranges, so concatenating them keeps the left order
+  Matches resp;
+  for (auto &matches : task_matches) {
+    resp.left.insert(resp.left.end(), matches.left.begin(), matches.left.end());
+    resp.right.insert(resp.right.end(), matches.right.begin(), matches.right.end());
+  }
+
+  return resp;
+}
+
+utl::shp<arrow::Array> indices_array(const std::vector<int64_t> &rows) {
+  arrow::Int64Builder b(ttb::memory_pool());
+  auto status = b.Reserve(static_cast<int64_t>(rows.size()));
+  ttb::throw_if_budget_exceeded(status);
   if (!status.ok())
-    throw AnalyticTableError(status.ToString());
+    throw ttb::AnalyticTableError(status.ToString());
+
+  for (auto row : rows)
+    if (row < 0)
+      b.UnsafeAppendNull();
+    else
+      b.UnsafeAppend(row);
 
-  for (int64_t i{0}; i < n_rows; ++i)
-    b.UnsafeAppend(i);
   auto r_indices = b.Finish();
   if (!r_indices.ok())
-    throw AnalyticTableError(r_indices.status().ToString());
+    throw ttb::AnalyticTableError(r_indices.status().ToString());
+
+  return r_indices.MoveValueUnsafe();
+}
 
-  auto r_datum = arrow::compute::Take(_arrow_tb, r_indices.ValueUnsafe());
+/// Rows of the table at the given positions; null positions give rows of nulls
+utl::shp<arrow::Table> take(const utl::shp<arrow::Table> &table,
+                            const std::vector<int64_t> &rows) {
+  arrow::compute::ExecContext ctx{ttb::memory_pool()};
+  auto r_datum = arrow::compute::Take(table, indices_array(rows),
+                                      arrow::compute::TakeOptions::NoBoundsCheck(), &ctx);
+  ttb::throw_if_budget_exceeded(r_datum.status());
   if (!r_datum.ok())
-    throw AnalyticTableError(r_datum.status().ToString());
+    throw ttb::AnalyticTableError(r_datum.status().ToString());
 
-  auto table = r_datum.MoveValueUnsafe();
+  return r_datum.MoveValueUnsafe().table();
+}
+
+bool is_identity(const std::vector<int64_t> &rows, int64_t n_rows) {
+  if (std::cmp_not_equal(rows.size(), n_rows))
+    return false;
 
-  auto aux = table.table();
+  for (int64_t i{0}; i < n_rows; ++i)
+    if (rows[i] != i)
+      return false;
+
+  return true;
+}
+
+} // namespace join
+
+ttb::AnalyticTable ttb::AnalyticTable::joined(const AnalyticTable &right,
+                                              const std::vector<std::string> &keys,
+                                              ttb::JoinType type,
+                                              ttb::JoinStrategy strategy) const {
+  TTB_TIMED_SCOPE("AnalyticTable::join");
+  ttb::MemoryOperation memory_operation{"AnalyticTable::join"};
+  TTB_COUNT_ROWS(this->n_rows() + right.n_rows());
+  if (keys.empty())
+    throw AnalyticTableError("No join keys");
+
+  /// Required by arrow for some compute functions
+  utl::initialize_arrow_compute();
+
+  auto left_keys = join::row_keys(*_arrow_tb, keys);
+  auto right_keys = join::row_keys(*right.arrow_table(), keys);
+  for (size_t k{0}; k < keys.size(); ++k)
+    if (!join::value_type(*left_keys.columns()[k]->type())
+             .Equals(join::value_type(*right_keys.columns()[k]->type())))
+      throw AnalyticTableError("Join key types differ: " + keys[k]);
+
+  if (strategy == ttb::JoinStrategy::AUTO)
+    strategy = right.n_rows() <= BROADCAST_MAX_ROWS ? ttb::JoinStrategy::BROADCAST
+                                                    : ttb::JoinStrategy::PARTITIONED;
+  auto n_partitions =
+      strategy == ttb::JoinStrategy::BROADCAST ? int64_t{1} : int64_t{at::get_num_threads()};
+
+  auto partitions = join::build(right_keys, n_partitions);
+  auto matches = join::probe(left_keys, right_keys, partitions, type);
+
+  auto left_rows = join::is_identity(matches.left, this->n_rows())
+                       ? _arrow_tb
+                       : join::take(_arrow_tb, matches.left);
+
+  std::vector<int> right_indices;
+  for (int j{0}; j < right.n_cols(); ++j)
+    if (std::ranges::find(keys, right.arrow_table()->field(j)->name()) == keys.end())
+      right_indices.emplace_back(j);
+  auto r_right_cols = right.arrow_table()->SelectColumns(right_indices);
+  if (!r_right_cols.ok())
+    throw AnalyticTableError(r_right_cols.status().ToString());
+  auto right_rows = r_right_cols.MoveValueUnsafe();
+  if (!right_indices.empty())
+    right_rows = join::take(right_rows, matches.right);
+
+  auto fields = left_rows->schema()->fields();
+  auto columns = left_rows->columns();
+  for (int j{0}; j < right_rows->num_columns(); ++j) {
+    auto field = right_rows->field(j);
+    if (left_rows->schema()->GetFieldIndex(field->name()) >= 0)
+      field = field->WithName(field->name() + "_right");
+    fields.emplace_back(std::move(field));
+    columns.emplace_back(right_rows->column(j));
+  }
+
+  auto n_rows = static_cast<int64_t>(matches.left.size());
+  return AnalyticTable{arrow::Table::Make(arrow::schema(fields), columns, n_rows)};
+}
+
+void ttb::AnalyticTable::join(const AnalyticTable &right, const std::vector<std::string> &keys,
+                              ttb::JoinType type, ttb::JoinStrategy strategy) {
+  auto joined = this->joined(right, keys, type, strategy);
+
+  _arrow_tb = std::move(joined._arrow_tb);
+}
 
-  return AnalyticTable{std::move(aux)};
+ttb::GroupBy ttb::AnalyticTable::group_by(const std::vector<std::string> &keys) const {
+  return ttb::GroupBy{*this, keys};
 }
@@ -1,6 +1,14 @@
 #include "AnalyticTableNumeric.h"
+#include "Instrumentation.h"
+#include "MemoryPool.h"
 
+#include <ATen/Parallel.h>
 #include <algorithm>
+#include <arrow/compute/api.h>
+#include <arrow/util/bitmap_ops.h>
+#include <cmath>
+#include <optional>
+#include <type_traits>
 
 namespace to_dtype {
 
@@ -10,12 +18,21 @@ void cast_table(utl::shp<arrow::Table> &arrow_tb, utl::shp<arrow::DataType> type
   for (int i{0}; i < arrow_tb->num_columns(); ++i) {
     auto column = arrow_tb->column(i);
 
+    /// Columns parsed or built directly as the target type are kept as they are
+    if (column->type()->Equals(type)) {
+      casted_fields.emplace_back(arrow_tb->field(i));
+      casted_columns.emplace_back(std::move(column));
+      continue;
+    }
+
     arrow::compute::CastOptions cast_options;
     cast_options.to_type = type;
     cast_options.allow_int_overflow = false;
     cast_options.allow_float_truncate = true;
 
-    auto casted_datum = arrow::compute::Cast(arrow::Datum(column), cast_options);
+    arrow::compute::ExecContext ctx{ttb::memory_pool()};
+    auto casted_datum = arrow::compute::Cast(arrow::Datum(column), cast_options, &ctx);
+    ttb::throw_if_budget_exceeded(casted_datum.status());
     if (!casted_datum.ok())
       throw ttb::AnalyticTableNumericError{casted_datum.status().ToString()};
 
@@ -32,6 +49,10 @@ void cast_table(utl::shp<arrow::Table> &arrow_tb, utl::shp<arrow::DataType> type
 
 template <utl::NumericType T>
 void ttb::AnalyticTableNumeric<T>::to_dtype() {
+  TTB_TIMED_SCOPE("AnalyticTableNumeric::to_dtype");
+  ttb::MemoryOperation memory_operation{"AnalyticTableNumeric::to_dtype"};
+  TTB_COUNT_ROWS(this->n_rows());
+  TTB_COUNT_BYTES(this->n_rows() * this->n_cols() * static_cast<int64_t>(sizeof(T)));
   to_dtype::cast_table(_arrow_tb, utl::arrow_dtype<T>());
 }
 
@@ -61,8 +82,9 @@ make_fields_columns(const std::unordered_map<std::string, std::vector<T>> &field
   for (auto &[field, col_data] : field_col_data) {
     fields.emplace_back(arrow::field(field, dtype));
 
-    auto builder = utl::new_unp<utl::ArrowBuilderType<T>>(arrow::default_memory_pool());
+    auto builder = utl::new_unp<utl::ArrowBuilderType<T>>(ttb::memory_pool());
     auto status = builder->Resize(n_rows);
+    ttb::throw_if_budget_exceeded(status);
     if (!status.ok())
       throw ttb::AnalyticTableError("Could not mount arrow column!");
 
@@ -137,7 +159,8 @@ fragment_columns(const utl::shp<arrow::Table> &arrow_tb) {
 
   for (int64_t j{0}; j < n_cols; ++j) {
     auto chunks = arrow_tb->column(static_cast<int>(j))->chunks();
-    auto maybe_arr = arrow::Concatenate(chunks, arrow::default_memory_pool());
+    auto maybe_arr = arrow::Concatenate(chunks, ttb::memory_pool());
+    ttb::throw_if_budget_exceeded(maybe_arr.status());
     if (!maybe_arr.ok())
       throw ttb::AnalyticTableNumericError(maybe_arr.status().ToString());
     auto arr = std::static_pointer_cast<utl::ArrowArrayType<T>>(*maybe_arr);
@@ -189,9 +212,177 @@ std::vector<int64_t> ttb::AnalyticTableNumeric<T>::argmax(Axis axis) const {
   }
 }
 
+namespace fill_nulls {
+
+template <utl::NumericType T>
+T from_double(double value) {
+  if constexpr (std::is_integral_v<T>)
+    return static_cast<T>(std::llround(value));
+  else
+    return static_cast<T>(value);
+}
+
+/// Non-null mean or median of the column, or nothing when it has no values
+template <utl::NumericType T>
+std::optional<T> statistic(const utl::shp<arrow::ChunkedArray> &column,
+                           ttb::FillStrategy strategy) {
+  arrow::compute::ExecContext ctx{ttb::memory_pool()};
+  auto r_stat = strategy == ttb::FillStrategy::MEAN
+                    ? arrow::compute::Mean(column, arrow::compute::ScalarAggregateOptions{}, &ctx)
+                    : arrow::compute::Quantile(column, arrow::compute::QuantileOptions{0.5}, &ctx);
+  ttb::throw_if_budget_exceeded(r_stat.status());
+  if (!r_stat.ok())
+    throw ttb::AnalyticTableNumericError(r_stat.status().ToString());
+
+  // Mean gives a scalar, Quantile an array holding at most one value
+  auto stat = r_stat.MoveValueUnsafe();
+  utl::shp<arrow::Scalar> scalar;
+  if (stat.is_scalar())
+    scalar = stat.scalar();
+  else if (stat.length() > 0) {
+    auto r_scalar = stat.make_array()->GetScalar(0);
+    if (!r_scalar.ok())
+      throw ttb::AnalyticTableNumericError(r_scalar.status().ToString());
+    scalar = r_scalar.MoveValueUnsafe();
+  }
+  if (scalar == nullptr || !scalar->is_valid)
+    return std::nullopt;
+
+  auto r_double = scalar->CastTo(arrow::float64());
+  if (!r_double.ok())
+    throw ttb::AnalyticTableNumericError(r_double.status().ToString());
+
+  return from_double<T>(std::static_pointer_cast<arrow::DoubleScalar>(*r_double)->value);
+}
+
+utl::shp<arrow::ChunkedArray> call(const std::string &function,
+                                   const std::vector<arrow::Datum> &args) {
+  arrow::compute::ExecContext ctx{ttb::memory_pool()};
+  auto r_filled = arrow::compute::CallFunction(function, args, &ctx);
+  ttb::throw_if_budget_exceeded(r_filled.status());
+  if (!r_filled.ok())
+    throw ttb::AnalyticTableNumericError(r_filled.status().ToString());
+
+  return r_filled.MoveValueUnsafe().chunked_array();
+}
+
+} // namespace fill_nulls
+
+template <utl::NumericType T>
+T ttb::AnalyticTableNumeric<T>::null_fill(int col_index, ttb::FillStrategy strategy,
+                                          T value) const {
+  if (col_index < 0 || col_index >= this->n_cols())
+    throw ttb::AnalyticTableNumericError("col_index out of bounds");
+  if (strategy == ttb::FillStrategy::CONSTANT || strategy == ttb::FillStrategy::FORWARD)
+    return value;
+
+  return fill_nulls::statistic<T>(_arrow_tb->column(col_index), strategy).value_or(value);
+}
+
+template <utl::NumericType T>
+void ttb::AnalyticTableNumeric<T>::fill_nulls(ttb::FillStrategy strategy, T value) {
+  TTB_TIMED_SCOPE("AnalyticTableNumeric::fill_nulls");
+  ttb::MemoryOperation memory_operation{"AnalyticTableNumeric::fill_nulls"};
+  TTB_COUNT_ROWS(this->n_rows());
+
+  /// Required by arrow for some compute functions
+  utl::initialize_arrow_compute();
+
+  /// Worker threads do not inherit the caller's MemoryPoolScope
+  auto pool = ttb::memory_pool();
+
+  auto columns = _arrow_tb->columns();
+  at::parallel_for(0, this->n_cols(), 1, [&](int64_t begin, int64_t end) {
+    ttb::MemoryPoolScope pool_scope{pool};
+    for (auto j{begin}; j < end; ++j) {
+      auto &column = columns[j];
+      if (column->null_count() == 0)
+        continue;
+
+      auto fill = arrow::MakeScalar(this->null_fill(static_cast<int>(j), strategy, value));
+      if (strategy == ttb::FillStrategy::FORWARD)
+        column = fill_nulls::call("fill_null_forward", {column});
+      column = fill_nulls::call("coalesce", {column, fill});
+    }
+  });
+
+  _arrow_tb = arrow::Table::Make(_arrow_tb->schema(), std::move(columns), this->n_rows());
+}
+
+template <utl::NumericType T>
+ttb::Binner ttb::AnalyticTableNumeric<T>::fit_binner(int col_index, ttb::Binning binning,
+                                                     int n_bins) const {
+  if (col_index < 0 || col_index >= this->n_cols())
+    throw ttb::AnalyticTableNumericError("col_index out of bounds");
+
+  ttb::Binner resp{binning, n_bins};
+  resp.update(*_arrow_tb->column(col_index));
+
+  return resp;
+}
+
+namespace bin {
+
+/// Bin indices of a chunk in a new buffer, sharing or re-basing its validity bitmap
+template <utl::NumericType T>
+utl::shp<arrow::Array> binned_chunk(const utl::shp<arrow::Array> &chunk,
+                                    const ttb::Binner &binner) {
+  auto n_rows = chunk->length();
+  auto r_values = arrow::AllocateBuffer(n_rows * static_cast<int64_t>(sizeof(T)),
+                                        ttb::memory_pool());
+  ttb::throw_if_budget_exceeded(r_values.status());
+  if (!r_values.ok())
+    throw ttb::AnalyticTableNumericError(r_values.status().ToString());
+
+  utl::shp<arrow::Buffer> values = r_values.MoveValueUnsafe();
+  auto typed = std::static_pointer_cast<utl::ArrowArrayType<T>>(chunk);
+  binner.transform(typed->raw_values(), reinterpret_cast<T *>(values->mutable_data()), n_rows);
+
+  utl::shp<arrow::Buffer> validity;
+  if (chunk->null_count() != 0) {
+    auto r_validity = arrow::internal::CopyBitmap(ttb::memory_pool(), chunk->null_bitmap_data(),
+                                                  chunk->offset(), n_rows);
+    ttb::throw_if_budget_exceeded(r_validity.status());
+    if (!r_validity.ok())
+      throw ttb::AnalyticTableNumericError(r_validity.status().ToString());
+    validity = r_validity.MoveValueUnsafe();
+  }
+
+  return std::make_shared<utl::ArrowArrayType<T>>(n_rows, std::move(values), std::move(validity),
+                                                  chunk->null_count());
+}
+
+} // namespace bin
+
+template <utl::NumericType T>
+void ttb::AnalyticTableNumeric<T>::bin(int col_index, const ttb::Binner &binner) {
+  TTB_TIMED_SCOPE("AnalyticTableNumeric::bin");
+  ttb::MemoryOperation memory_operation{"AnalyticTableNumeric::bin"};
+  TTB_COUNT_ROWS(this->n_rows());
+  if (col_index < 0 || col_index >= this->n_cols())
+    throw ttb::AnalyticTableNumericError("col_index out of bounds");
+
+  arrow::ArrayVector chunks;
+  for (const auto &chunk : _arrow_tb->column(col_index)->chunks())
+    chunks.emplace_back(bin::binned_chunk<T>(chunk, binner));
+
+  auto column = std::make_shared<arrow::ChunkedArray>(std::move(chunks), utl::arrow_dtype<T>());
+  auto r_table = _arrow_tb->SetColumn(col_index, _arrow_tb->field(col_index), std::move(column));
+  if (!r_table.ok())
+    throw ttb::AnalyticTableNumericError(r_table.status().ToString());
+
+  _arrow_tb = r_table.MoveValueUnsafe();
+}
+
+template <utl::NumericType T>
+void ttb::AnalyticTableNumeric<T>::one_hot_expand(int col_index, std::optional<int> top_k) {
+  ttb::AnalyticTable::one_hot_expand(col_index, top_k);
+  this->to_dtype();
+}
+
 template <utl::NumericType T>
-void ttb::AnalyticTableNumeric<T>::one_hot_expand(int col_index) {
-  ttb::AnalyticTable::one_hot_expand(col_index);
+void ttb::AnalyticTableNumeric<T>::hash_expand(int col_index, const ttb::HashingEncoder &encoder) {
+  ttb::AnalyticTable::hash_expand(col_index, encoder);
   this->to_dtype();
 }
 
@@ -0,0 +1,228 @@
+#include "Binner.h"
+#include "Instrumentation.h"
+#include "MemoryPool.h"
+
+#include <ATen/Parallel.h>
+#include <algorithm>
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <cmath>
+#include <string>
+#include <type_traits>
+
+namespace binner {
+
+/// Minimum number of values handled by each parallel task
+constexpr int64_t GRAIN_VALUES{1 << 15};
+
+/// Values seen by one parallel task of Binner::update
+struct Partial {
+    int64_t count{0};
+    double min{std::numeric_limits<double>::infinity()};
+    double max{-std::numeric_limits<double>::infinity()};
+    utl::KllSketch sketch;
+
+    explicit Partial(int sketch_k) : sketch{sketch_k} {}
+};
+
+/**
+ * @brief Index of the bin of value among the n_inner edges between bins: the number of inner
+ * edges not above it. The binary search compiles to conditional moves, without branches to
+ * mispredict
+ *
+ */
+inline int64_t search(const double *inner, int64_t n_inner, double value) {
+  if (n_inner == 0)
+    return 0;
+
+  const auto *base = inner;
+  auto n = n_inner;
+  while (n > 1) {
+    auto half = n / 2;
+    base = base[half] <= value ? base + half : base;
+    n -= half;
+  }
+
+  return (base - inner) + (*base <= value ? 1 : 0);
+}
+
+template <utl::NumericType T>
+bool is_nan(T value) {
+  if constexpr (std::is_floating_point_v<T>)
+    return std::isnan(value);
+  else
+    return false;
+}
+
+} // namespace binner
+
+ttb::Binner::Binner(ttb::Binning binning, int n_bins, int sketch_k)
+    : _binning{binning}, _n_bins{n_bins}, _sketch_k{sketch_k}, _sketch{sketch_k} {
+  if (binning == ttb::Binning::CUSTOM)
+    throw ttb::BinnerError("CUSTOM binning takes edges");
+  if (n_bins < 1)
+    throw ttb::BinnerError("Number of bins must be positive");
+}
+
+ttb::Binner::Binner(std::vector<double> edges)
+    : _binning{ttb::Binning::CUSTOM}, _n_bins{static_cast<int>(edges.size()) - 1},
+      _edges{std::move(edges)} {
+  if (_edges.size() < 2)
+    throw ttb::BinnerError("At least two edges are needed");
+  auto is_nan = [](double edge) { return std::isnan(edge); };
+  if (std::ranges::any_of(_edges, is_nan) || !std::ranges::is_sorted(_edges))
+    throw ttb::BinnerError("Edges are not ascending");
+}
+
+template <utl::NumericType T>
+void ttb::Binner::update(const T *values, int64_t n_values, int64_t stride) {
+  TTB_TIMED_SCOPE("Binner::update");
+  TTB_COUNT_ROWS(n_values);
+  if (_binning == ttb::Binning::CUSTOM || n_values <= 0)
+    return;
+
+  // One partial per task over contiguous ranges, merged in order afterwards
+  auto n_tasks = std::clamp<int64_t>(n_values / binner::GRAIN_VALUES, 1, at::get_num_threads());
+  auto task_values = (n_values + n_tasks - 1) / n_tasks;
+  auto quantile = _binning == ttb::Binning::QUANTILE;
+  std::vector<binner::Partial> partials(n_tasks, binner::Partial{_sketch_k});
+  at::parallel_for(0, n_tasks, 1, [&](int64_t begin, int64_t end) {
+    for (auto t{begin}; t < end; ++t) {
+      auto &partial = partials[t];
+      auto last = std::min(n_values, (t + 1) * task_values);
+      for (auto i{t * task_values}; i < last; ++i) {
+        auto value = values[i * stride];
+        if (binner::is_nan(value))
+          continue;
+        auto as_double = static_cast<double>(value);
+        ++partial.count;
+        partial.min = std::min(partial.min, as_double);
+        partial.max = std::max(partial.max, as_double);
+        if (quantile)
+          partial.sketch.update(as_double);
+      }
+    }
+  });
+
+  for (const auto &partial : partials) {
+    _count += partial.count;
+    _min = std::min(_min, partial.min);
+    _max = std::max(_max, partial.max);
+    if (quantile)
+      _sketch.merge(partial.sketch);
+  }
+}
+
+void ttb::Binner::update(const arrow::ChunkedArray &values) {
+  arrow::compute::ExecContext ctx{ttb::memory_pool()};
+  for (auto chunk : values.chunks()) {
+    if (chunk->null_count() != 0) {
+      auto r_valid = arrow::compute::DropNull(*chunk, &ctx);
+      ttb::throw_if_budget_exceeded(r_valid.status());
+      if (!r_valid.ok())
+        throw ttb::BinnerError(r_valid.status().ToString());
+      chunk = r_valid.MoveValueUnsafe();
+    }
+
+    switch (chunk->type_id()) {
+    case arrow::Type::INT32:
+      this->update(std::static_pointer_cast<arrow::Int32Array>(chunk)->raw_values(),
+                   chunk->length());
+      break;
+    case arrow::Type::INT64:
+      this->update(std::static_pointer_cast<arrow::Int64Array>(chunk)->raw_values(),
+                   chunk->length());
+      break;
+    case arrow::Type::FLOAT:
+      this->update(std::static_pointer_cast<arrow::FloatArray>(chunk)->raw_values(),
+                   chunk->length());
+      break;
+    case arrow::Type::DOUBLE:
+      this->update(std::static_pointer_cast<arrow::DoubleArray>(chunk)->raw_values(),
+                   chunk->length());
+      break;
+    default:
+      throw ttb::BinnerError("Unsupported column type: " + chunk->type()->ToString());
+    }
+  }
+}
+
+std::vector<double> ttb::Binner::edges() const {
+  if (_binning == ttb::Binning::CUSTOM)
+    return _edges;
+  if (_count == 0)
+    throw ttb::BinnerError("No values fitted");
+
+  std::vector<double> fractions(_n_bins + 1);
+  for (int b{0}; b <= _n_bins; ++b)
+    fractions[b] = static_cast<double>(b) / _n_bins;
+
+  if (_binning == ttb::Binning::QUANTILE)
+    return _sketch.quantiles(fractions);
+
+  std::vector<double> resp(_n_bins + 1);
+  for (int b{0}; b <= _n_bins; ++b)
+    resp[b] = _min + fractions[b] * (_max - _min);
+  resp.back() = _max;
+
+  return resp;
+}
+
+template <utl::NumericType T>
+void ttb::Binner::transform(const T *values, T *bins, int64_t n_values, int64_t stride) const {
+  TTB_TIMED_SCOPE("Binner::transform");
+  TTB_COUNT_ROWS(n_values);
+  auto edges = this->edges();
+  const auto *inner = edges.data() + 1;
+  auto n_inner = static_cast<int64_t>(edges.size()) - 2;
+
+  at::parallel_for(0, n_values, binner::GRAIN_VALUES, [&](int64_t begin, int64_t end) {
+    for (auto i{begin}; i < end; ++i)
+      bins[i * stride] = static_cast<T>(
+          binner::search(inner, n_inner, static_cast<double>(values[i * stride])));
+  });
+}
+
+template <utl::NumericType T>
+std::vector<int64_t> ttb::Binner::histogram(const T *values, int64_t n_values,
+                                            int64_t stride) const {
+  TTB_TIMED_SCOPE("Binner::histogram");
+  TTB_COUNT_ROWS(n_values);
+  auto edges = this->edges();
+  const auto *inner = edges.data() + 1;
+  auto n_inner = static_cast<int64_t>(edges.size()) - 2;
+
+  auto n_tasks = std::clamp<int64_t>(n_values / binner::GRAIN_VALUES, 1, at::get_num_threads());
+  auto task_values = (n_values + n_tasks - 1) / n_tasks;
+  std::vector<std::vector<int64_t>> counts(n_tasks, std::vector<int64_t>(_n_bins, 0));
+  at::parallel_for(0, n_tasks, 1, [&](int64_t begin, int64_t end) {
+    for (auto t{begin}; t < end; ++t) {
+      auto last = std::min(n_values, (t + 1) * task_values);
+      for (auto i{t * task_values}; i < last; ++i) {
+        auto value = values[i * stride];
+        if (!binner::is_nan(value))
+          ++counts[t][binner::search(inner, n_inner, static_cast<double>(value))];
+      }
+    }
+  });
+
+  std::vector<int64_t> resp(_n_bins, 0);
+  for (const auto &task_counts : counts)
+    for (int b{0}; b < _n_bins; ++b)
+      resp[b] += task_counts[b];
+
+  return resp;
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
+#define INSTANTIATE_BINNER_FUNCS(T)                                                                \
+  template void ttb::Binner::update(const T *, int64_t, int64_t);                                  \
+  template void ttb::Binner::transform(const T *, T *, int64_t, int64_t) const;                    \
+  template std::vector<int64_t> ttb::Binner::histogram(const T *, int64_t, int64_t) const;
+
+INSTANTIATE_BINNER_FUNCS(int)
+INSTANTIATE_BINNER_FUNCS(int64_t)
+INSTANTIATE_BINNER_FUNCS(float)
+INSTANTIATE_BINNER_FUNCS(double)
+
+#undef INSTANTIATE_BINNER_FUNCS
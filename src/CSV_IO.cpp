@@ -1,27 +1,119 @@
 #include "CSV_IO.h"
 #include "AnalyticTable.h"
 #include "AnalyticTableNumeric.h"
+#include "Instrumentation.h"
+#include "MemoryPool.h"
 #include "detail/utils.h"
 
+#include <ATen/Parallel.h>
+#include <algorithm>
+#include <array>
 #include <arrow/api.h>
+#include <arrow/compute/api.h>
 #include <arrow/csv/api.h>
 #include <arrow/csv/options.h>
 #include <arrow/csv/reader.h>
-#include <arrow/csv/writer.h>
 #include <arrow/io/api.h>
+#include <arrow/io/compressed.h>
 #include <arrow/io/file.h>
 #include <arrow/io/type_fwd.h>
 #include <arrow/table.h>
+#include <arrow/util/compression.h>
+#include <arrow/util/thread_pool.h>
+#include <charconv>
+#include <chrono>
 #include <expected>
+#include <future>
 #include <memory>
+#include <string_view>
+#include <system_error>
+
+namespace ccompression {
+
+arrow::Compression::type from_extension(const std::filesystem::path &path) {
+  auto extension = utl::to_lower(path.extension().string());
+  if (extension == ".gz")
+    return arrow::Compression::GZIP;
+  if (extension == ".zst" || extension == ".zstd")
+    return arrow::Compression::ZSTD;
+  if (extension == ".bz2")
+    return arrow::Compression::BZ2;
+  if (extension == ".lz4")
+    return arrow::Compression::LZ4_FRAME;
+
+  return arrow::Compression::UNCOMPRESSED;
+}
+
+arrow::Compression::type from_magic_bytes(arrow::io::RandomAccessFile &file) {
+  auto r_head = file.ReadAt(0, 10);
+  if (!r_head.ok())
+    throw ttb::CSV_IOError(r_head.status().ToString());
+
+  /// ReadAt leaves the stream in need of an explicit seek before it can be read sequentially
+  auto status = file.Seek(0);
+  if (!status.ok())
+    throw ttb::CSV_IOError(status.ToString());
+
+  auto head = r_head.MoveValueUnsafe()->ToString();
+  auto starts_with = [&head](std::string_view magic) { return head.starts_with(magic); };
+  if (starts_with("\x1f\x8b"))
+    return arrow::Compression::GZIP;
+  if (starts_with("\x28\xb5\x2f\xfd"))
+    return arrow::Compression::ZSTD;
+  /// "BZh", the block size digit and the magic of the first block (the BCD digits of pi), as
+  /// "BZh" alone is a plausible start of a plain text header
+  if (head.size() == 10 && starts_with("BZh") && head[3] >= '1' && head[3] <= '9' &&
+      head.substr(4) == "\x31\x41\x59\x26\x53\x59")
+    return arrow::Compression::BZ2;
+  if (starts_with("\x04\x22\x4d\x18"))
+    return arrow::Compression::LZ4_FRAME;
+
+  return arrow::Compression::UNCOMPRESSED;
+}
+
+/**
+ * @brief Compression of the file: the explicit one if set, otherwise inferred from the extension
+ * and, failing that, from the leading magic bytes
+ *
+ */
+arrow::Compression::type detect(const std::filesystem::path &path,
+                                arrow::io::RandomAccessFile &file,
+                                std::optional<arrow::Compression::type> compression) {
+  if (compression.has_value())
+    return *compression;
+
+  auto resp = from_extension(path);
+  return resp != arrow::Compression::UNCOMPRESSED ? resp : from_magic_bytes(file);
+}
+
+} // namespace ccompression
 
 namespace rread {
 
 utl::shp<arrow::Table> read_file(const std::filesystem::path &path, bool has_header,
-                                 char separator) {
-  auto infile = arrow::io::ReadableFile::Open(path);
-  if (!infile.ok())
-    throw ttb::CSV_IOError(infile.status().ToString());
+                                 char separator, const ttb::CSVOptions &options) {
+  auto r_infile = arrow::io::ReadableFile::Open(path);
+  if (!r_infile.ok())
+    throw ttb::CSV_IOError(r_infile.status().ToString());
+
+  utl::shp<arrow::io::InputStream> infile = r_infile.ValueUnsafe();
+
+  /// Decompression runs on the I/O context, block by block, so parsing of the first inflated
+  /// blocks overlaps with the inflation of the next ones. The codec must outlive the reader
+  utl::unp<arrow::util::Codec> codec{nullptr};
+  auto compression = ccompression::detect(path, *r_infile.ValueUnsafe(), options.compression);
+  if (compression != arrow::Compression::UNCOMPRESSED) {
+    auto r_codec = arrow::util::Codec::Create(compression);
+    if (!r_codec.ok())
+      throw ttb::CSV_IOError(r_codec.status().ToString());
+    codec = r_codec.MoveValueUnsafe();
+
+    auto r_compressed = arrow::io::CompressedInputStream::Make(codec.get(), infile,
+                                                                   ttb::memory_pool());
+    if (!r_compressed.ok())
+      throw ttb::CSV_IOError(r_compressed.status().ToString());
+    infile = r_compressed.MoveValueUnsafe();
+  }
 
   auto read_opts = arrow::csv::ReadOptions::Defaults();
   auto parse_opts = arrow::csv::ParseOptions::Defaults();
@@ -29,55 +121,342 @@ utl::shp<arrow::Table> read_file(const std::filesystem::path &path, bool has_hea
 
   parse_opts.delimiter = separator;
   read_opts.autogenerate_column_names = !has_header;
-  read_opts.use_threads = true;
+  read_opts.use_threads = options.use_threads;
+  read_opts.block_size = options.block_size;
+
+  convert_opts.column_types = options.column_types;
+  convert_opts.default_column_type = options.default_column_type;
+  convert_opts.include_columns = options.include_columns;
+  if (!options.null_values.empty())
+    convert_opts.null_values = options.null_values;
+
+  /// The dedicated pool, if any, must outlive the reader
+  utl::shp<arrow::internal::ThreadPool> io_pool{nullptr};
+  auto io_context = arrow::io::IOContext{ttb::memory_pool()};
+  if (options.io_executor != nullptr)
+    io_context = arrow::io::IOContext{ttb::memory_pool(), options.io_executor};
+  else if (options.io_threads > 0) {
+    auto r_pool = arrow::internal::ThreadPool::Make(options.io_threads);
+    if (!r_pool.ok())
+      throw ttb::CSV_IOError(r_pool.status().ToString());
+
+    io_pool = r_pool.MoveValueUnsafe();
+    io_context = arrow::io::IOContext{ttb::memory_pool(), io_pool.get()};
+  }
 
   auto reader =
-      arrow::csv::TableReader::Make(arrow::io::default_io_context(), infile.MoveValueUnsafe(),
-                                    read_opts, parse_opts, convert_opts);
+      arrow::csv::TableReader::Make(io_context, infile, read_opts, parse_opts, convert_opts);
   if (!reader.ok())
     throw ttb::CSV_IOError(reader.status().ToString());
 
   auto table = reader.MoveValueUnsafe()->Read();
+  ttb::throw_if_budget_exceeded(table.status());
   if (!table.ok())
     throw ttb::CSV_IOError(table.status().ToString());
 
   return table.ValueUnsafe();
 }
 
+utl::shp<arrow::Table> timed_read_file(const std::filesystem::path &path, bool has_header,
+                                       char separator, const ttb::CSVOptions &options,
+                                       ttb::CSVReadStats *stats) {
+  TTB_TIMED_SCOPE("CSV_IO::read");
+  ttb::MemoryOperation memory_operation{"CSV_IO::read"};
+  auto start = std::chrono::steady_clock::now();
+  auto resp = read_file(path, has_header, separator, options);
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  std::error_code ec;
+  auto n_bytes = std::filesystem::file_size(path, ec);
+  ttb::CSVReadStats read_stats{ec ? 0 : static_cast<int64_t>(n_bytes), resp->num_rows(),
+                               elapsed.count()};
+  TTB_COUNT_ROWS(read_stats.n_rows);
+  TTB_COUNT_BYTES(read_stats.n_bytes);
+  if (stats != nullptr)
+    *stats = read_stats;
+
+  return resp;
+}
+
 } // namespace rread
 
-ttb::AnalyticTable ttb::CSV_IO::read(char separator) const {
-  auto resp = rread::read_file(this->_path, _has_header, separator);
+ttb::AnalyticTable ttb::CSV_IO::read(char separator, ttb::CSVReadStats *stats) const {
+  auto resp = rread::timed_read_file(this->_path, _has_header, separator, _options, stats);
 
   return ttb::AnalyticTable{std::move(resp)};
 }
 
+namespace wwrite {
+
+/// Formatted cells of one column of a block, with the end offset of each cell
+struct Cells {
+    std::string chars;
+    std::vector<size_t> ends;
+};
+
+void append_field(std::string &out, std::string_view value, char separator) {
+  const std::array<char, 4> specials{separator, '"', '\n', '\r'};
+  if (value.find_first_of(std::string_view{specials.data(), specials.size()}) ==
+      std::string_view::npos) {
+    out.append(value);
+    return;
+  }
+
+  out.push_back('"');
+  for (auto c : value) {
+    if (c == '"')
+      out.push_back('"');
+    out.push_back(c);
+  }
+  out.push_back('"');
+}
+
+template <typename ArrayType>
+void format_numbers(const arrow::Array &chunk, Cells &cells, std::optional<int> precision) {
+  const auto &array = static_cast<const ArrayType &>(chunk);
+  /// Room for the 309 integer digits of the largest double in fixed notation
+  std::array<char, 384> buf{};
+  for (int64_t i{0}; i < array.length(); ++i) {
+    if (array.IsValid(i)) {
+      auto value = array.Value(i);
+      std::to_chars_result r;
+      if constexpr (std::is_floating_point_v<decltype(value)>)
+        r = precision.has_value() ? std::to_chars(buf.data(), buf.data() + buf.size(), value,
+                                                   std::chars_format::fixed, *precision)
+                                  : std::to_chars(buf.data(), buf.data() + buf.size(), value);
+      else
+        r = std::to_chars(buf.data(), buf.data() + buf.size(), value);
+      if (r.ec != std::errc{})
+        throw ttb::CSV_IOError("Value too long to be formatted with the requested float_precision");
+      cells.chars.append(buf.data(), r.ptr);
+    }
+    cells.ends.emplace_back(cells.chars.size());
+  }
+}
+
+template <typename ArrayType>
+void format_strings(const arrow::Array &chunk, Cells &cells, char separator) {
+  const auto &array = static_cast<const ArrayType &>(chunk);
+  for (int64_t i{0}; i < array.length(); ++i) {
+    if (array.IsValid(i))
+      append_field(cells.chars, array.GetView(i), separator);
+    cells.ends.emplace_back(cells.chars.size());
+  }
+}
+
+void format_booleans(const arrow::Array &chunk, Cells &cells) {
+  const auto &array = static_cast<const arrow::BooleanArray &>(chunk);
+  for (int64_t i{0}; i < array.length(); ++i) {
+    if (array.IsValid(i))
+      cells.chars.append(array.Value(i) ? "true" : "false");
+    cells.ends.emplace_back(cells.chars.size());
+  }
+}
+
+void format_chunk(const arrow::Array &chunk, Cells &cells, char separator,
+                  const ttb::CSVOptions &options) {
+  auto precision = options.float_precision;
+  switch (chunk.type_id()) {
+  case arrow::Type::INT8:
+    return format_numbers<arrow::Int8Array>(chunk, cells, precision);
+  case arrow::Type::INT16:
+    return format_numbers<arrow::Int16Array>(chunk, cells, precision);
+  case arrow::Type::INT32:
+    return format_numbers<arrow::Int32Array>(chunk, cells, precision);
+  case arrow::Type::INT64:
+    return format_numbers<arrow::Int64Array>(chunk, cells, precision);
+  case arrow::Type::UINT8:
+    return format_numbers<arrow::UInt8Array>(chunk, cells, precision);
+  case arrow::Type::UINT16:
+    return format_numbers<arrow::UInt16Array>(chunk, cells, precision);
+  case arrow::Type::UINT32:
+    return format_numbers<arrow::UInt32Array>(chunk, cells, precision);
+  case arrow::Type::UINT64:
+    return format_numbers<arrow::UInt64Array>(chunk, cells, precision);
+  case arrow::Type::FLOAT:
+    return format_numbers<arrow::FloatArray>(chunk, cells, precision);
+  case arrow::Type::DOUBLE:
+    return format_numbers<arrow::DoubleArray>(chunk, cells, precision);
+  case arrow::Type::BOOL:
+    return format_booleans(chunk, cells);
+  case arrow::Type::STRING:
+    return format_strings<arrow::StringArray>(chunk, cells, separator);
+  case arrow::Type::LARGE_STRING:
+    return format_strings<arrow::LargeStringArray>(chunk, cells, separator);
+  default:
+    break;
+  }
+
+  /// Remaining types (dates, timestamps, decimals, dictionaries...) use arrow's string casts
+  utl::initialize_arrow_compute();
+  arrow::compute::ExecContext ctx{ttb::memory_pool()};
+  auto r_casted = arrow::compute::Cast(chunk, arrow::utf8(), arrow::compute::CastOptions::Safe(),
+                                       &ctx);
+  ttb::throw_if_budget_exceeded(r_casted.status());
+  if (!r_casted.ok())
+    throw ttb::CSV_IOError(r_casted.status().ToString());
+
+  format_strings<arrow::StringArray>(*r_casted.ValueUnsafe(), cells, separator);
+}
+
+std::string format_block(const arrow::Table &table, int64_t row_offset, int64_t n_rows,
+                         char separator, const ttb::CSVOptions &options) {
+  TTB_TIMED_SCOPE("CSV_IO::format_block");
+  TTB_COUNT_ROWS(n_rows);
+  auto block = table.Slice(row_offset, n_rows);
+  auto n_cols = block->num_columns();
+
+  std::vector<Cells> columns(n_cols);
+  size_t n_chars{0};
+  for (int j{0}; j < n_cols; ++j) {
+    columns[j].ends.reserve(n_rows);
+    for (const auto &chunk : block->column(j)->chunks())
+      format_chunk(*chunk, columns[j], separator, options);
+    n_chars += columns[j].chars.size();
+  }
+
+  std::string resp;
+  if (n_cols == 0)
+    return resp;
+
+  resp.reserve(n_chars + static_cast<size_t>(n_rows * n_cols));
+  TTB_COUNT_BYTES(resp.capacity());
+  for (int64_t i{0}; i < n_rows; ++i)
+    for (int j{0}; j < n_cols; ++j) {
+      auto begin = i == 0 ? 0 : columns[j].ends[i - 1];
+      resp.append(columns[j].chars, begin, columns[j].ends[i] - begin);
+      resp.push_back(j == n_cols - 1 ? '\n' : separator);
+    }
+
+  return resp;
+}
+
+std::string format_header(const arrow::Table &table, char separator) {
+  std::string resp;
+  auto names = table.schema()->field_names();
+  for (size_t j{0}; j < names.size(); ++j) {
+    append_field(resp, names[j], separator);
+    resp.push_back(j == names.size() - 1 ? '\n' : separator);
+  }
+
+  return resp;
+}
+
+void write_blocks(const std::vector<std::string> &blocks, arrow::io::OutputStream &out) {
+  for (const auto &block : blocks) {
+    auto status = out.Write(block.data(), static_cast<int64_t>(block.size()));
+    if (!status.ok())
+      throw ttb::CSV_IOError(status.ToString());
+  }
+}
+
+/**
+ * @brief Formats waves of blocks in parallel; each wave is written in the background, in order,
+ * while the next one is formatted
+ *
+ */
+void write_table(const arrow::Table &table, arrow::io::OutputStream &out, bool has_header,
+                 char separator, const ttb::CSVOptions &options) {
+  if (has_header)
+    write_blocks({format_header(table, separator)}, out);
+
+  auto n_rows = table.num_rows();
+  auto batch_size = std::max<int64_t>(1, options.batch_size);
+  auto n_blocks = (n_rows + batch_size - 1) / batch_size;
+  auto wave_size = options.use_threads ? 2 * std::max<int64_t>(1, at::get_num_threads()) : 1;
+
+  /// Worker threads do not inherit the caller's MemoryPoolScope
+  auto pool = ttb::memory_pool();
+
+  /// Declared before the pending write, which references it
+  std::vector<std::string> writing;
+  std::future<void> pending;
+
+  for (int64_t wave_begin{0}; wave_begin < n_blocks; wave_begin += wave_size) {
+    auto wave_end = std::min(wave_begin + wave_size, n_blocks);
+    std::vector<std::string> blocks(wave_end - wave_begin);
+
+    auto format = [&](int64_t begin, int64_t end) {
+      ttb::MemoryPoolScope pool_scope{pool};
+      for (auto b{begin}; b < end; ++b) {
+        auto row_offset = (wave_begin + b) * batch_size;
+        blocks[b] = format_block(table, row_offset, std::min(batch_size, n_rows - row_offset),
+                                 separator, options);
+      }
+    };
+    if (options.use_threads)
+      at::parallel_for(0, static_cast<int64_t>(blocks.size()), 1, format);
+    else
+      format(0, static_cast<int64_t>(blocks.size()));
+
+    if (pending.valid())
+      pending.get();
+
+    writing = std::move(blocks);
+    pending = std::async(std::launch::async, [&] { write_blocks(writing, out); });
+  }
+
+  if (pending.valid())
+    pending.get();
+}
+
+} // namespace wwrite
+
 void ttb::CSV_IO::write(const ttb::AnalyticTable &table, char separator) const {
+  TTB_TIMED_SCOPE("CSV_IO::write");
+  TTB_COUNT_ROWS(table.n_rows());
+  auto compression = _options.compression.value_or(ccompression::from_extension(_path));
+
   auto r_outfile = arrow::io::FileOutputStream::Open(_path);
   if (!r_outfile.ok())
     throw CSV_IOError(r_outfile.status().ToString());
 
-  auto opts = arrow::csv::WriteOptions::Defaults();
-  opts.include_header = _has_header;
-  opts.batch_size = 1024;
-  opts.delimiter = separator;
-  auto outfile = r_outfile.MoveValueUnsafe();
+  utl::shp<arrow::io::OutputStream> outfile = r_outfile.MoveValueUnsafe();
+
+  /// The codec must outlive the compressed stream
+  utl::unp<arrow::util::Codec> codec{nullptr};
+  if (compression != arrow::Compression::UNCOMPRESSED) {
+    auto r_codec = arrow::util::Codec::Create(compression);
+    if (!r_codec.ok())
+      throw CSV_IOError(r_codec.status().ToString());
+    codec = r_codec.MoveValueUnsafe();
+
+    auto r_compressed = arrow::io::CompressedOutputStream::Make(codec.get(), outfile,
+                                                                    ttb::memory_pool());
+    if (!r_compressed.ok())
+      throw CSV_IOError(r_compressed.status().ToString());
+    outfile = r_compressed.MoveValueUnsafe();
+  }
 
-  auto st = arrow::csv::WriteCSV(*table.arrow_table(), opts, outfile.get());
+  wwrite::write_table(*table.arrow_table(), *outfile, _has_header, separator, _options);
+
+  auto st = outfile->Close();
   if (!st.ok())
     throw CSV_IOError(st.ToString());
 }
 
+void ttb::CSV_IO::set_cpu_threads(int n_threads) {
+  auto status = arrow::SetCpuThreadPoolCapacity(n_threads);
+  if (!status.ok())
+    throw CSV_IOError(status.ToString());
+}
+
 template <utl::NumericType T>
-ttb::AnalyticTableNumeric<T> ttb::CSV_IO::read_numeric(char separator) const {
-  auto r_table = this->read(separator);
+ttb::AnalyticTableNumeric<T> ttb::CSV_IO::read_numeric(char separator,
+                                                        ttb::CSVReadStats *stats) const {
+  auto options = _options;
+  if (options.parse_numeric_directly && options.default_column_type == nullptr)
+    options.default_column_type = utl::arrow_dtype<T>();
+
+  auto resp = rread::timed_read_file(this->_path, _has_header, separator, options, stats);
 
-  return ttb::AnalyticTableNumeric<T>{std::move(r_table)};
+  return ttb::AnalyticTableNumeric<T>{std::move(resp)};
 }
 
 // NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
 #define INSTANTIATE_CSV_IO_TEMPLATES(T)                                                            \
-  template ttb::AnalyticTableNumeric<T> ttb::CSV_IO::read_numeric<T>(char) const;
+  template ttb::AnalyticTableNumeric<T> ttb::CSV_IO::read_numeric<T>(                              \
+      char, ttb::CSVReadStats *) const;
 
 INSTANTIATE_CSV_IO_TEMPLATES(int);
 INSTANTIATE_CSV_IO_TEMPLATES(int64_t)
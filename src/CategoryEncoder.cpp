@@ -0,0 +1,373 @@
+#include "CategoryEncoder.h"
+#include "GroupBy.h"
+#include "Instrumentation.h"
+#include "MemoryPool.h"
+#include "XYMatrix.h"
+#include "detail/dictionary_codes.h"
+#include "detail/utils.h"
+
+#include <ATen/Parallel.h>
+#include <arrow/api.h>
+#include <arrow/array/concatenate.h>
+#include <arrow/compute/api.h>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+namespace category_encoder {
+
+/// Minimum number of rows encoded by each parallel task
+constexpr int64_t GRAIN_ROWS{1 << 14};
+
+/// Chunks of a column concatenated into a single array
+utl::shp<arrow::Array> combined(const arrow::ChunkedArray &column) {
+  if (column.num_chunks() == 1)
+    return column.chunk(0);
+
+  auto r_combined = column.num_chunks() == 0
+                        ? arrow::MakeEmptyArray(column.type(), ttb::memory_pool())
+                        : arrow::Concatenate(column.chunks(), ttb::memory_pool());
+  ttb::throw_if_budget_exceeded(r_combined.status());
+  if (!r_combined.ok())
+    throw ttb::CategoryEncoderError(r_combined.status().ToString());
+
+  return r_combined.MoveValueUnsafe();
+}
+
+/// Numeric column cast to float64, chunks combined
+utl::shp<arrow::DoubleArray> doubles(const utl::shp<arrow::ChunkedArray> &column) {
+  if (!arrow::is_numeric(column->type()->id()))
+    throw ttb::CategoryEncoderError("Target is not numeric: " + column->type()->ToString());
+
+  arrow::compute::ExecContext ctx{ttb::memory_pool()};
+  auto r_casted = arrow::compute::Cast(column, arrow::float64(),
+                                       arrow::compute::CastOptions::Safe(), &ctx);
+  ttb::throw_if_budget_exceeded(r_casted.status());
+  if (!r_casted.ok())
+    throw ttb::CategoryEncoderError(r_casted.status().ToString());
+
+  return std::static_pointer_cast<arrow::DoubleArray>(
+      combined(*r_casted.ValueUnsafe().chunked_array()));
+}
+
+utl::shp<arrow::Buffer> allocate_doubles(int64_t n_values) {
+  auto r_buffer =
+      arrow::AllocateBuffer(n_values * static_cast<int64_t>(sizeof(double)), ttb::memory_pool());
+  ttb::throw_if_budget_exceeded(r_buffer.status());
+  if (!r_buffer.ok())
+    throw ttb::CategoryEncoderError(r_buffer.status().ToString());
+
+  return r_buffer.MoveValueUnsafe();
+}
+
+/// Puts the encoded values, named name, in place of the column at col_index
+void replace_column(ttb::AnalyticTable &table, int col_index, const std::string &name,
+                    utl::shp<arrow::Buffer> &&values) {
+  auto n_rows = table.n_rows();
+  auto schema = arrow::schema({arrow::field(name, arrow::float64())});
+  auto array = std::make_shared<arrow::DoubleArray>(n_rows, std::move(values));
+  ttb::AnalyticTable encoded{arrow::Table::Make(std::move(schema), {array}, n_rows)};
+
+  table.append(encoded, ttb::Axis::COLUMN);
+  table.remove_col(col_index);
+  table.move_column(table.n_cols() - 1, col_index);
+}
+
+/// Values of a column at rows, dictionary columns being decoded
+utl::shp<arrow::Array> values_at(const arrow::ChunkedArray &column,
+                                 const std::vector<int64_t> &rows) {
+  arrow::compute::ExecContext ctx{ttb::memory_pool()};
+  arrow::Result<arrow::Datum> r_values;
+  if (column.type()->id() == arrow::Type::DICTIONARY) {
+    auto r_codes = utl::dictionary_codes(column, ttb::memory_pool());
+    ttb::throw_if_budget_exceeded(r_codes.status());
+    if (!r_codes.ok())
+      throw ttb::CategoryEncoderError(r_codes.status().ToString());
+
+    const auto &codes = r_codes.ValueUnsafe();
+    arrow::Int32Builder indices{ttb::memory_pool()};
+    for (auto row : rows) {
+      auto status = codes.codes[row] < 0 ? indices.AppendNull() : indices.Append(codes.codes[row]);
+      ttb::throw_if_budget_exceeded(status);
+      if (!status.ok())
+        throw ttb::CategoryEncoderError(status.ToString());
+    }
+    auto r_indices = indices.Finish();
+    ttb::throw_if_budget_exceeded(r_indices.status());
+    if (!r_indices.ok())
+      throw ttb::CategoryEncoderError(r_indices.status().ToString());
+    r_values = arrow::compute::Take(codes.dictionary, r_indices.MoveValueUnsafe(),
+                                    arrow::compute::TakeOptions::NoBoundsCheck(), &ctx);
+  } else {
+    arrow::Int64Builder indices{ttb::memory_pool()};
+    auto status = indices.AppendValues(rows);
+    ttb::throw_if_budget_exceeded(status);
+    if (!status.ok())
+      throw ttb::CategoryEncoderError(status.ToString());
+    auto r_indices = indices.Finish();
+    ttb::throw_if_budget_exceeded(r_indices.status());
+    if (!r_indices.ok())
+      throw ttb::CategoryEncoderError(r_indices.status().ToString());
+    r_values = arrow::compute::Take(combined(column), r_indices.MoveValueUnsafe(),
+                                    arrow::compute::TakeOptions::NoBoundsCheck(), &ctx);
+  }
+  ttb::throw_if_budget_exceeded(r_values.status());
+  if (!r_values.ok())
+    throw ttb::CategoryEncoderError(r_values.status().ToString());
+
+  return r_values.MoveValueUnsafe().make_array();
+}
+
+/// Index in values of every value of values_in, null when absent
+utl::shp<arrow::Int32Array> index_in(const utl::shp<arrow::Array> &values_in,
+                                     const utl::shp<arrow::Array> &values) {
+  utl::initialize_arrow_compute();
+  arrow::compute::ExecContext ctx{ttb::memory_pool()};
+  arrow::compute::SetLookupOptions options{values};
+  auto r_indices = arrow::compute::IndexIn(values_in, options, &ctx);
+  ttb::throw_if_budget_exceeded(r_indices.status());
+  if (!r_indices.ok())
+    throw ttb::CategoryEncoderError(r_indices.status().ToString());
+
+  return std::static_pointer_cast<arrow::Int32Array>(r_indices.MoveValueUnsafe().make_array());
+}
+
+int column_index(const ttb::AnalyticTable &table, const std::string &col) {
+  auto index = table.col_index(col);
+  if (!index.has_value())
+    throw ttb::CategoryEncoderError("Column not found: " + col);
+
+  return index.value();
+}
+
+} // namespace category_encoder
+
+ttb::CategoryEncoder::CategoryEncoder(ttb::CategoryEncoding encoding, int n_folds,
+                                      double smoothing)
+    : _encoding{encoding}, _n_folds{n_folds}, _smoothing{smoothing} {
+  if (n_folds < 2)
+    throw ttb::CategoryEncoderError("At least two folds are needed");
+  if (smoothing < 0.0)
+    throw ttb::CategoryEncoderError("Smoothing must not be negative");
+}
+
+ttb::CategoryEncoder::CategoryEncoder(ttb::CategoryEncoding encoding,
+                                      const ttb::AnalyticTable &mapping, double unseen_value)
+    : _encoding{encoding}, _unseen_value{unseen_value} {
+  auto category_index = category_encoder::column_index(mapping, "category");
+  auto encoding_index = category_encoder::column_index(mapping, "encoding");
+  _categories = category_encoder::combined(*mapping.arrow_table()->column(category_index));
+
+  auto encodings = category_encoder::doubles(mapping.arrow_table()->column(encoding_index));
+  _encodings.assign(encodings->raw_values(), encodings->raw_values() + encodings->length());
+}
+
+std::string ttb::CategoryEncoder::encoded_name(const std::string &col) const {
+  return col + (_encoding == ttb::CategoryEncoding::MEAN_TARGET ? "_mean_target" : "_frequency");
+}
+
+void ttb::CategoryEncoder::fit_transform(ttb::AnalyticTable &table, const std::string &col,
+                                         const std::string &target, int pct_eval) {
+  if (pct_eval < 0 || pct_eval >= 100)
+    throw ttb::CategoryEncoderError("Percentage out of bounds");
+
+  std::vector<int64_t> train_rows(ttb::XYMatrix::train_rows(table.n_rows(), pct_eval));
+  std::iota(train_rows.begin(), train_rows.end(), int64_t{0});
+  this->fit_transform(table, col, target, train_rows);
+}
+
+void ttb::CategoryEncoder::fit_transform(ttb::AnalyticTable &table, const std::string &col,
+                                         const std::string &target,
+                                         const std::vector<int64_t> &train_rows) {
+  TTB_TIMED_SCOPE("CategoryEncoder::fit_transform");
+  ttb::MemoryOperation memory_operation{"CategoryEncoder::fit_transform"};
+  TTB_COUNT_ROWS(table.n_rows());
+  auto col_index = category_encoder::column_index(table, col);
+
+  auto mean_target = _encoding == ttb::CategoryEncoding::MEAN_TARGET;
+  utl::shp<arrow::DoubleArray> targets;
+  if (mean_target) {
+    auto target_index = category_encoder::column_index(table, target);
+    targets = category_encoder::doubles(table.arrow_table()->column(target_index));
+  }
+
+  auto n_rows = table.n_rows();
+  std::vector<uint8_t> is_train(n_rows, 0);
+  for (auto i : train_rows) {
+    if (i < 0 || i >= n_rows)
+      throw ttb::CategoryEncoderError("Training row out of bounds");
+    is_train[i] = 1;
+  }
+
+  ttb::GroupBy groups{table, {col}};
+  const auto &row_groups = groups.row_groups();
+  auto n_groups = groups.n_groups();
+
+  // Sums and counts of every fold and group over the training rows, one task per hash partition
+  // of disjoint groups
+  auto n_folds = mean_target ? static_cast<int64_t>(_n_folds) : int64_t{1};
+  std::vector<double> fold_sums(n_folds * n_groups, 0.0);
+  std::vector<int64_t> fold_counts(n_folds * n_groups, 0);
+  const auto &partitions = groups.partition_rows();
+  at::parallel_for(0, static_cast<int64_t>(partitions.size()), 1, [&](int64_t begin, int64_t end) {
+    for (auto p{begin}; p < end; ++p) {
+      for (auto i : partitions[p]) {
+        if (is_train[i] == 0 || (mean_target && targets->IsNull(i)))
+          continue;
+
+        auto cell = (i % n_folds) * n_groups + row_groups[i];
+        ++fold_counts[cell];
+        if (mean_target)
+          fold_sums[cell] += targets->Value(i);
+      }
+    }
+  });
+
+  std::vector<double> sums(n_groups, 0.0);
+  std::vector<int64_t> counts(n_groups, 0);
+  std::vector<double> total_fold_sums(n_folds, 0.0);
+  std::vector<int64_t> total_fold_counts(n_folds, 0);
+  for (int64_t f{0}; f < n_folds; ++f) {
+    for (int64_t g{0}; g < n_groups; ++g) {
+      sums[g] += fold_sums[f * n_groups + g];
+      counts[g] += fold_counts[f * n_groups + g];
+      total_fold_sums[f] += fold_sums[f * n_groups + g];
+      total_fold_counts[f] += fold_counts[f * n_groups + g];
+    }
+  }
+
+  auto total_sum = std::reduce(total_fold_sums.begin(), total_fold_sums.end());
+  auto total_count = std::reduce(total_fold_counts.begin(), total_fold_counts.end());
+  if (total_count == 0)
+    throw ttb::CategoryEncoderError("No training rows to fit on");
+
+  // Categories without rows to fit on get the prior, which also holds without smoothing
+  auto encode = [&](double sum, int64_t count, double prior) {
+    if (!mean_target)
+      return static_cast<double>(count) / static_cast<double>(total_count);
+    if (count == 0)
+      return prior;
+    return (sum + _smoothing * prior) / (static_cast<double>(count) + _smoothing);
+  };
+
+  auto prior = total_sum / static_cast<double>(total_count);
+  std::vector<double> fold_priors(n_folds, prior);
+  for (int64_t f{0}; f < n_folds; ++f) {
+    auto out_of_fold_count = total_count - total_fold_counts[f];
+    if (out_of_fold_count > 0)
+      fold_priors[f] = (total_sum - total_fold_sums[f]) / static_cast<double>(out_of_fold_count);
+  }
+
+  std::vector<double> group_encodings(n_groups);
+  for (int64_t g{0}; g < n_groups; ++g)
+    group_encodings[g] = encode(sums[g], counts[g], prior);
+
+  // Training rows only see the other folds, prior included
+  auto values = category_encoder::allocate_doubles(n_rows);
+  auto *encoded = reinterpret_cast<double *>(values->mutable_data());
+  at::parallel_for(0, n_rows, category_encoder::GRAIN_ROWS, [&](int64_t begin, int64_t end) {
+    for (auto i{begin}; i < end; ++i) {
+      auto g = row_groups[i];
+      if (!mean_target || is_train[i] == 0) {
+        encoded[i] = group_encodings[g];
+        continue;
+      }
+
+      auto f = i % n_folds;
+      auto cell = f * n_groups + g;
+      encoded[i] = encode(sums[g] - fold_sums[cell], counts[g] - fold_counts[cell], fold_priors[f]);
+    }
+  });
+
+  // Only categories seen in training rows are kept for inference
+  std::vector<int64_t> first_rows;
+  _encodings.clear();
+  for (int64_t g{0}; g < n_groups; ++g) {
+    if (counts[g] == 0)
+      continue;
+    first_rows.emplace_back(groups.group_rows()[g]);
+    _encodings.emplace_back(group_encodings[g]);
+  }
+
+  _categories = category_encoder::values_at(*table.arrow_table()->column(col_index), first_rows);
+  _unseen_value = mean_target ? prior : 0.0;
+  category_encoder::replace_column(table, col_index, this->encoded_name(col), std::move(values));
+}
+
+void ttb::CategoryEncoder::transform(ttb::AnalyticTable &table, const std::string &col) const {
+  TTB_TIMED_SCOPE("CategoryEncoder::transform");
+  TTB_COUNT_ROWS(table.n_rows());
+  if (!_categories)
+    throw ttb::CategoryEncoderError("Encoder is not fitted");
+
+  auto col_index = category_encoder::column_index(table, col);
+  auto values = category_encoder::allocate_doubles(table.n_rows());
+  auto *encoded = reinterpret_cast<double *>(values->mutable_data());
+  const auto &column = *table.arrow_table()->column(col_index);
+  if (column.type()->id() == arrow::Type::DICTIONARY) {
+    // Only the dictionary of every chunk is looked up, rows then gather the encoding of their code
+    auto null_value = _unseen_value;
+    for (int64_t j{0}; j < _categories->length(); ++j)
+      if (_categories->IsNull(j))
+        null_value = _encodings[j];
+    for (const auto &chunk : column.chunks()) {
+      const auto &dictionary_chunk = static_cast<const arrow::DictionaryArray &>(*chunk);
+      auto indices = category_encoder::index_in(dictionary_chunk.dictionary(), _categories);
+      std::vector<double> code_values(indices->length());
+      for (int64_t code{0}; code < indices->length(); ++code)
+        code_values[code] = indices->IsValid(code) ? _encodings[indices->Value(code)]
+                                                   : _unseen_value;
+
+      at::parallel_for(0, chunk->length(), category_encoder::GRAIN_ROWS,
+                       [&](int64_t begin, int64_t end) {
+                         for (auto i{begin}; i < end; ++i)
+                           encoded[i] = chunk->IsValid(i)
+                                            ? code_values[dictionary_chunk.GetValueIndex(i)]
+                                            : null_value;
+                       });
+      encoded += chunk->length();
+    }
+  } else {
+    utl::initialize_arrow_compute();
+    arrow::compute::ExecContext ctx{ttb::memory_pool()};
+    arrow::compute::SetLookupOptions options{_categories};
+    auto r_indices = arrow::compute::IndexIn(table.arrow_table()->column(col_index), options, &ctx);
+    ttb::throw_if_budget_exceeded(r_indices.status());
+    if (!r_indices.ok())
+      throw ttb::CategoryEncoderError(r_indices.status().ToString());
+
+    for (const auto &chunk : r_indices.ValueUnsafe().chunked_array()->chunks()) {
+      auto indices = std::static_pointer_cast<arrow::Int32Array>(chunk);
+      at::parallel_for(0, indices->length(), category_encoder::GRAIN_ROWS,
+                       [&](int64_t begin, int64_t end) {
+                         for (auto i{begin}; i < end; ++i)
+                           encoded[i] = indices->IsValid(i) ? _encodings[indices->Value(i)]
+                                                            : _unseen_value;
+                       });
+      encoded += indices->length();
+    }
+  }
+
+  category_encoder::replace_column(table, col_index, this->encoded_name(col), std::move(values));
+}
+
+ttb::AnalyticTable ttb::CategoryEncoder::mapping() const {
+  if (!_categories)
+    throw ttb::CategoryEncoderError("Encoder is not fitted");
+
+  arrow::DoubleBuilder builder{ttb::memory_pool()};
+  auto status = builder.AppendValues(_encodings);
+  ttb::throw_if_budget_exceeded(status);
+  if (!status.ok())
+    throw ttb::CategoryEncoderError(status.ToString());
+
+  auto r_encodings = builder.Finish();
+  ttb::throw_if_budget_exceeded(r_encodings.status());
+  if (!r_encodings.ok())
+    throw ttb::CategoryEncoderError(r_encodings.status().ToString());
+
+  auto schema = arrow::schema({arrow::field("category", _categories->type()),
+                               arrow::field("encoding", arrow::float64())});
+  return ttb::AnalyticTable{
+      arrow::Table::Make(std::move(schema), {_categories, r_encodings.MoveValueUnsafe()})};
+}
@@ -0,0 +1,216 @@
+#include "ColumnSketch.h"
+#include "Instrumentation.h"
+#include "MemoryPool.h"
+
+#include <ATen/Parallel.h>
+#include <algorithm>
+#include <arrow/api.h>
+#include <arrow/array/util.h>
+#include <cmath>
+#include <string>
+#include <unordered_set>
+
+namespace column_sketch {
+
+/// Minimum number of rows handled by each parallel task
+constexpr int64_t GRAIN_ROWS{1 << 15};
+
+/// Hashes of the values of an array, as hashed by joins and group by
+utl::RowKeys row_keys(const utl::shp<arrow::Array> &values) {
+  auto schema = arrow::schema({arrow::field("value", values->type())});
+  auto table = arrow::Table::Make(std::move(schema), {values}, values->length());
+  auto r_keys = utl::RowKeys::Make(*table, {0}, ttb::memory_pool());
+  ttb::throw_if_budget_exceeded(r_keys.status());
+  if (!r_keys.ok())
+    throw ttb::ColumnSketchError(r_keys.status().ToString());
+
+  return r_keys.MoveValueUnsafe();
+}
+
+/// Type of the sketched values: dictionary columns are sketched as their decoded values
+utl::shp<arrow::DataType> value_type(const utl::shp<arrow::DataType> &type) {
+  if (type->id() != arrow::Type::DICTIONARY)
+    return type;
+
+  return static_cast<const arrow::DictionaryType &>(*type).value_type();
+}
+
+/// Value of row i, decoded when values is a dictionary array
+utl::shp<arrow::Scalar> decoded_scalar(const arrow::Array &values, int64_t i) {
+  auto r_value = values.GetScalar(i);
+  if (r_value.ok() && values.type_id() == arrow::Type::DICTIONARY) {
+    const auto &encoded = static_cast<const arrow::DictionaryScalar &>(*r_value.ValueUnsafe());
+    r_value = encoded.GetEncodedValue();
+  }
+  if (!r_value.ok())
+    throw ttb::ColumnSketchError(r_value.status().ToString());
+
+  return r_value.MoveValueUnsafe();
+}
+
+} // namespace column_sketch
+
+ttb::ColumnSketch::ColumnSketch(int top_k, int precision)
+    : _top_k{top_k}, _distinct{precision},
+      _heavy_hitters{std::max(top_k, 1) * ttb::ColumnSketch::COUNTERS_PER_VALUE} {
+  if (top_k < 1)
+    throw ttb::ColumnSketchError("top_k must be positive");
+}
+
+void ttb::ColumnSketch::update(const utl::shp<arrow::Array> &values) {
+  TTB_TIMED_SCOPE("ColumnSketch::update");
+  TTB_COUNT_ROWS(values->length());
+  auto type = column_sketch::value_type(values->type());
+  if (!_type)
+    _type = type;
+  else if (!_type->Equals(*type))
+    throw ttb::ColumnSketchError("Expected values of type " + _type->ToString() + ", got " +
+                                 type->ToString());
+
+  auto keys = column_sketch::row_keys(values);
+  auto n_rows = values->length();
+  auto n_tasks = std::clamp<int64_t>(n_rows / column_sketch::GRAIN_ROWS, 1, at::get_num_threads());
+  if (n_tasks == 1) {
+    this->update_rows(*values, keys, 0, n_rows);
+    return;
+  }
+
+  // One sketch per task over contiguous ranges, merged in order afterwards
+  auto task_rows = (n_rows + n_tasks - 1) / n_tasks;
+  ttb::ColumnSketch empty{_top_k, _distinct.precision()};
+  empty._type = _type;
+  std::vector<ttb::ColumnSketch> partials(n_tasks, empty);
+  at::parallel_for(0, n_tasks, 1, [&](int64_t begin, int64_t end) {
+    for (auto t{begin}; t < end; ++t)
+      partials[t].update_rows(*values, keys, t * task_rows, std::min(n_rows, (t + 1) * task_rows));
+  });
+
+  for (const auto &partial : partials)
+    this->merge(partial);
+}
+
+void ttb::ColumnSketch::update(const arrow::ChunkedArray &values) {
+  for (const auto &chunk : values.chunks())
+    this->update(chunk);
+}
+
+void ttb::ColumnSketch::update_rows(const arrow::Array &values, const utl::RowKeys &keys,
+                                    int64_t begin, int64_t end) {
+  for (auto i{begin}; i < end; ++i) {
+    if (keys.has_null(i)) {
+      ++_null_count;
+      continue;
+    }
+
+    auto hash = keys.hash(i);
+    ++_count;
+    _distinct.update(hash);
+    _frequencies.update(hash);
+
+    // A value whose Count-Min bound does not exceed the least tracked count has not occurred
+    // more often than it, so skipping it keeps the SpaceSaving bounds while sparing the heap the
+    // churn of ID-like values
+    if (!_heavy_hitters.full() || _frequencies.estimate(hash) > _heavy_hitters.min_count())
+      _heavy_hitters.update(hash, i);
+  }
+
+  // Only the values still tracked at the end of the batch are read
+  for (const auto &counter : _heavy_hitters.counters()) {
+    if (counter.tag < 0)
+      continue;
+    _values[counter.key] = column_sketch::decoded_scalar(values, counter.tag);
+  }
+  _heavy_hitters.clear_tags();
+  this->drop_untracked_values();
+}
+
+void ttb::ColumnSketch::drop_untracked_values() {
+  std::unordered_set<uint64_t> tracked;
+  tracked.reserve(_heavy_hitters.counters().size());
+  for (const auto &counter : _heavy_hitters.counters())
+    tracked.insert(counter.key);
+
+  std::erase_if(_values, [&](const auto &entry) { return !tracked.contains(entry.first); });
+}
+
+void ttb::ColumnSketch::merge(const ColumnSketch &other) {
+  if (other._distinct.precision() != _distinct.precision())
+    throw ttb::ColumnSketchError("Sketches of different precisions");
+  if (_type && other._type && !_type->Equals(*other._type))
+    throw ttb::ColumnSketchError("Sketches of different types");
+  if (!_type)
+    _type = other._type;
+
+  _count += other._count;
+  _null_count += other._null_count;
+  _distinct.merge(other._distinct);
+  _frequencies.merge(other._frequencies);
+  _heavy_hitters.merge(other._heavy_hitters);
+  _values.insert(other._values.begin(), other._values.end());
+  this->drop_untracked_values();
+}
+
+int64_t ttb::ColumnSketch::distinct_count() const {
+  auto estimate = std::llround(_distinct.estimate());
+
+  return std::min<int64_t>(estimate, _count);
+}
+
+int64_t ttb::ColumnSketch::frequency(const arrow::Scalar &value) const {
+  if (!_type || !_type->Equals(*value.type))
+    throw ttb::ColumnSketchError("Value type differs from the sketched one");
+  if (!value.is_valid)
+    return _null_count;
+
+  auto r_array = arrow::MakeArrayFromScalar(value, 1, ttb::memory_pool());
+  ttb::throw_if_budget_exceeded(r_array.status());
+  if (!r_array.ok())
+    throw ttb::ColumnSketchError(r_array.status().ToString());
+
+  auto hash = column_sketch::row_keys(r_array.MoveValueUnsafe()).hash(0);
+  const auto &counters = _heavy_hitters.counters();
+  auto it = std::ranges::find(counters, hash, &utl::SpaceSaving::Counter::key);
+
+  // An untracked value occurred at most as often as the least frequent tracked one
+  auto bound = it != counters.end() ? it->count : _heavy_hitters.min_count();
+
+  return std::min(bound, _frequencies.estimate(hash));
+}
+
+std::vector<ttb::HeavyHitter> ttb::ColumnSketch::heavy_hitters() const {
+  std::vector<ttb::HeavyHitter> resp;
+  for (const auto &counter : _heavy_hitters.top(_top_k)) {
+    auto count = std::min(counter.count, _frequencies.estimate(counter.key));
+    auto lower_bound = counter.count - counter.error;
+    resp.push_back({_values.at(counter.key), count, count - lower_bound});
+  }
+
+  auto by_count = [](const auto &a, const auto &b) { return a.count > b.count; };
+  std::ranges::stable_sort(resp, by_count);
+
+  return resp;
+}
+
+utl::shp<arrow::Array> ttb::ColumnSketch::heavy_hitter_values() const {
+  if (!_type)
+    throw ttb::ColumnSketchError("No values fitted");
+
+  auto r_builder = arrow::MakeBuilder(_type, ttb::memory_pool());
+  if (!r_builder.ok())
+    throw ttb::ColumnSketchError(r_builder.status().ToString());
+
+  auto builder = r_builder.MoveValueUnsafe();
+  for (const auto &heavy_hitter : this->heavy_hitters()) {
+    auto status = builder->AppendScalar(*heavy_hitter.value);
+    ttb::throw_if_budget_exceeded(status);
+    if (!status.ok())
+      throw ttb::ColumnSketchError(status.ToString());
+  }
+
+  auto r_array = builder->Finish();
+  ttb::throw_if_budget_exceeded(r_array.status());
+  if (!r_array.ok())
+    throw ttb::ColumnSketchError(r_array.status().ToString());
+
+  return r_array.MoveValueUnsafe();
+}
@@ -1,8 +1,14 @@
 #include "Converter.h"
 #include "AnalyticTable.h"
+#include "Instrumentation.h"
+#include "MemoryPool.h"
+#include "TensorPool.h"
+#include "XYMatrix.h"
 #include "detail/utils.h"
 
+#include <ATen/Parallel.h>
 #include <ATen/ops/from_blob.h>
+#include <algorithm>
 #include <arrow/api.h>
 #include <arrow/array/data.h>
 #include <arrow/array/util.h>
@@ -11,9 +17,10 @@
 #include <arrow/table.h>
 #include <arrow/type.h>
 #include <arrow/type_fwd.h>
+#include <arrow/util/bit_run_reader.h>
 #include <c10/core/TensorOptions.h>
 #include <cstdint>
-#include <cstring>
+#include <iterator>
 #include <memory>
 #include <string>
 #include <torch/data/dataloader.h>
@@ -23,67 +30,263 @@
 
 namespace torch_tensor {
 
+/// Borrows the column values, which must outlive the returned tensor; null slots hold garbage
 template <utl::NumericType T>
-torch::Tensor to_tensor(const utl::shp<arrow::Array> &arr) {
+torch::Tensor values_view(const utl::shp<arrow::Array> &arr) {
+  auto casted_col = std::static_pointer_cast<utl::ArrowArrayType<T>>(arr);
+  auto opt = torch::TensorOptions().dtype(utl::torch_type<T>());
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+  auto *values = const_cast<T *>(casted_col->raw_values());
+
+  return torch::from_blob(values, {casted_col->length(), 1}, opt);
+}
+
+template <utl::NumericType T>
+torch::Tensor column_view(const utl::shp<arrow::Array> &arr) {
   if (arr->null_count() != 0)
     throw std::runtime_error("Column has nulls");
 
-  auto casted_col = std::static_pointer_cast<utl::ArrowArrayType<T>>(arr);
-  auto torch_type = utl::torch_type<T>();
-  auto opt = torch::TensorOptions().dtype(torch_type);
-  auto tensor = torch::empty({casted_col->length(), 1}, opt);
-  std::memcpy(tensor.template data_ptr<T>(), casted_col->raw_values(),
-              casted_col->length() * sizeof(T));
-  return tensor;
+  return values_view<T>(arr);
+}
+
+/**
+ * @brief Writes fill into the null slots of a chunk already copied to out, strided by the number
+ * of columns, walking runs of the validity bitmap. FORWARD updates fill with the last value of
+ * every valid run, so it carries over to the next chunk
+ *
+ */
+template <utl::NumericType T>
+void fill_null_slots(const arrow::Array &chunk, T *out, int64_t stride,
+                     ttb::FillStrategy strategy, T &fill) {
+  const auto &values = static_cast<const utl::ArrowArrayType<T> &>(chunk);
+  auto forward = strategy == ttb::FillStrategy::FORWARD;
+  if (chunk.null_count() == 0) {
+    if (forward && chunk.length() > 0)
+      fill = values.Value(chunk.length() - 1);
+    return;
+  }
+
+  arrow::internal::BitRunReader runs{chunk.null_bitmap_data(), chunk.offset(), chunk.length()};
+  int64_t row{0};
+  for (auto run = runs.NextRun(); run.length != 0; row += run.length, run = runs.NextRun()) {
+    if (run.set) {
+      if (forward)
+        fill = values.Value(row + run.length - 1);
+      continue;
+    }
+    for (auto i{row}; i < row + run.length; ++i)
+      out[i * stride] = fill;
+  }
 }
 
 } // namespace torch_tensor
 
 template <utl::NumericType T>
 torch::Tensor ttb::Converter::torch_tensor(ttb::AnalyticTableNumeric<T> &&data) {
+  TTB_TIMED_SCOPE("Converter::torch_tensor");
   auto my_data = std::move(data);
-  std::vector<torch::Tensor> tensors;
+  TTB_COUNT_ROWS(my_data.n_rows());
+  TTB_COUNT_BYTES(my_data.n_rows() * my_data.n_cols() * static_cast<int64_t>(sizeof(T)));
+  // Every chunk of every column is copied once, straight into its block of pooled storage
+  auto resp = ttb::TensorPool::empty({my_data.n_rows(), my_data.n_cols()}, utl::torch_type<T>());
   for (int i{0}; i < my_data.n_cols(); ++i) {
-    auto column = my_data.copy_cols({i});
-    auto arr = column.arrow_table()->column(0)->chunk(0);
-    tensors.emplace_back(torch_tensor::to_tensor<T>(arr));
+    int64_t row_offset{0};
+    for (const auto &chunk : my_data.arrow_table()->column(i)->chunks()) {
+      auto block = resp.narrow(0, row_offset, chunk->length()).narrow(1, i, 1);
+      block.copy_(torch_tensor::column_view<T>(chunk));
+      row_offset += chunk->length();
+    }
   }
   my_data.reset();
 
-  // Concatenate tensors along axis (order) 1
-  return torch::cat(tensors, 1);
+  return resp;
 }
 
 template <utl::NumericType T>
-ttb::AnalyticTableNumeric<T> ttb::Converter::analytic_table(torch::Tensor &&tensor) {
-  if (tensor.sizes().size() != 2)
-    throw ttb::ConverterError("Tensor is not of second order");
-  if (!tensor.device().is_cpu())
-    throw ttb::ConverterError("Tensor is not stored in CPU");
+torch::Tensor ttb::Converter::torch_tensor(ttb::AnalyticTableNumeric<T> &&data,
+                                           ttb::FillStrategy strategy, T value) {
+  TTB_TIMED_SCOPE("Converter::torch_tensor");
+  auto my_data = std::move(data);
+  auto n_cols = my_data.n_cols();
+  TTB_COUNT_ROWS(my_data.n_rows());
+  TTB_COUNT_BYTES(my_data.n_rows() * n_cols * static_cast<int64_t>(sizeof(T)));
+  auto resp = ttb::TensorPool::empty({my_data.n_rows(), n_cols}, utl::torch_type<T>());
+  auto *out = resp.data_ptr<T>();
+  for (int i{0}; i < n_cols; ++i) {
+    auto fill = my_data.null_fill(i, strategy, value);
+    int64_t row_offset{0};
+    for (const auto &chunk : my_data.arrow_table()->column(i)->chunks()) {
+      auto block = resp.narrow(0, row_offset, chunk->length()).narrow(1, i, 1);
+      block.copy_(torch_tensor::values_view<T>(chunk));
+      torch_tensor::fill_null_slots<T>(*chunk, out + row_offset * n_cols + i, n_cols, strategy,
+                                       fill);
+      row_offset += chunk->length();
+    }
+  }
+  my_data.reset();
 
-  auto my_tensor = std::move(tensor);
-  my_tensor = my_tensor.to(utl::torch_type<T>());
+  return resp;
+}
 
-  auto n_rows = my_tensor.size(0);
-  auto n_cols = my_tensor.size(1);
+torch::Tensor ttb::Converter::validity_mask(const ttb::AnalyticTable &data) {
+  TTB_TIMED_SCOPE("Converter::validity_mask");
+  auto n_cols = data.n_cols();
+  TTB_COUNT_ROWS(data.n_rows());
+  auto resp = torch::ones({data.n_rows(), n_cols}, torch::kBool);
+  auto *out = resp.data_ptr<bool>();
 
-  /// Letting arrow manage memory
-  auto pool = arrow::default_memory_pool();
+  // Only the runs of unset validity bits are visited
+  at::parallel_for(0, n_cols, 1, [&](int64_t begin, int64_t end) {
+    for (auto j{begin}; j < end; ++j) {
+      int64_t row_offset{0};
+      for (const auto &chunk : data.arrow_table()->column(static_cast<int>(j))->chunks()) {
+        auto length = chunk->length();
+        if (chunk->null_count() != 0) {
+          arrow::internal::BitRunReader runs{chunk->null_bitmap_data(), chunk->offset(), length};
+          auto row{row_offset};
+          for (auto run = runs.NextRun(); run.length != 0; row += run.length, run = runs.NextRun())
+            for (auto i{row}; !run.set && i < row + run.length; ++i)
+              out[i * n_cols + j] = false;
+        }
+        row_offset += length;
+      }
+    }
+  });
 
-  std::vector<utl::shp<arrow::Field>> fields;
-  std::vector<utl::shp<arrow::ChunkedArray>> cols;
+  return resp;
+}
 
-  for (int64_t j{0}; j < n_cols; ++j) {
-    auto column = my_tensor.index({torch::indexing::Slice(), j}).contiguous();
+namespace analytic_table {
+
+/// Side of the square tiles used by the blocked transpose (64x64 doubles fit in L1)
+constexpr int64_t TILE_SIZE{64};
+
+/// Minimum number of elements handled by each parallel task
+constexpr int64_t GRAIN_ELEMENTS{1 << 15};
+
+/**
+ * @brief Arrow buffer pointing into torch memory, keeping the owning tensor alive
+ *
+ */
+class TensorBuffer : public arrow::Buffer {
+  public:
+    TensorBuffer(torch::Tensor tensor, const uint8_t *data, int64_t size)
+        : arrow::Buffer{data, size}, _tensor{std::move(tensor)} {}
+
+  private:
+    torch::Tensor _tensor;
+};
+
+bool is_column_major(const torch::Tensor &tensor) {
+  return tensor.stride(0) == 1 && (tensor.size(1) <= 1 || tensor.stride(1) == tensor.size(0));
+}
+
+template <utl::NumericType T>
+std::vector<utl::shp<arrow::Buffer>> wrap_columns(const torch::Tensor &tensor) {
+  auto n_rows = tensor.size(0);
+  auto n_cols = tensor.size(1);
+  auto col_bytes = n_rows * int64_t(sizeof(T));
+  const auto *data = reinterpret_cast<const uint8_t *>(tensor.data_ptr<T>());
 
+  std::vector<utl::shp<arrow::Buffer>> resp;
+  resp.reserve(n_cols);
+  for (int64_t j{0}; j < n_cols; ++j)
+    resp.emplace_back(std::make_shared<TensorBuffer>(tensor, data + j * col_bytes, col_bytes));
+
+  return resp;
+}
+
+template <utl::NumericType T>
+void transpose_tile(const T *src, int64_t n_cols, std::vector<T *> &dst, int64_t row_begin,
+                    int64_t row_end, int64_t col_begin, int64_t col_end) {
+  for (int64_t j{col_begin}; j < col_end; ++j) {
+    auto *out = dst[j];
+    for (int64_t i{row_begin}; i < row_end; ++i)
+      out[i] = src[i * n_cols + j];
+  }
+}
+
+/**
+ * @brief Cache-blocked transpose of a row-major [n_rows, n_cols] matrix into n_cols column
+ * buffers. Row tiles are distributed among threads, so each thread writes disjoint ranges.
+ *
+ */
+template <utl::NumericType T>
+void transpose_into(const T *src, int64_t n_rows, int64_t n_cols, std::vector<T *> &dst) {
+  auto n_row_tiles = (n_rows + TILE_SIZE - 1) / TILE_SIZE;
+  auto grain = std::max<int64_t>(1, GRAIN_ELEMENTS / std::max<int64_t>(1, TILE_SIZE * n_cols));
+
+  at::parallel_for(0, n_row_tiles, grain, [&](int64_t tile_begin, int64_t tile_end) {
+    for (auto t{tile_begin}; t < tile_end; ++t) {
+      auto row_begin = t * TILE_SIZE;
+      auto row_end = std::min(row_begin + TILE_SIZE, n_rows);
+      for (int64_t col_begin{0}; col_begin < n_cols; col_begin += TILE_SIZE) {
+        auto col_end = std::min(col_begin + TILE_SIZE, n_cols);
+        transpose_tile<T>(src, n_cols, dst, row_begin, row_end, col_begin, col_end);
+      }
+    }
+  });
+}
+
+template <utl::NumericType T>
+std::vector<utl::shp<arrow::Buffer>> transpose_columns(const torch::Tensor &tensor,
+                                                       arrow::MemoryPool *pool) {
+  auto row_major = tensor.contiguous();
+  auto n_rows = row_major.size(0);
+  auto n_cols = row_major.size(1);
+
+  std::vector<utl::shp<arrow::Buffer>> resp;
+  std::vector<T *> dst;
+  resp.reserve(n_cols);
+  dst.reserve(n_cols);
+  for (int64_t j{0}; j < n_cols; ++j) {
     auto r_buf = arrow::AllocateBuffer(n_rows * int64_t(sizeof(T)), pool);
+    ttb::throw_if_budget_exceeded(r_buf.status());
     if (!r_buf.ok())
       throw ttb::ConverterError(r_buf.status().ToString());
 
     utl::shp<arrow::Buffer> buf = r_buf.MoveValueUnsafe();
-    std::memcpy(buf->mutable_data(), column.data_ptr<T>(), n_rows * sizeof(T));
+    dst.emplace_back(reinterpret_cast<T *>(buf->mutable_data()));
+    resp.emplace_back(std::move(buf));
+  }
+
+  transpose_into<T>(row_major.data_ptr<T>(), n_rows, n_cols, dst);
+
+  return resp;
+}
+
+/**
+ * @brief Column buffers of a second order CPU tensor. Column-major tensors (e.g. transposed
+ * contiguous ones) are wrapped without copying, otherwise columns are transposed into buffers
+ * managed by arrow
+ *
+ */
+template <utl::NumericType T>
+std::vector<utl::shp<arrow::Buffer>> column_buffers(const torch::Tensor &tensor) {
+  if (tensor.sizes().size() != 2)
+    throw ttb::ConverterError("Tensor is not of second order");
+  if (!tensor.device().is_cpu())
+    throw ttb::ConverterError("Tensor is not stored in CPU");
+
+  auto typed = tensor.to(utl::torch_type<T>());
 
-    auto array = std::make_shared<utl::ArrowArrayType<T>>(n_rows, buf, nullptr, 0);
+  return is_column_major(typed) ? wrap_columns<T>(typed)
+                                : transpose_columns<T>(typed, ttb::memory_pool());
+}
+
+/// Table with columns named col_1 ... col_n over the given column buffers
+template <utl::NumericType T>
+ttb::AnalyticTableNumeric<T> numeric_table(int64_t n_rows,
+                                           std::vector<utl::shp<arrow::Buffer>> &&buffers) {
+  auto n_cols = static_cast<int64_t>(buffers.size());
+  std::vector<utl::shp<arrow::Field>> fields;
+  std::vector<utl::shp<arrow::ChunkedArray>> cols;
+  fields.reserve(n_cols);
+  cols.reserve(n_cols);
+
+  for (int64_t j{0}; j < n_cols; ++j) {
+    auto array =
+        std::make_shared<utl::ArrowArrayType<T>>(n_rows, std::move(buffers[j]), nullptr, 0);
 
     std::string name = "col_" + std::to_string(j + 1);
     fields.emplace_back(arrow::field(name, utl::arrow_dtype<T>()));
@@ -93,8 +296,41 @@ ttb::AnalyticTableNumeric<T> ttb::Converter::analytic_table(torch::Tensor &&tens
   auto schema = arrow::schema(fields);
 
   return ttb::AnalyticTableNumeric<T>{arrow::Table::Make(schema, cols, n_rows)};
+}
+
+} // namespace analytic_table
+
+template <utl::NumericType T>
+ttb::AnalyticTableNumeric<T> ttb::Converter::analytic_table(torch::Tensor &&tensor) {
+  TTB_TIMED_SCOPE("Converter::analytic_table");
+  ttb::MemoryOperation memory_operation{"Converter::analytic_table"};
+  auto my_tensor = std::move(tensor);
+  auto buffers = analytic_table::column_buffers<T>(my_tensor);
+  auto n_rows = my_tensor.size(0);
+  TTB_COUNT_ROWS(n_rows);
+  TTB_COUNT_BYTES(my_tensor.nbytes());
+  my_tensor = torch::Tensor{};
+
+  return analytic_table::numeric_table<T>(n_rows, std::move(buffers));
 };
 
+template <utl::NumericType T>
+ttb::AnalyticTableNumeric<T> ttb::Converter::analytic_table(ttb::XYMatrix &&xy_matrix) {
+  TTB_TIMED_SCOPE("Converter::analytic_table");
+  ttb::MemoryOperation memory_operation{"Converter::analytic_table"};
+  auto my_xy_matrix = std::move(xy_matrix);
+  auto n_rows = my_xy_matrix.n_rows();
+  TTB_COUNT_ROWS(n_rows);
+  TTB_COUNT_BYTES(my_xy_matrix.X().nbytes() + my_xy_matrix.Y().nbytes());
+
+  // X and Y columns are converted side by side, never materializing XY
+  auto buffers = analytic_table::column_buffers<T>(my_xy_matrix.X());
+  auto Y_buffers = analytic_table::column_buffers<T>(my_xy_matrix.Y());
+  std::ranges::move(Y_buffers, std::back_inserter(buffers));
+
+  return analytic_table::numeric_table<T>(n_rows, std::move(buffers));
+}
+
 template <utl::NumericType T>
 torch::Tensor ttb::Converter::torch_tensor(ttb::CSV_IO &&reader) {
   auto my_reader = std::move(reader);
@@ -115,7 +351,10 @@ torch::Tensor ttb::Converter::torch_tensor(ttb::Parquet_IO &&reader) {
 // NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
 #define INSTANTIATE_CONVERTER_FUNCS(T)                                                             \
   template torch::Tensor ttb::Converter::torch_tensor(ttb::AnalyticTableNumeric<T> &&);            \
+  template torch::Tensor ttb::Converter::torch_tensor(ttb::AnalyticTableNumeric<T> &&,             \
+                                                      ttb::FillStrategy, T);                       \
   template ttb::AnalyticTableNumeric<T> ttb::Converter::analytic_table(torch::Tensor &&t);         \
+  template ttb::AnalyticTableNumeric<T> ttb::Converter::analytic_table(ttb::XYMatrix &&);          \
   template torch::Tensor ttb::Converter::torch_tensor<T>(ttb::CSV_IO &&);                          \
   template torch::Tensor ttb::Converter::torch_tensor<T>(ttb::Parquet_IO &&);
 
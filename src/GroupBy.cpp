@@ -0,0 +1,364 @@
+#include "GroupBy.h"
+#include "Instrumentation.h"
+#include "MemoryPool.h"
+#include "detail/row_keys.h"
+#include "detail/utils.h"
+
+#include <ATen/Parallel.h>
+#include <algorithm>
+#include <arrow/api.h>
+#include <arrow/array/concatenate.h>
+#include <arrow/compute/api.h>
+#include <arrow/compute/cast.h>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+#include <vector>
+
+namespace group_by {
+
+using Buckets = std::unordered_map<uint64_t, std::vector<int64_t>>;
+
+/// Spreads group ids before combining them with value hashes in COUNT_DISTINCT
+constexpr uint64_t GROUP_SEED{0x9e3779b97f4a7c15ULL};
+
+std::string aggregation_name(ttb::Aggregation aggregation) {
+  switch (aggregation) {
+  case ttb::Aggregation::SUM:
+    return "sum";
+  case ttb::Aggregation::MEAN:
+    return "mean";
+  case ttb::Aggregation::MIN:
+    return "min";
+  case ttb::Aggregation::MAX:
+    return "max";
+  case ttb::Aggregation::COUNT:
+    return "count";
+  case ttb::Aggregation::COUNT_DISTINCT:
+    return "count_distinct";
+  case ttb::Aggregation::STD:
+    return "std";
+  }
+
+  return "";
+}
+
+utl::RowKeys row_keys(const arrow::Table &table, const std::vector<int> &indices) {
+  auto r_keys = utl::RowKeys::Make(table, indices, ttb::memory_pool());
+  ttb::throw_if_budget_exceeded(r_keys.status());
+  if (!r_keys.ok())
+    throw ttb::GroupByError(r_keys.status().ToString());
+
+  return r_keys.MoveValueUnsafe();
+}
+
+/// Column cast to float64 with its chunks combined
+utl::shp<arrow::DoubleArray> doubles(const utl::shp<arrow::ChunkedArray> &column) {
+  if (!arrow::is_numeric(column->type()->id()))
+    throw ttb::GroupByError("Column is not numeric: " + column->type()->ToString());
+
+  /// Integers beyond 2^53 are aggregated with the rounding of float64 instead of failing
+  auto options = arrow::compute::CastOptions::Safe();
+  options.allow_float_truncate = true;
+  arrow::compute::ExecContext ctx{ttb::memory_pool()};
+  auto r_casted = arrow::compute::Cast(column, arrow::float64(), options, &ctx);
+  ttb::throw_if_budget_exceeded(r_casted.status());
+  if (!r_casted.ok())
+    throw ttb::GroupByError(r_casted.status().ToString());
+
+  const auto &casted = *r_casted.ValueUnsafe().chunked_array();
+  auto r_combined =
+      casted.num_chunks() == 1   ? arrow::Result<utl::shp<arrow::Array>>{casted.chunk(0)}
+      : casted.num_chunks() == 0 ? arrow::MakeEmptyArray(arrow::float64(), ttb::memory_pool())
+                                 : arrow::Concatenate(casted.chunks(), ttb::memory_pool());
+  ttb::throw_if_budget_exceeded(r_combined.status());
+  if (!r_combined.ok())
+    throw ttb::GroupByError(r_combined.status().ToString());
+
+  return std::static_pointer_cast<arrow::DoubleArray>(r_combined.MoveValueUnsafe());
+}
+
+/// Non-null count, sum, min, max, mean and sum of squared deviations (Welford) of every group
+struct Moments {
+    std::vector<int64_t> count;
+    std::vector<double> sum;
+    std::vector<double> min;
+    std::vector<double> max;
+    std::vector<double> mean;
+    std::vector<double> m2;
+
+    explicit Moments(int64_t n_groups)
+        : count(n_groups, 0), sum(n_groups, 0.0),
+          min(n_groups, std::numeric_limits<double>::infinity()),
+          max(n_groups, -std::numeric_limits<double>::infinity()), mean(n_groups, 0.0),
+          m2(n_groups, 0.0) {}
+};
+
+template <typename BuilderType>
+utl::shp<arrow::Array> finish(BuilderType &builder) {
+  auto r_array = builder.Finish();
+  ttb::throw_if_budget_exceeded(r_array.status());
+  if (!r_array.ok())
+    throw ttb::GroupByError(r_array.status().ToString());
+
+  return r_array.MoveValueUnsafe();
+}
+
+utl::shp<arrow::Array> int64_column(const std::vector<int64_t> &values) {
+  arrow::Int64Builder b(ttb::memory_pool());
+  auto status = b.AppendValues(values);
+  ttb::throw_if_budget_exceeded(status);
+  if (!status.ok())
+    throw ttb::GroupByError(status.ToString());
+
+  return finish(b);
+}
+
+/// Groups with fewer than min_count values get a null
+utl::shp<arrow::Array> double_column(const std::vector<double> &values,
+                                     const std::vector<int64_t> &count, int64_t min_count) {
+  arrow::DoubleBuilder b(ttb::memory_pool());
+  auto status = b.Reserve(static_cast<int64_t>(values.size()));
+  ttb::throw_if_budget_exceeded(status);
+  if (!status.ok())
+    throw ttb::GroupByError(status.ToString());
+
+  for (size_t g{0}; g < values.size(); ++g)
+    if (count[g] < min_count)
+      b.UnsafeAppendNull();
+    else
+      b.UnsafeAppend(values[g]);
+
+  return finish(b);
+}
+
+} // namespace group_by
+
+ttb::GroupBy::GroupBy(const ttb::AnalyticTable &table, const std::vector<std::string> &keys)
+    : _arrow_tb{table.arrow_table()} {
+  TTB_TIMED_SCOPE("GroupBy::GroupBy");
+  ttb::MemoryOperation memory_operation{"GroupBy::GroupBy"};
+  TTB_COUNT_ROWS(table.n_rows());
+  if (keys.empty())
+    throw ttb::GroupByError("No group keys");
+
+  for (const auto &key : keys) {
+    auto index = table.col_index(key);
+    if (!index.has_value())
+      throw ttb::GroupByError("Group key not found: " + key);
+    _key_indices.emplace_back(index.value());
+  }
+
+  auto row_keys = group_by::row_keys(*_arrow_tb, _key_indices);
+  this->assign_groups(row_keys);
+}
+
+void ttb::GroupBy::assign_groups(const utl::RowKeys &keys) {
+  auto n_rows = keys.n_rows();
+  auto n_partitions = static_cast<int64_t>(std::max(1, at::get_num_threads()));
+
+  _partition_rows.assign(n_partitions, {});
+  for (int64_t i{0}; i < n_rows; ++i)
+    _partition_rows[keys.hash(i) % n_partitions].emplace_back(i);
+
+  // Groups of each partition, numbered locally in order of first appearance
+  _row_groups.assign(n_rows, 0);
+  std::vector<std::vector<int64_t>> partition_groups(n_partitions);
+  at::parallel_for(0, n_partitions, 1, [&](int64_t begin, int64_t end) {
+    for (auto p{begin}; p < end; ++p) {
+      group_by::Buckets buckets;
+      auto &first_rows = partition_groups[p];
+      for (auto i : _partition_rows[p]) {
+        auto &candidates = buckets[keys.hash(i)];
+        auto it = std::ranges::find_if(
+            candidates, [&](int64_t g) { return keys.equal(i, keys, first_rows[g]); });
+        if (it != candidates.end()) {
+          _row_groups[i] = *it;
+          continue;
+        }
+
+        _row_groups[i] = static_cast<int64_t>(first_rows.size());
+        candidates.emplace_back(_row_groups[i]);
+        first_rows.emplace_back(i);
+      }
+    }
+  });
+
+  // Global numbering follows the first appearance of each group in the table
+  std::vector<int64_t> offsets(n_partitions + 1, 0);
+  for (int64_t p{0}; p < n_partitions; ++p)
+    offsets[p + 1] = offsets[p] + static_cast<int64_t>(partition_groups[p].size());
+
+  _group_rows.resize(offsets[n_partitions]);
+  for (int64_t p{0}; p < n_partitions; ++p)
+    std::ranges::copy(partition_groups[p], _group_rows.begin() + offsets[p]);
+
+  std::vector<int64_t> order(_group_rows.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::ranges::sort(order, {}, [&](int64_t g) { return _group_rows[g]; });
+
+  std::vector<int64_t> ranks(order.size());
+  for (size_t r{0}; r < order.size(); ++r)
+    ranks[order[r]] = static_cast<int64_t>(r);
+  std::ranges::sort(_group_rows);
+
+  at::parallel_for(0, n_partitions, 1, [&](int64_t begin, int64_t end) {
+    for (auto p{begin}; p < end; ++p)
+      for (auto i : _partition_rows[p])
+        _row_groups[i] = ranks[offsets[p] + _row_groups[i]];
+  });
+}
+
+ttb::AnalyticTable ttb::GroupBy::agg(const std::vector<ttb::Aggregate> &aggregates) const {
+  TTB_TIMED_SCOPE("GroupBy::agg");
+  ttb::MemoryOperation memory_operation{"GroupBy::agg"};
+  TTB_COUNT_ROWS(_arrow_tb->num_rows());
+
+  /// Required by arrow for some compute functions
+  utl::initialize_arrow_compute();
+
+  auto n_groups = this->n_groups();
+  auto n_partitions = static_cast<int64_t>(_partition_rows.size());
+
+  std::vector<utl::shp<arrow::Field>> fields;
+  std::vector<utl::shp<arrow::ChunkedArray>> columns;
+
+  // Key values of each group, taken from its first row
+  arrow::compute::ExecContext ctx{ttb::memory_pool()};
+  auto r_keys = _arrow_tb->SelectColumns(_key_indices);
+  if (!r_keys.ok())
+    throw ttb::GroupByError(r_keys.status().ToString());
+  auto r_key_rows =
+      arrow::compute::Take(r_keys.MoveValueUnsafe(), group_by::int64_column(_group_rows),
+                           arrow::compute::TakeOptions::NoBoundsCheck(), &ctx);
+  ttb::throw_if_budget_exceeded(r_key_rows.status());
+  if (!r_key_rows.ok())
+    throw ttb::GroupByError(r_key_rows.status().ToString());
+
+  auto key_rows = r_key_rows.MoveValueUnsafe().table();
+  fields = key_rows->schema()->fields();
+  columns = key_rows->columns();
+
+  // Moments are computed once per numeric column, whatever the number of aggregates using them
+  std::unordered_map<std::string, group_by::Moments> moments;
+  auto column_moments = [&](const std::string &name) -> const group_by::Moments & {
+    if (auto it = moments.find(name); it != moments.end())
+      return it->second;
+
+    auto values = group_by::doubles(_arrow_tb->GetColumnByName(name));
+    group_by::Moments resp{n_groups};
+    at::parallel_for(0, n_partitions, 1, [&](int64_t begin, int64_t end) {
+      for (auto p{begin}; p < end; ++p)
+        for (auto i : _partition_rows[p]) {
+          if (values->IsNull(i))
+            continue;
+          auto g = _row_groups[i];
+          auto value = values->Value(i);
+          auto delta = value - resp.mean[g];
+          resp.count[g] += 1;
+          resp.sum[g] += value;
+          resp.min[g] = std::min(resp.min[g], value);
+          resp.max[g] = std::max(resp.max[g], value);
+          resp.mean[g] += delta / static_cast<double>(resp.count[g]);
+          resp.m2[g] += delta * (value - resp.mean[g]);
+        }
+    });
+
+    return moments.emplace(name, std::move(resp)).first->second;
+  };
+
+  for (const auto &aggregate : aggregates) {
+    auto index = _arrow_tb->schema()->GetFieldIndex(aggregate.column);
+    if (index < 0)
+      throw ttb::GroupByError("Column not found: " + aggregate.column);
+
+    utl::shp<arrow::Array> column;
+    switch (aggregate.aggregation) {
+    case ttb::Aggregation::COUNT: {
+      const auto &values = *_arrow_tb->column(index);
+      std::vector<int64_t> count(n_groups, 0);
+      std::vector<int64_t> offsets{0};
+      for (const auto &chunk : values.chunks())
+        offsets.emplace_back(offsets.back() + chunk->length());
+
+      at::parallel_for(0, n_partitions, 1, [&](int64_t begin, int64_t end) {
+        for (auto p{begin}; p < end; ++p) {
+          size_t c{0};
+          for (auto i : _partition_rows[p]) {
+            while (i >= offsets[c + 1])
+              ++c;
+            if (values.chunk(static_cast<int>(c))->IsValid(i - offsets[c]))
+              ++count[_row_groups[i]];
+          }
+        }
+      });
+      column = group_by::int64_column(count);
+      break;
+    }
+    case ttb::Aggregation::COUNT_DISTINCT: {
+      auto values = group_by::row_keys(*_arrow_tb, {index});
+      std::vector<int64_t> count(n_groups, 0);
+      at::parallel_for(0, n_partitions, 1, [&](int64_t begin, int64_t end) {
+        for (auto p{begin}; p < end; ++p) {
+          // Distinct (group, value) pairs of the partition, keyed by their combined hash
+          group_by::Buckets seen;
+          for (auto i : _partition_rows[p]) {
+            if (values.has_null(i))
+              continue;
+            auto g = _row_groups[i];
+            auto seed = static_cast<uint64_t>(g) * group_by::GROUP_SEED;
+            auto &candidates = seen[values.hash(i) ^ seed];
+            auto is_seen = std::ranges::any_of(candidates, [&](int64_t j) {
+              return _row_groups[j] == g && values.equal(i, values, j);
+            });
+            if (!is_seen) {
+              candidates.emplace_back(i);
+              ++count[g];
+            }
+          }
+        }
+      });
+      column = group_by::int64_column(count);
+      break;
+    }
+    case ttb::Aggregation::SUM: {
+      const auto &stats = column_moments(aggregate.column);
+      column = group_by::double_column(stats.sum, stats.count, 0);
+      break;
+    }
+    case ttb::Aggregation::MEAN: {
+      const auto &stats = column_moments(aggregate.column);
+      column = group_by::double_column(stats.mean, stats.count, 1);
+      break;
+    }
+    case ttb::Aggregation::MIN: {
+      const auto &stats = column_moments(aggregate.column);
+      column = group_by::double_column(stats.min, stats.count, 1);
+      break;
+    }
+    case ttb::Aggregation::MAX: {
+      const auto &stats = column_moments(aggregate.column);
+      column = group_by::double_column(stats.max, stats.count, 1);
+      break;
+    }
+    case ttb::Aggregation::STD: {
+      const auto &stats = column_moments(aggregate.column);
+      std::vector<double> std_dev(n_groups, 0.0);
+      for (int64_t g{0}; g < n_groups; ++g)
+        if (stats.count[g] > 1)
+          std_dev[g] = std::sqrt(stats.m2[g] / static_cast<double>(stats.count[g] - 1));
+      column = group_by::double_column(std_dev, stats.count, 2);
+      break;
+    }
+    }
+
+    auto name = aggregate.name.value_or(aggregate.column + "_" +
+                                        group_by::aggregation_name(aggregate.aggregation));
+    fields.emplace_back(arrow::field(name, column->type()));
+    columns.emplace_back(std::make_shared<arrow::ChunkedArray>(std::move(column)));
+  }
+
+  return ttb::AnalyticTable{arrow::Table::Make(arrow::schema(fields), columns, n_groups)};
+}
@@ -0,0 +1,279 @@
+#include "HashingEncoder.h"
+#include "Instrumentation.h"
+#include "MemoryPool.h"
+#include "detail/hashing.h"
+#include "detail/string_kernels.h"
+
+#include <ATen/Parallel.h>
+#include <algorithm>
+#include <arrow/api.h>
+#include <arrow/util/bitmap_generate.h>
+#include <torch/torch.h>
+#include <vector>
+
+namespace hashing_encoder {
+
+/// Minimum number of rows encoded by each parallel task
+constexpr int64_t GRAIN_ROWS{1 << 14};
+
+/// Gives the sign of signed hashing; the bucket comes from the other bits
+constexpr uint64_t SIGN_BIT{uint64_t{1} << 63U};
+
+/// Buckets and signs of the non-null rows of values, hash_of(i) hashing the value of row i
+template <typename HashOf>
+void encode_rows(const arrow::Array &values, HashOf hash_of, int64_t n_buckets,
+                 bool signed_hashing, int64_t *buckets, int8_t *signs) {
+  auto may_have_nulls = values.null_count() != 0;
+  auto n = static_cast<uint64_t>(n_buckets);
+  at::parallel_for(0, values.length(), GRAIN_ROWS, [&](int64_t begin, int64_t end) {
+    for (auto i{begin}; i < end; ++i) {
+      if (may_have_nulls && values.IsNull(i)) {
+        buckets[i] = -1;
+        if (signs != nullptr)
+          signs[i] = 0;
+        continue;
+      }
+
+      auto hash = hash_of(i);
+      buckets[i] = static_cast<int64_t>((hash & ~SIGN_BIT) % n);
+      if (signs != nullptr)
+        signs[i] = static_cast<int8_t>(signed_hashing && (hash & SIGN_BIT) != 0 ? -1 : 1);
+    }
+  });
+}
+
+template <typename ArrowT>
+const typename ArrowT::c_type *int_values(const arrow::Array &values) {
+  return static_cast<const arrow::NumericArray<ArrowT> &>(values).raw_values();
+}
+
+utl::shp<arrow::Buffer> allocate(int64_t n_bytes) {
+  auto r_buffer = arrow::AllocateBuffer(n_bytes, ttb::memory_pool());
+  ttb::throw_if_budget_exceeded(r_buffer.status());
+  if (!r_buffer.ok())
+    throw ttb::HashingEncoderError(r_buffer.status().ToString());
+
+  return r_buffer.MoveValueUnsafe();
+}
+
+} // namespace hashing_encoder
+
+ttb::HashingEncoder::HashingEncoder(int64_t n_buckets, bool signed_hashing, uint64_t seed)
+    : _n_buckets{n_buckets}, _signed_hashing{signed_hashing}, _seed{seed} {
+  if (n_buckets < 1)
+    throw ttb::HashingEncoderError("Number of buckets must be positive");
+}
+
+void ttb::HashingEncoder::encode(const arrow::Array &values, int64_t *buckets,
+                                 int8_t *signs) const {
+  auto encode_with = [&](auto hash_of) {
+    hashing_encoder::encode_rows(values, hash_of, _n_buckets, _signed_hashing, buckets, signs);
+  };
+  auto encode_ints = [&](const auto *ints) {
+    encode_with([&](int64_t i) { return utl::hash_int(static_cast<int64_t>(ints[i]), _seed); });
+  };
+
+  // Strings are hashed in batches by the string kernels, every hash then giving way to its bucket
+  auto encode_strings = [&](const auto &binary) {
+    auto *hashes = reinterpret_cast<uint64_t *>(buckets);
+    at::parallel_for(0, binary.length(), hashing_encoder::GRAIN_ROWS,
+                     [&](int64_t begin, int64_t end) {
+                       utl::hash_strings(binary.raw_value_offsets() + begin, binary.raw_data(),
+                                         end - begin, _seed, hashes + begin);
+                     });
+    encode_with([&](int64_t i) { return hashes[i]; });
+  };
+
+  switch (values.type_id()) {
+  case arrow::Type::STRING:
+  case arrow::Type::BINARY:
+    encode_strings(static_cast<const arrow::BinaryArray &>(values));
+    break;
+  case arrow::Type::LARGE_STRING:
+  case arrow::Type::LARGE_BINARY:
+    encode_strings(static_cast<const arrow::LargeBinaryArray &>(values));
+    break;
+  case arrow::Type::INT8:
+    encode_ints(hashing_encoder::int_values<arrow::Int8Type>(values));
+    break;
+  case arrow::Type::INT16:
+    encode_ints(hashing_encoder::int_values<arrow::Int16Type>(values));
+    break;
+  case arrow::Type::INT32:
+    encode_ints(hashing_encoder::int_values<arrow::Int32Type>(values));
+    break;
+  case arrow::Type::INT64:
+    encode_ints(hashing_encoder::int_values<arrow::Int64Type>(values));
+    break;
+  case arrow::Type::UINT8:
+    encode_ints(hashing_encoder::int_values<arrow::UInt8Type>(values));
+    break;
+  case arrow::Type::UINT16:
+    encode_ints(hashing_encoder::int_values<arrow::UInt16Type>(values));
+    break;
+  case arrow::Type::UINT32:
+    encode_ints(hashing_encoder::int_values<arrow::UInt32Type>(values));
+    break;
+  case arrow::Type::UINT64:
+    encode_ints(hashing_encoder::int_values<arrow::UInt64Type>(values));
+    break;
+  case arrow::Type::DICTIONARY: {
+    // Every distinct value is hashed once, rows only look up the bucket of their index
+    const auto &dictionary = static_cast<const arrow::DictionaryArray &>(values);
+    const auto &dict_values = *dictionary.dictionary();
+    std::vector<int64_t> dict_buckets(dict_values.length());
+    std::vector<int8_t> dict_signs(dict_values.length());
+    this->encode(dict_values, dict_buckets.data(), dict_signs.data());
+
+    auto may_have_nulls = values.null_count() != 0;
+    at::parallel_for(0, values.length(), hashing_encoder::GRAIN_ROWS,
+                     [&](int64_t begin, int64_t end) {
+                       for (auto i{begin}; i < end; ++i) {
+                         auto is_null = may_have_nulls && values.IsNull(i);
+                         auto index = is_null ? int64_t{0} : dictionary.GetValueIndex(i);
+                         buckets[i] = is_null ? -1 : dict_buckets[index];
+                         if (signs != nullptr)
+                           signs[i] = is_null ? int8_t{0} : dict_signs[index];
+                       }
+                     });
+    break;
+  }
+  default:
+    throw ttb::HashingEncoderError("Unsupported column type: " + values.type()->ToString());
+  }
+}
+
+utl::shp<arrow::ChunkedArray>
+ttb::HashingEncoder::buckets(const arrow::ChunkedArray &values) const {
+  TTB_TIMED_SCOPE("HashingEncoder::buckets");
+  TTB_COUNT_ROWS(values.length());
+
+  arrow::ArrayVector chunks;
+  chunks.reserve(values.num_chunks());
+  for (const auto &chunk : values.chunks()) {
+    auto n_rows = chunk->length();
+    auto buffer = hashing_encoder::allocate(n_rows * static_cast<int64_t>(sizeof(int64_t)));
+    auto *buckets = reinterpret_cast<int64_t *>(buffer->mutable_data());
+    this->encode(*chunk, buckets, nullptr);
+
+    // Rebuilt from the buckets, since nulls of a dictionary may also come from its values
+    auto n_nulls = std::count(buckets, buckets + n_rows, int64_t{-1});
+    utl::shp<arrow::Buffer> validity;
+    if (n_nulls != 0) {
+      auto r_validity = arrow::AllocateEmptyBitmap(n_rows, ttb::memory_pool());
+      ttb::throw_if_budget_exceeded(r_validity.status());
+      if (!r_validity.ok())
+        throw ttb::HashingEncoderError(r_validity.status().ToString());
+
+      validity = r_validity.MoveValueUnsafe();
+      const auto *bucket = buckets;
+      arrow::internal::GenerateBitsUnrolled(validity->mutable_data(), 0, n_rows,
+                                            [&] { return *bucket++ >= 0; });
+    }
+
+    chunks.emplace_back(std::make_shared<arrow::Int64Array>(n_rows, std::move(buffer),
+                                                            std::move(validity), n_nulls));
+  }
+
+  return std::make_shared<arrow::ChunkedArray>(std::move(chunks), arrow::int64());
+}
+
+template <utl::NumericType T>
+ttb::AnalyticTableNumeric<T> ttb::HashingEncoder::dense(const arrow::ChunkedArray &values,
+                                                        const std::string &prefix) const {
+  TTB_TIMED_SCOPE("HashingEncoder::dense");
+  ttb::MemoryOperation memory_operation{"HashingEncoder::dense"};
+  TTB_COUNT_ROWS(values.length());
+
+  auto n_rows = values.length();
+  std::vector<utl::shp<arrow::Buffer>> buffers;
+  std::vector<T *> columns;
+  buffers.reserve(_n_buckets);
+  columns.reserve(_n_buckets);
+  for (int64_t b{0}; b < _n_buckets; ++b) {
+    auto buffer = hashing_encoder::allocate(n_rows * static_cast<int64_t>(sizeof(T)));
+    columns.emplace_back(reinterpret_cast<T *>(buffer->mutable_data()));
+    buffers.emplace_back(std::move(buffer));
+  }
+
+  std::vector<int64_t> buckets;
+  std::vector<int8_t> signs;
+  int64_t row_offset{0};
+  for (const auto &chunk : values.chunks()) {
+    auto n_chunk_rows = chunk->length();
+    buckets.resize(n_chunk_rows);
+    signs.resize(n_chunk_rows);
+    this->encode(*chunk, buckets.data(), signs.data());
+
+    // Every task zeroes and sets its own rows of all the columns
+    at::parallel_for(0, n_chunk_rows, hashing_encoder::GRAIN_ROWS, [&](int64_t begin, int64_t end) {
+      for (auto *column : columns)
+        std::fill(column + row_offset + begin, column + row_offset + end, T{0});
+      for (auto i{begin}; i < end; ++i)
+        if (buckets[i] >= 0)
+          columns[buckets[i]][row_offset + i] = static_cast<T>(signs[i]);
+    });
+    row_offset += n_chunk_rows;
+  }
+
+  std::vector<utl::shp<arrow::Field>> fields;
+  std::vector<utl::shp<arrow::Array>> arrays;
+  fields.reserve(_n_buckets);
+  arrays.reserve(_n_buckets);
+  for (int64_t b{0}; b < _n_buckets; ++b) {
+    fields.emplace_back(arrow::field(prefix + std::to_string(b), utl::arrow_dtype<T>()));
+    arrays.emplace_back(std::make_shared<utl::ArrowArrayType<T>>(n_rows, std::move(buffers[b])));
+  }
+
+  return ttb::AnalyticTableNumeric<T>{arrow::Table::Make(arrow::schema(fields), arrays, n_rows)};
+}
+
+template <utl::NumericType T>
+torch::Tensor ttb::HashingEncoder::sparse(const arrow::ChunkedArray &values) const {
+  TTB_TIMED_SCOPE("HashingEncoder::sparse");
+  TTB_COUNT_ROWS(values.length());
+
+  auto n_rows = values.length();
+  std::vector<int64_t> buckets(n_rows);
+  std::vector<int8_t> signs(n_rows);
+  int64_t row_offset{0};
+  for (const auto &chunk : values.chunks()) {
+    this->encode(*chunk, buckets.data() + row_offset, signs.data() + row_offset);
+    row_offset += chunk->length();
+  }
+
+  auto nnz = n_rows - std::count(buckets.begin(), buckets.end(), int64_t{-1});
+  auto indices = torch::empty({2, nnz}, torch::TensorOptions().dtype(torch::kLong));
+  auto entries = torch::empty({nnz}, torch::TensorOptions().dtype(utl::torch_type<T>()));
+  auto *rows = indices.data_ptr<int64_t>();
+  auto *cols = rows + nnz;
+  auto *signed_ones = entries.data_ptr<T>();
+  int64_t k{0};
+  for (int64_t i{0}; i < n_rows; ++i) {
+    if (buckets[i] < 0)
+      continue;
+    rows[k] = i;
+    cols[k] = buckets[i];
+    signed_ones[k] = static_cast<T>(signs[i]);
+    ++k;
+  }
+
+  // One entry per row, in row order: already coalesced
+  auto resp = torch::sparse_coo_tensor(indices, entries, {n_rows, _n_buckets});
+  resp._coalesced_(true);
+
+  return resp;
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
+#define INSTANTIATE_HASHING_ENCODER_FUNCS(T)                                                       \
+  template ttb::AnalyticTableNumeric<T> ttb::HashingEncoder::dense<T>(const arrow::ChunkedArray &, \
+                                                                      const std::string &) const;  \
+  template torch::Tensor ttb::HashingEncoder::sparse<T>(const arrow::ChunkedArray &) const;
+
+INSTANTIATE_HASHING_ENCODER_FUNCS(int)
+INSTANTIATE_HASHING_ENCODER_FUNCS(int64_t)
+INSTANTIATE_HASHING_ENCODER_FUNCS(float)
+INSTANTIATE_HASHING_ENCODER_FUNCS(double)
+
+#undef INSTANTIATE_HASHING_ENCODER_FUNCS
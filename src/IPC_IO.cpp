@@ -0,0 +1,128 @@
+#include "IPC_IO.h"
+#include "AnalyticTable.h"
+#include "AnalyticTableNumeric.h"
+#include "Converter.h"
+#include "Instrumentation.h"
+#include "MemoryPool.h"
+#include "detail/utils.h"
+
+#include <arrow/io/api.h>
+#include <arrow/io/file.h>
+#include <arrow/ipc/api.h>
+#include <arrow/ipc/reader.h>
+#include <arrow/ipc/writer.h>
+#include <arrow/type_fwd.h>
+#include <arrow/util/compression.h>
+#include <memory>
+
+ttb::AnalyticTable ttb::IPC_IO::read() const {
+  TTB_TIMED_SCOPE("IPC_IO::read");
+  ttb::MemoryOperation memory_operation{"IPC_IO::read"};
+  /// Record batches of uncompressed files point straight into the mapped region
+  auto r_infile = arrow::io::MemoryMappedFile::Open(_path, arrow::io::FileMode::READ);
+  if (!r_infile.ok())
+    throw ttb::IPC_IOError(r_infile.status().ToString());
+
+  auto read_opts = arrow::ipc::IpcReadOptions::Defaults();
+  read_opts.memory_pool = ttb::memory_pool();
+  read_opts.use_threads = true;
+
+  auto r_reader = arrow::ipc::RecordBatchFileReader::Open(r_infile.MoveValueUnsafe(), read_opts);
+  if (!r_reader.ok())
+    throw ttb::IPC_IOError(r_reader.status().ToString());
+
+  auto r_table = r_reader.MoveValueUnsafe()->ToTable();
+  ttb::throw_if_budget_exceeded(r_table.status());
+  if (!r_table.ok())
+    throw ttb::IPC_IOError(r_table.status().ToString());
+
+  TTB_COUNT_ROWS(r_table.ValueUnsafe()->num_rows());
+  TTB_COUNT_BYTES(std::filesystem::file_size(_path));
+  return ttb::AnalyticTable{r_table.MoveValueUnsafe()};
+}
+
+template <utl::NumericType T>
+ttb::AnalyticTableNumeric<T> ttb::IPC_IO::read_numeric() const {
+  auto table = this->read();
+
+  return ttb::AnalyticTableNumeric<T>{std::move(table)};
+}
+
+namespace write {
+
+arrow::ipc::IpcWriteOptions write_options(arrow::Compression::type compression) {
+  auto opts = arrow::ipc::IpcWriteOptions::Defaults();
+  opts.memory_pool = ttb::memory_pool();
+  opts.use_threads = true;
+  /// IPC files hold a single dictionary per column, while appended tables have one per chunk
+  opts.unify_dictionaries = true;
+
+  if (compression == arrow::Compression::UNCOMPRESSED)
+    return opts;
+
+  if (compression != arrow::Compression::LZ4_FRAME && compression != arrow::Compression::ZSTD)
+    throw ttb::IPC_IOError("IPC files only support LZ4_FRAME or ZSTD compression");
+
+  auto r_codec = arrow::util::Codec::Create(compression);
+  if (!r_codec.ok())
+    throw ttb::IPC_IOError(r_codec.status().ToString());
+
+  opts.codec = r_codec.MoveValueUnsafe();
+
+  return opts;
+}
+
+} // namespace write
+
+void ttb::IPC_IO::write(const ttb::AnalyticTable &table) const {
+  TTB_TIMED_SCOPE("IPC_IO::write");
+  TTB_COUNT_ROWS(table.n_rows());
+  auto opts = write::write_options(_compression);
+
+  auto r_outfile = arrow::io::FileOutputStream::Open(_path);
+  if (!r_outfile.ok())
+    throw ttb::IPC_IOError(r_outfile.status().ToString());
+
+  auto &arrow_tb = table.arrow_table();
+  auto r_writer = arrow::ipc::MakeFileWriter(r_outfile.MoveValueUnsafe(), arrow_tb->schema(), opts);
+  if (!r_writer.ok())
+    throw ttb::IPC_IOError(r_writer.status().ToString());
+
+  auto writer = r_writer.MoveValueUnsafe();
+  auto status = writer->WriteTable(*arrow_tb, 1 << 20);
+  ttb::throw_if_budget_exceeded(status);
+  if (!status.ok())
+    throw ttb::IPC_IOError(status.ToString());
+
+  status = writer->Close();
+  ttb::throw_if_budget_exceeded(status);
+  if (!status.ok())
+    throw ttb::IPC_IOError(status.ToString());
+}
+
+template <utl::NumericType T>
+void ttb::IPC_IO::write(torch::Tensor &&tensor) const {
+  auto table = ttb::Converter::analytic_table<T>(std::move(tensor));
+
+  this->write(table);
+}
+
+template <utl::NumericType T>
+void ttb::IPC_IO::write(ttb::XYMatrix &&xy_matrix) const {
+  auto table = ttb::Converter::analytic_table<T>(std::move(xy_matrix));
+
+  this->write(table);
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
+#define INSTANTIATE_IPC_IO_TEMPLATES(T)                                                            \
+  template ttb::AnalyticTableNumeric<T> ttb::IPC_IO::read_numeric<T>() const;                      \
+  template void ttb::IPC_IO::write<T>(torch::Tensor && tensor) const;                              \
+  template void ttb::IPC_IO::write<T>(ttb::XYMatrix &&) const;
+
+INSTANTIATE_IPC_IO_TEMPLATES(int)
+INSTANTIATE_IPC_IO_TEMPLATES(int64_t)
+INSTANTIATE_IPC_IO_TEMPLATES(float)
+INSTANTIATE_IPC_IO_TEMPLATES(double)
+
+#undef INSTANTIATE_IPC_IO_TEMPLATES
@@ -0,0 +1,195 @@
+#include "Instrumentation.h"
+#include "detail/utils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace instrumentation {
+
+/// Events of one thread; its mutex is only contended while the buffers are queried
+struct ThreadBuffer {
+    uint32_t thread;
+    std::mutex mutex;
+    std::deque<ttb::TimedEvent> events;
+    std::unordered_map<std::string_view, ttb::TimedSummary> totals;
+};
+
+/// Buffers outlive their threads, so events of finished workers stay queryable
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    std::atomic<uint32_t> next_thread{0};
+};
+
+/// Origin of event timestamps, set when the library is loaded
+const std::chrono::steady_clock::time_point EPOCH{std::chrono::steady_clock::now()};
+
+Registry &registry() {
+  static Registry resp;
+  return resp;
+}
+
+ThreadBuffer &thread_buffer() {
+  thread_local std::shared_ptr<ThreadBuffer> resp = [] {
+    auto &reg = registry();
+    auto buffer = std::make_shared<ThreadBuffer>();
+    buffer->thread = reg.next_thread++;
+
+    std::scoped_lock lock{reg.mutex};
+    reg.buffers.emplace_back(buffer);
+    return buffer;
+  }();
+
+  return *resp;
+}
+
+std::vector<std::shared_ptr<ThreadBuffer>> buffers() {
+  auto &reg = registry();
+  std::scoped_lock lock{reg.mutex};
+  return reg.buffers;
+}
+
+std::string escaped(std::string_view text) {
+  std::string resp;
+  resp.reserve(text.size());
+  for (auto c : text) {
+    if (c == '"' || c == '\\')
+      resp.push_back('\\');
+    resp.push_back(c);
+  }
+
+  return resp;
+}
+
+void write_file(const std::filesystem::path &path, const std::string &content) {
+  std::ofstream ofs(path, std::ios::binary);
+  if (!ofs.is_open())
+    throw ttb::InstrumentationError("Failed to open " + path.string());
+
+  ofs << content;
+}
+
+} // namespace instrumentation
+
+ttb::ScopedTimer::~ScopedTimer() {
+  auto end = std::chrono::steady_clock::now();
+  auto &buffer = instrumentation::thread_buffer();
+
+  ttb::TimedEvent event{
+      _name,
+      buffer.thread,
+      std::chrono::duration_cast<std::chrono::nanoseconds>(_start - instrumentation::EPOCH).count(),
+      std::chrono::duration_cast<std::chrono::nanoseconds>(end - _start).count(),
+      _n_rows,
+      _n_bytes};
+
+  std::scoped_lock lock{buffer.mutex};
+  if (buffer.events.size() == ttb::Instrumentation::MAX_EVENTS_PER_THREAD)
+    buffer.events.pop_front();
+  buffer.events.emplace_back(event);
+
+  auto &total = buffer.totals[_name];
+  auto seconds = static_cast<double>(event.duration_ns) * 1e-9;
+  ++total.calls;
+  total.seconds += seconds;
+  total.max_seconds = std::max(total.max_seconds, seconds);
+  total.n_rows += _n_rows;
+  total.n_bytes += _n_bytes;
+}
+
+std::vector<ttb::TimedSummary> ttb::Instrumentation::summary() {
+  std::unordered_map<std::string_view, ttb::TimedSummary> totals;
+  for (const auto &buffer : instrumentation::buffers()) {
+    std::scoped_lock lock{buffer->mutex};
+    for (const auto &[name, thread_total] : buffer->totals) {
+      auto &total = totals[name];
+      total.calls += thread_total.calls;
+      total.seconds += thread_total.seconds;
+      total.max_seconds = std::max(total.max_seconds, thread_total.max_seconds);
+      total.n_rows += thread_total.n_rows;
+      total.n_bytes += thread_total.n_bytes;
+    }
+  }
+
+  std::vector<ttb::TimedSummary> resp;
+  resp.reserve(totals.size());
+  for (auto &[name, total] : totals) {
+    total.name = std::string{name};
+    resp.emplace_back(std::move(total));
+  }
+  std::ranges::sort(resp, std::ranges::greater{}, &ttb::TimedSummary::seconds);
+
+  return resp;
+}
+
+std::vector<ttb::TimedEvent> ttb::Instrumentation::events() {
+  std::vector<ttb::TimedEvent> resp;
+  for (const auto &buffer : instrumentation::buffers()) {
+    std::scoped_lock lock{buffer->mutex};
+    resp.insert(resp.end(), buffer->events.begin(), buffer->events.end());
+  }
+  std::ranges::sort(resp, std::ranges::less{}, &ttb::TimedEvent::start_ns);
+
+  return resp;
+}
+
+std::string ttb::Instrumentation::to_json() {
+  std::ostringstream resp;
+  resp << std::setprecision(9) << "[";
+  auto totals = summary();
+  for (size_t i{0}; i < totals.size(); ++i) {
+    const auto &total = totals[i];
+    resp << (i == 0 ? "" : ",") << R"({"name":")" << instrumentation::escaped(total.name)
+         << R"(","calls":)" << total.calls << R"(,"seconds":)" << total.seconds
+         << R"(,"max_seconds":)" << total.max_seconds << R"(,"rows":)" << total.n_rows
+         << R"(,"bytes":)" << total.n_bytes << "}";
+  }
+  resp << "]";
+
+  return resp.str();
+}
+
+std::string ttb::Instrumentation::to_chrome_trace() {
+  std::ostringstream resp;
+  resp << std::fixed << std::setprecision(3) << R"({"displayTimeUnit":"ms","traceEvents":[)";
+  auto all_events = events();
+  for (size_t i{0}; i < all_events.size(); ++i) {
+    const auto &event = all_events[i];
+    resp << (i == 0 ? "" : ",") << R"({"name":")" << instrumentation::escaped(event.name)
+         << R"(","cat":")" << utl::LIBRARY_NAME << R"(","ph":"X","ts":)"
+         << static_cast<double>(event.start_ns) * 1e-3
+         << R"(,"dur":)" << static_cast<double>(event.duration_ns) * 1e-3
+         << R"(,"pid":1,"tid":)" << event.thread << R"(,"args":{"rows":)" << event.n_rows
+         << R"(,"bytes":)" << event.n_bytes << "}}";
+  }
+  resp << "]}";
+
+  return resp.str();
+}
+
+void ttb::Instrumentation::dump_json(const std::filesystem::path &path) {
+  instrumentation::write_file(path, to_json());
+}
+
+void ttb::Instrumentation::dump_chrome_trace(const std::filesystem::path &path) {
+  instrumentation::write_file(path, to_chrome_trace());
+}
+
+void ttb::Instrumentation::reset() {
+  for (const auto &buffer : instrumentation::buffers()) {
+    std::scoped_lock lock{buffer->mutex};
+    buffer->events.clear();
+    buffer->totals.clear();
+  }
+}
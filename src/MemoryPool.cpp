@@ -0,0 +1,203 @@
+#include "MemoryPool.h"
+
+#include <algorithm>
+#include <arrow/memory_pool.h>
+#include <arrow/status.h>
+#include <atomic>
+#include <bit>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+namespace memory_pool {
+
+std::atomic<arrow::MemoryPool *> global_pool{nullptr};
+
+thread_local arrow::MemoryPool *scoped_pool{nullptr};
+
+/// Marks OutOfMemory statuses raised by a TrackingMemoryPool budget
+class BudgetDetail : public arrow::StatusDetail {
+  public:
+    static constexpr const char *TYPE_ID{"ttb::MemoryBudget"};
+
+    BudgetDetail(int64_t limit, int64_t in_use, int64_t requested)
+        : _limit{limit}, _in_use{in_use}, _requested{requested} {};
+
+    [[nodiscard]] const char *type_id() const override { return TYPE_ID; }
+
+    [[nodiscard]] std::string ToString() const override {
+      return "Memory budget of " + std::to_string(_limit) + " bytes exceeded: " +
+             std::to_string(_requested) + " bytes requested with " + std::to_string(_in_use) +
+             " in use";
+    }
+
+  private:
+    int64_t _limit;
+    int64_t _in_use;
+    int64_t _requested;
+};
+
+void update_max(std::atomic<int64_t> &max, int64_t value) {
+  auto current = max.load();
+  while (value > current && !max.compare_exchange_weak(current, value)) {
+  }
+}
+
+} // namespace memory_pool
+
+arrow::MemoryPool *ttb::memory_pool() {
+  if (memory_pool::scoped_pool != nullptr)
+    return memory_pool::scoped_pool;
+
+  auto global = memory_pool::global_pool.load();
+  return global != nullptr ? global : arrow::default_memory_pool();
+}
+
+void ttb::set_memory_pool(arrow::MemoryPool *pool) { memory_pool::global_pool.store(pool); }
+
+ttb::MemoryPoolScope::MemoryPoolScope(arrow::MemoryPool *pool)
+    : _previous{memory_pool::scoped_pool} {
+  memory_pool::scoped_pool = pool;
+}
+
+ttb::MemoryPoolScope::~MemoryPoolScope() { memory_pool::scoped_pool = _previous; }
+
+ttb::TrackingMemoryPool::TrackingMemoryPool(std::optional<int64_t> limit,
+                                            arrow::MemoryPool *upstream)
+    : _upstream{upstream}, _limit{limit.value_or(NO_LIMIT)} {
+  if (_upstream == nullptr)
+    throw std::invalid_argument("Upstream memory pool is null");
+}
+
+arrow::Status ttb::TrackingMemoryPool::reserve(int64_t n_bytes) {
+  auto current = _current.fetch_add(n_bytes) + n_bytes;
+  auto limit = _limit.load();
+  if (limit != NO_LIMIT && n_bytes > 0 && current > limit) {
+    _current.fetch_sub(n_bytes);
+    auto detail =
+        std::make_shared<memory_pool::BudgetDetail>(limit, current - n_bytes, n_bytes);
+    return {arrow::StatusCode::OutOfMemory, "torchtb memory budget exceeded", detail};
+  }
+
+  memory_pool::update_max(_peak, current);
+  if (n_bytes > 0)
+    this->track_operations(current);
+
+  return arrow::Status::OK();
+}
+
+void ttb::TrackingMemoryPool::release(int64_t n_bytes) { _current.fetch_sub(n_bytes); }
+
+void ttb::TrackingMemoryPool::track_operations(int64_t current) {
+  for (auto open = _open_operations.load(); open != 0; open &= open - 1)
+    memory_pool::update_max(_operations[std::countr_zero(open)].high, current);
+}
+
+int ttb::TrackingMemoryPool::open_operation(const char *name) {
+  auto claimed = _claimed_operations.load();
+  int index{NO_OPERATION};
+  do {
+    if (~claimed == 0)
+      return NO_OPERATION;
+    index = std::countr_one(claimed);
+  } while (!_claimed_operations.compare_exchange_weak(claimed, claimed | (uint64_t{1} << index)));
+
+  auto &operation = _operations[index];
+  operation.name = name;
+  operation.baseline = _current.load();
+  operation.high.store(operation.baseline);
+  _open_operations.fetch_or(uint64_t{1} << index);
+  return index;
+}
+
+void ttb::TrackingMemoryPool::close_operation(int index) {
+  _open_operations.fetch_and(~(uint64_t{1} << index));
+  auto &operation = _operations[index];
+  {
+    std::scoped_lock lock{_mutex};
+    auto &peak = _operation_peaks[operation.name];
+    peak = std::max(peak, operation.high.load() - operation.baseline);
+  }
+  _claimed_operations.fetch_and(~(uint64_t{1} << index));
+}
+
+arrow::Status ttb::TrackingMemoryPool::Allocate(int64_t size, int64_t alignment, uint8_t **out) {
+  auto status = this->reserve(size);
+  if (!status.ok())
+    return status;
+
+  status = _upstream->Allocate(size, alignment, out);
+  if (!status.ok()) {
+    this->release(size);
+    return status;
+  }
+
+  _total.fetch_add(size);
+  _n_allocations.fetch_add(1);
+  return status;
+}
+
+arrow::Status ttb::TrackingMemoryPool::Reallocate(int64_t old_size, int64_t new_size,
+                                                  int64_t alignment, uint8_t **ptr) {
+  auto growth = new_size - old_size;
+  auto status = this->reserve(growth);
+  if (!status.ok())
+    return status;
+
+  status = _upstream->Reallocate(old_size, new_size, alignment, ptr);
+  if (!status.ok()) {
+    this->release(growth);
+    return status;
+  }
+
+  if (growth > 0)
+    _total.fetch_add(growth);
+  return status;
+}
+
+void ttb::TrackingMemoryPool::Free(uint8_t *buffer, int64_t size, int64_t alignment) {
+  _upstream->Free(buffer, size, alignment);
+  this->release(size);
+}
+
+std::optional<int64_t> ttb::TrackingMemoryPool::limit() const {
+  auto limit = _limit.load();
+  return limit == NO_LIMIT ? std::nullopt : std::optional<int64_t>{limit};
+}
+
+void ttb::TrackingMemoryPool::set_limit(std::optional<int64_t> limit) {
+  _limit.store(limit.value_or(NO_LIMIT));
+}
+
+std::unordered_map<std::string, int64_t> ttb::TrackingMemoryPool::operation_peaks() const {
+  std::scoped_lock lock{_mutex};
+  return _operation_peaks;
+}
+
+void ttb::TrackingMemoryPool::reset_peaks() {
+  _peak.store(_current.load());
+
+  std::scoped_lock lock{_mutex};
+  _operation_peaks.clear();
+}
+
+ttb::MemoryOperation::MemoryOperation(const char *name)
+    : _pool{dynamic_cast<ttb::TrackingMemoryPool *>(ttb::memory_pool())} {
+  if (_pool != nullptr)
+    _operation = _pool->open_operation(name);
+}
+
+ttb::MemoryOperation::~MemoryOperation() {
+  if (_pool != nullptr && _operation != ttb::TrackingMemoryPool::NO_OPERATION)
+    _pool->close_operation(_operation);
+}
+
+void ttb::throw_if_budget_exceeded(const arrow::Status &status) {
+  if (status.ok() || !status.IsOutOfMemory())
+    return;
+
+  auto detail = status.detail();
+  if (detail != nullptr && std::string{detail->type_id()} == memory_pool::BudgetDetail::TYPE_ID)
+    throw ttb::MemoryBudgetError(status.ToString());
+}
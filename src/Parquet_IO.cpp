@@ -2,36 +2,88 @@
 #include "AnalyticTable.h"
 #include "AnalyticTableNumeric.h"
 #include "Converter.h"
+#include "Instrumentation.h"
+#include "MemoryPool.h"
 #include "detail/utils.h"
 
+#include <algorithm>
 #include <arrow/io/api.h>
 #include <arrow/type_fwd.h>
 #include <expected>
 #include <memory>
 #include <parquet/arrow/reader.h>
 #include <parquet/arrow/writer.h>
+#include <parquet/file_reader.h>
+#include <parquet/metadata.h>
 #include <parquet/platform.h>
 #include <parquet/properties.h>
 #include <parquet/type_fwd.h>
 
+namespace parquet_io {
+
+/// Whether every data page of a column chunk holds dictionary codes
+bool dictionary_encoded(const parquet::ColumnChunkMetaData &column_chunk) {
+  if (!column_chunk.has_dictionary_page())
+    return false;
+
+  // Writers fall back to plain pages once a dictionary grows too large
+  return std::ranges::none_of(column_chunk.encoding_stats(), [](const auto &stats) {
+    return stats.page_type != parquet::PageType::DICTIONARY_PAGE &&
+           stats.encoding == parquet::Encoding::PLAIN;
+  });
+}
+
+/**
+ * @brief Reader properties reading string and binary columns dictionary encoded in every row
+ * group as arrow dictionary arrays, keeping their codes instead of decoding every value
+ *
+ */
+parquet::ArrowReaderProperties reader_properties(const parquet::FileMetaData &metadata) {
+  parquet::ArrowReaderProperties properties{true};
+  const auto &schema = *metadata.schema();
+  for (int c{0}; c < schema.num_columns(); ++c) {
+    if (schema.Column(c)->physical_type() != parquet::Type::BYTE_ARRAY)
+      continue;
+
+    auto encoded = metadata.num_row_groups() > 0;
+    for (int g{0}; encoded && g < metadata.num_row_groups(); ++g)
+      encoded = dictionary_encoded(*metadata.RowGroup(g)->ColumnChunk(c));
+    properties.set_read_dictionary(c, encoded);
+  }
+
+  return properties;
+}
+
+} // namespace parquet_io
+
 ttb::AnalyticTable ttb::Parquet_IO::read() const {
+  TTB_TIMED_SCOPE("Parquet_IO::read");
+  ttb::MemoryOperation memory_operation{"Parquet_IO::read"};
   auto r_infile = arrow::io::ReadableFile::Open(_path);
   if (!r_infile.ok())
     throw ttb::Parquet_IOError(r_infile.status().ToString());
 
-  auto r_reader =
-      parquet::arrow::OpenFile(r_infile.MoveValueUnsafe(), arrow::default_memory_pool());
+  parquet::arrow::FileReaderBuilder builder;
+  auto status =
+      builder.Open(r_infile.MoveValueUnsafe(), parquet::ReaderProperties{ttb::memory_pool()});
+  if (!status.ok())
+    throw ttb::Parquet_IOError(status.ToString());
+
+  auto properties = parquet_io::reader_properties(*builder.raw_reader()->metadata());
+  auto r_reader = builder.memory_pool(ttb::memory_pool())->properties(properties)->Build();
   if (!r_reader.ok())
     throw ttb::Parquet_IOError(r_reader.status().ToString());
 
   auto reader = r_reader.MoveValueUnsafe();
-  reader->set_use_threads(true);
 
   utl::shp<arrow::Table> table;
-  auto status = reader->ReadTable(&table);
+  status = reader->ReadTable(&table);
+  ttb::throw_if_budget_exceeded(status);
   if (!status.ok())
     throw ttb::Parquet_IOError(status.ToString());
 
+  TTB_COUNT_ROWS(table->num_rows());
+  TTB_COUNT_BYTES(std::filesystem::file_size(_path));
   return ttb::AnalyticTable{std::move(table)};
 }
 
@@ -43,6 +95,8 @@ ttb::AnalyticTableNumeric<T> ttb::Parquet_IO::read_numeric() const {
 }
 
 void ttb::Parquet_IO::write(const ttb::AnalyticTable &table) const {
+  TTB_TIMED_SCOPE("Parquet_IO::write");
+  TTB_COUNT_ROWS(table.n_rows());
   auto r_outfile = arrow::io::FileOutputStream::Open(_path);
   if (!r_outfile.ok())
     throw ttb::Parquet_IOError(r_outfile.status().ToString());
@@ -55,9 +109,10 @@ void ttb::Parquet_IO::write(const ttb::AnalyticTable &table) const {
   auto arrow_props = parquet::ArrowWriterProperties::Builder().store_schema()->build();
 
   auto status =
-      parquet::arrow::WriteTable(*table.arrow_table(), arrow::default_memory_pool(),
+      parquet::arrow::WriteTable(*table.arrow_table(), ttb::memory_pool(),
                                  r_outfile.MoveValueUnsafe(), 1 << 20, parquet_props, arrow_props);
 
+  ttb::throw_if_budget_exceeded(status);
   if (!status.ok())
     throw ttb::Parquet_IOError(status.ToString());
 };
@@ -71,13 +126,9 @@ void ttb::Parquet_IO::write(torch::Tensor &&tensor) const {
 
 template <utl::NumericType T>
 void ttb::Parquet_IO::write(ttb::XYMatrix &&xy_matrix) const {
-  auto my_xy_matrix = std::move(xy_matrix);
-
-  auto X = my_xy_matrix.X().clone();
-  auto Y = my_xy_matrix.Y().clone();
-  auto XY = torch::cat({std::move(X), std::move(Y)}, 1);
+  auto table = ttb::Converter::analytic_table<T>(std::move(xy_matrix));
 
-  this->write<T>(std::move(XY));
+  this->write(table);
 }
 
 // NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
@@ -0,0 +1,274 @@
+#include "Snapshot_IO.h"
+#include "Instrumentation.h"
+#include "TrainingBundle.h"
+#include "XYMatrix.h"
+#include "detail/utils.h"
+
+#include <ATen/ops/from_blob.h>
+#include <arrow/io/file.h>
+#include <arrow/util/int_util_overflow.h>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace snapshot {
+
+constexpr std::array<char, 8> MAGIC{'T', 'T', 'B', 'S', 'N', 'A', 'P', '\0'};
+constexpr uint32_t VERSION{1};
+
+/// Blobs start at page boundaries, so mapped tensors are suitably aligned for any dtype
+constexpr uint64_t ALIGNMENT{4096};
+
+enum class Kind : uint32_t { XY_MATRIX = 0, TRAINING_BUNDLE = 1 };
+
+struct FileHeader {
+    std::array<char, 8> magic;
+    uint32_t version;
+    Kind kind;
+    uint32_t n_blobs;
+    uint32_t n_normz_stats;
+};
+
+struct BlobHeader {
+    int32_t scalar_type;
+    int32_t element_size;
+    int64_t n_rows;
+    int64_t n_cols;
+    uint64_t offset;
+    uint64_t n_bytes;
+};
+
+struct NormzRecord {
+    int32_t X_col;
+    int32_t normalization;
+    double first;
+    double second;
+};
+
+/**
+ * @brief Whether a blob header read from a file of file_size bytes describes a tensor the writer
+ * could have stored there: a known dtype, a page-aligned offset and a size lying within the file,
+ * all checked before any of them is trusted or can overflow
+ *
+ */
+bool is_valid(const BlobHeader &blob, uint64_t file_size) {
+  if (blob.scalar_type < 0 ||
+      blob.scalar_type >= static_cast<int32_t>(torch::ScalarType::NumOptions) ||
+      blob.scalar_type == static_cast<int32_t>(torch::ScalarType::Undefined))
+    return false;
+  if (c10::elementSize(static_cast<torch::ScalarType>(blob.scalar_type)) !=
+          static_cast<size_t>(blob.element_size) ||
+      blob.n_rows < 0 || blob.n_cols < 0 || blob.offset % ALIGNMENT != 0)
+    return false;
+
+  uint64_t n_bytes{0};
+  uint64_t end{0};
+  return !arrow::internal::MultiplyWithOverflow(static_cast<uint64_t>(blob.n_rows),
+                                                static_cast<uint64_t>(blob.n_cols), &n_bytes) &&
+         !arrow::internal::MultiplyWithOverflow(
+             n_bytes, static_cast<uint64_t>(blob.element_size), &n_bytes) &&
+         n_bytes == blob.n_bytes &&
+         !arrow::internal::AddWithOverflow(blob.offset, blob.n_bytes, &end) && end <= file_size;
+}
+
+uint64_t align(uint64_t offset) {
+  return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+void write_bytes(arrow::io::OutputStream &out, const void *data, int64_t n_bytes) {
+  auto status = out.Write(data, n_bytes);
+  if (!status.ok())
+    throw ttb::Snapshot_IOError(status.ToString());
+}
+
+void write_file(const std::filesystem::path &path, Kind kind,
+                const std::vector<torch::Tensor> &tensors,
+                const std::vector<ttb::NormzStats> &normz_stats) {
+  std::vector<torch::Tensor> blobs;
+  blobs.reserve(tensors.size());
+  for (const auto &tensor : tensors) {
+    if (!tensor.device().is_cpu())
+      throw ttb::Snapshot_IOError("Tensor is not stored in CPU");
+    blobs.emplace_back(tensor.contiguous());
+  }
+
+  FileHeader header{MAGIC, VERSION, kind, static_cast<uint32_t>(blobs.size()),
+                    static_cast<uint32_t>(normz_stats.size())};
+
+  std::vector<NormzRecord> records;
+  records.reserve(normz_stats.size());
+  for (const auto &stats : normz_stats)
+    records.emplace_back(stats.X_col, static_cast<int32_t>(stats.normalization), stats.first,
+                         stats.second);
+
+  auto offset = align(sizeof(FileHeader) + blobs.size() * sizeof(BlobHeader) +
+                      records.size() * sizeof(NormzRecord));
+  std::vector<BlobHeader> blob_headers;
+  blob_headers.reserve(blobs.size());
+  for (const auto &blob : blobs) {
+    auto n_bytes = static_cast<uint64_t>(blob.numel()) * blob.element_size();
+    blob_headers.emplace_back(static_cast<int32_t>(blob.scalar_type()),
+                              static_cast<int32_t>(blob.element_size()), blob.size(0),
+                              blob.size(1), offset, n_bytes);
+    offset = align(offset + n_bytes);
+  }
+
+  auto r_outfile = arrow::io::FileOutputStream::Open(path);
+  if (!r_outfile.ok())
+    throw ttb::Snapshot_IOError(r_outfile.status().ToString());
+  auto outfile = r_outfile.MoveValueUnsafe();
+
+  write_bytes(*outfile, &header, sizeof(FileHeader));
+  write_bytes(*outfile, blob_headers.data(), blob_headers.size() * sizeof(BlobHeader));
+  write_bytes(*outfile, records.data(), records.size() * sizeof(NormzRecord));
+
+  std::vector<char> padding(ALIGNMENT, 0);
+  for (size_t i{0}; i < blobs.size(); ++i) {
+    auto r_position = outfile->Tell();
+    if (!r_position.ok())
+      throw ttb::Snapshot_IOError(r_position.status().ToString());
+
+    auto gap = blob_headers[i].offset - static_cast<uint64_t>(r_position.ValueUnsafe());
+    write_bytes(*outfile, padding.data(), static_cast<int64_t>(gap));
+    write_bytes(*outfile, blobs[i].data_ptr(), static_cast<int64_t>(blob_headers[i].n_bytes));
+  }
+
+  auto status = outfile->Close();
+  if (!status.ok())
+    throw ttb::Snapshot_IOError(status.ToString());
+}
+
+/**
+ * @brief Private read-write mapping of a whole file; writes to the pages never reach the file
+ *
+ */
+class MappedFile {
+  public:
+    MappedFile(const MappedFile &) = delete;
+    MappedFile(MappedFile &&) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile &operator=(MappedFile &&) = delete;
+
+    explicit MappedFile(const std::filesystem::path &path) {
+      auto fd = ::open(path.c_str(), O_RDONLY);
+      if (fd < 0)
+        throw ttb::Snapshot_IOError("Could not open " + path.string());
+
+      struct stat st{};
+      if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(FileHeader))) {
+        ::close(fd);
+        throw ttb::Snapshot_IOError("Invalid snapshot file " + path.string());
+      }
+
+      _size = static_cast<uint64_t>(st.st_size);
+      _data = ::mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+      ::close(fd);
+      if (_data == MAP_FAILED)
+        throw ttb::Snapshot_IOError("Could not map " + path.string());
+    }
+
+    ~MappedFile() { ::munmap(_data, _size); }
+
+    [[nodiscard]] uint8_t *data() const { return static_cast<uint8_t *>(_data); }
+    [[nodiscard]] uint64_t size() const { return _size; }
+
+  private:
+    void *_data{nullptr};
+    uint64_t _size{0};
+};
+
+struct Snapshot {
+    std::vector<torch::Tensor> tensors;
+    std::vector<ttb::NormzStats> normz_stats;
+    uint64_t n_bytes{0};
+};
+
+Snapshot read_file(const std::filesystem::path &path, Kind kind) {
+  auto mapped = std::make_shared<MappedFile>(path);
+
+  FileHeader header{};
+  std::memcpy(&header, mapped->data(), sizeof(FileHeader));
+  if (header.magic != MAGIC || header.version != VERSION)
+    throw ttb::Snapshot_IOError("Not a torchtb snapshot: " + path.string());
+  if (header.kind != kind)
+    throw ttb::Snapshot_IOError("Snapshot holds a different kind of object");
+
+  auto metadata_size = sizeof(FileHeader) + header.n_blobs * sizeof(BlobHeader) +
+                       header.n_normz_stats * sizeof(NormzRecord);
+  if (metadata_size > mapped->size())
+    throw ttb::Snapshot_IOError("Truncated snapshot header");
+
+  std::vector<BlobHeader> blob_headers(header.n_blobs);
+  std::memcpy(blob_headers.data(), mapped->data() + sizeof(FileHeader),
+              header.n_blobs * sizeof(BlobHeader));
+
+  std::vector<NormzRecord> records(header.n_normz_stats);
+  std::memcpy(records.data(),
+              mapped->data() + sizeof(FileHeader) + header.n_blobs * sizeof(BlobHeader),
+              header.n_normz_stats * sizeof(NormzRecord));
+
+  Snapshot resp;
+  resp.n_bytes = mapped->size();
+  for (const auto &blob : blob_headers) {
+    if (!is_valid(blob, mapped->size()))
+      throw ttb::Snapshot_IOError("Corrupted snapshot blob");
+
+    auto scalar_type = static_cast<torch::ScalarType>(blob.scalar_type);
+
+    /// The deleter keeps the mapping alive while any tensor points into it
+    auto tensor = torch::from_blob(
+        mapped->data() + blob.offset, {blob.n_rows, blob.n_cols},
+        [mapped](void *) {}, torch::TensorOptions().dtype(scalar_type));
+    resp.tensors.emplace_back(std::move(tensor));
+  }
+
+  for (const auto &record : records)
+    resp.normz_stats.emplace_back(record.X_col,
+                                  static_cast<ttb::Normalization>(record.normalization),
+                                  record.first, record.second);
+
+  return resp;
+}
+
+} // namespace snapshot
+
+void ttb::Snapshot_IO::write(const ttb::XYMatrix &xy_matrix) const {
+  TTB_TIMED_SCOPE("Snapshot_IO::write");
+  TTB_COUNT_ROWS(xy_matrix.n_rows());
+  snapshot::write_file(_path, snapshot::Kind::XY_MATRIX, {xy_matrix.X(), xy_matrix.Y()}, {});
+}
+
+void ttb::Snapshot_IO::write(const ttb::TrainingBundle &bundle) const {
+  TTB_TIMED_SCOPE("Snapshot_IO::write");
+  TTB_COUNT_ROWS(bundle.XY_train().n_rows() + bundle.XY_eval().n_rows());
+  snapshot::write_file(_path, snapshot::Kind::TRAINING_BUNDLE,
+                       {bundle.X_train(), bundle.Y_train(), bundle.X_eval(), bundle.Y_eval()},
+                       bundle.normz_stats());
+}
+
+ttb::XYMatrix ttb::Snapshot_IO::read_xy_matrix() const {
+  TTB_TIMED_SCOPE("Snapshot_IO::read");
+  auto snap = snapshot::read_file(_path, snapshot::Kind::XY_MATRIX);
+  if (snap.tensors.size() != 2)
+    throw Snapshot_IOError("Corrupted snapshot");
+  TTB_COUNT_BYTES(snap.n_bytes);
+
+  return ttb::XYMatrix{std::move(snap.tensors[0]), std::move(snap.tensors[1])};
+}
+
+ttb::TrainingBundle ttb::Snapshot_IO::read_training_bundle() const {
+  TTB_TIMED_SCOPE("Snapshot_IO::read");
+  auto snap = snapshot::read_file(_path, snapshot::Kind::TRAINING_BUNDLE);
+  if (snap.tensors.size() != 4)
+    throw Snapshot_IOError("Corrupted snapshot");
+  TTB_COUNT_BYTES(snap.n_bytes);
+
+  return {ttb::XYMatrix{std::move(snap.tensors[0]), std::move(snap.tensors[1])},
+          ttb::XYMatrix{std::move(snap.tensors[2]), std::move(snap.tensors[3])},
+          std::move(snap.normz_stats)};
+}
@@ -0,0 +1,176 @@
+#include "TensorPool.h"
+
+#include <ATen/ops/from_blob.h>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <sys/mman.h>
+#include <torch/types.h>
+#include <unordered_map>
+#include <vector>
+
+namespace tensor_pool {
+
+struct State {
+    std::mutex mutex;
+    bool enabled{false};
+    int64_t max_idle_bytes{0};
+    std::unordered_map<int64_t, std::vector<void *>> idle;
+    ttb::TensorPoolStats stats;
+
+    State() = default;
+    State(const State &) = delete;
+    State(State &&) = delete;
+    State &operator=(const State &) = delete;
+    State &operator=(State &&) = delete;
+
+    ~State() {
+      for (auto &[size_class, buffers] : idle)
+        for (auto *buffer : buffers)
+          std::free(buffer);
+    }
+};
+
+/// Deleters of live tensors share ownership, so the state outlives them
+std::shared_ptr<State> &state() {
+  static auto resp = std::make_shared<State>();
+  return resp;
+}
+
+int64_t size_class(int64_t n_bytes) {
+  auto page = ttb::TensorPool::HUGE_PAGE_SIZE;
+  return (n_bytes + page - 1) / page * page;
+}
+
+void *allocate(int64_t n_bytes) {
+  auto *resp = std::aligned_alloc(ttb::TensorPool::HUGE_PAGE_SIZE, n_bytes);
+  if (resp == nullptr)
+    throw std::bad_alloc();
+
+#ifdef MADV_HUGEPAGE
+  // Only a hint: kernels without transparent huge pages keep regular pages
+  madvise(resp, n_bytes, MADV_HUGEPAGE);
+#endif
+
+  return resp;
+}
+
+void release(const std::shared_ptr<State> &state, void *buffer, int64_t n_bytes) {
+  {
+    std::scoped_lock lock{state->mutex};
+    state->stats.live_bytes -= n_bytes;
+    if (state->enabled && state->stats.idle_bytes + n_bytes <= state->max_idle_bytes) {
+      state->idle[n_bytes].emplace_back(buffer);
+      state->stats.idle_bytes += n_bytes;
+      return;
+    }
+  }
+
+  std::free(buffer);
+}
+
+void free_idle(State &state) {
+  std::unordered_map<int64_t, std::vector<void *>> idle;
+  {
+    std::scoped_lock lock{state.mutex};
+    idle.swap(state.idle);
+    state.stats.idle_bytes = 0;
+  }
+
+  for (auto &[size_class, buffers] : idle)
+    for (auto *buffer : buffers)
+      std::free(buffer);
+}
+
+} // namespace tensor_pool
+
+torch::Tensor ttb::TensorPool::empty(c10::IntArrayRef sizes, c10::ScalarType dtype) {
+  auto options = torch::TensorOptions().dtype(dtype);
+  auto n_bytes = c10::multiply_integers(sizes) * static_cast<int64_t>(c10::elementSize(dtype));
+
+  auto state = tensor_pool::state();
+  void *buffer{nullptr};
+  auto n_class_bytes = tensor_pool::size_class(n_bytes);
+  {
+    std::scoped_lock lock{state->mutex};
+    if (!state->enabled || n_bytes < MIN_POOLED_BYTES)
+      return torch::empty(sizes, options);
+
+    auto &buffers = state->idle[n_class_bytes];
+    if (!buffers.empty()) {
+      buffer = buffers.back();
+      buffers.pop_back();
+      state->stats.idle_bytes -= n_class_bytes;
+      ++state->stats.hits;
+    } else
+      ++state->stats.misses;
+    state->stats.live_bytes += n_class_bytes;
+  }
+
+  if (buffer == nullptr) {
+    try {
+      buffer = tensor_pool::allocate(n_class_bytes);
+    } catch (const std::bad_alloc &) {
+      std::scoped_lock lock{state->mutex};
+      state->stats.live_bytes -= n_class_bytes;
+      throw TensorPoolError("Failed to allocate " + std::to_string(n_class_bytes) + " bytes");
+    }
+  }
+
+  auto deleter = [state, n_class_bytes](void *ptr) {
+    tensor_pool::release(state, ptr, n_class_bytes);
+  };
+
+  return torch::from_blob(buffer, sizes, deleter, options);
+}
+
+torch::Tensor ttb::TensorPool::copy(const torch::Tensor &tensor) {
+  auto resp = ttb::TensorPool::empty(tensor.sizes(), tensor.scalar_type());
+  resp.copy_(tensor);
+
+  return resp;
+}
+
+torch::Tensor ttb::TensorPool::index_select(const torch::Tensor &tensor,
+                                            const torch::Tensor &indices) {
+  auto sizes = tensor.sizes().vec();
+  sizes[0] = indices.numel();
+
+  auto resp = ttb::TensorPool::empty(sizes, tensor.scalar_type());
+  torch::index_select_out(resp, tensor, 0, indices);
+
+  return resp;
+}
+
+void ttb::TensorPool::enable(int64_t max_idle_bytes) {
+  auto &state = tensor_pool::state();
+  std::scoped_lock lock{state->mutex};
+  state->enabled = true;
+  state->max_idle_bytes = max_idle_bytes;
+}
+
+void ttb::TensorPool::disable() {
+  auto &state = tensor_pool::state();
+  {
+    std::scoped_lock lock{state->mutex};
+    state->enabled = false;
+  }
+
+  tensor_pool::free_idle(*state);
+}
+
+bool ttb::TensorPool::enabled() {
+  auto &state = tensor_pool::state();
+  std::scoped_lock lock{state->mutex};
+  return state->enabled;
+}
+
+void ttb::TensorPool::trim() { tensor_pool::free_idle(*tensor_pool::state()); }
+
+ttb::TensorPoolStats ttb::TensorPool::stats() {
+  auto &state = tensor_pool::state();
+  std::scoped_lock lock{state->mutex};
+  return state->stats;
+}
@@ -1,6 +1,9 @@
 #include "TrainingBundle.h"
+#include "Instrumentation.h"
 
 std::pair<double, double> ttb::TrainingBundle::min_max_normz(int X_col) {
+  TTB_TIMED_SCOPE("TrainingBundle::min_max_normz");
+  TTB_COUNT_ROWS(_XY_train.n_rows() + _XY_eval.n_rows());
   this->check_X_index_floating_point(X_col);
 
   auto &X_train = _XY_train.X();
@@ -44,10 +47,14 @@ std::pair<double, double> ttb::TrainingBundle::min_max_normz(int X_col) {
       a_X_eval[i][X_col] = (a_X_eval[i][X_col] - min_val) * multiplier;
   });
 
+  _normz_stats.emplace_back(X_col, ttb::Normalization::MIN_MAX, min_val, max_val);
+
   return {min_val, max_val};
 }
 
 std::pair<double, double> ttb::TrainingBundle::z_score_normz(int X_col) {
+  TTB_TIMED_SCOPE("TrainingBundle::z_score_normz");
+  TTB_COUNT_ROWS(_XY_train.n_rows() + _XY_eval.n_rows());
   this->check_X_index_floating_point(X_col);
 
   auto &X_train = _XY_train.X();
@@ -91,9 +98,52 @@ std::pair<double, double> ttb::TrainingBundle::z_score_normz(int X_col) {
       a_X_eval[i][X_col] = (a_X_eval[i][X_col] - mu) * multiplier;
   });
 
+  _normz_stats.emplace_back(X_col, ttb::Normalization::Z_SCORE, mu, sigma);
+
   return {mu, sigma};
 }
 
+std::vector<double> ttb::TrainingBundle::quantile_bin(int X_col, int n_bins) {
+  TTB_TIMED_SCOPE("TrainingBundle::quantile_bin");
+  TTB_COUNT_ROWS(_XY_train.n_rows() + _XY_eval.n_rows());
+  this->check_X_index_floating_point(X_col);
+
+  ttb::Binner binner{ttb::Binning::QUANTILE, n_bins};
+  auto &X_train = _XY_train.X();
+  auto &X_eval = _XY_eval.X();
+
+  // Columns are read and written in place through their strides
+  AT_DISPATCH_FLOATING_TYPES(X_train.scalar_type(), "quantile_bin", [&] -> void {
+    using cpp_type = scalar_t; // C++ type provided by the macro
+    auto *train = X_train.data_ptr<cpp_type>() + X_col * X_train.stride(1);
+    auto *eval = X_eval.data_ptr<cpp_type>() + X_col * X_eval.stride(1);
+
+    binner.update(train, X_train.size(0), X_train.stride(0));
+    binner.transform(train, train, X_train.size(0), X_train.stride(0));
+    binner.transform(eval, eval, X_eval.size(0), X_eval.stride(0));
+  });
+
+  return binner.edges();
+}
+
+std::vector<int64_t> ttb::TrainingBundle::histogram(int X_col, const ttb::Binner &binner) const {
+  const auto &X_train = _XY_train.X();
+  if (X_col < 0 || X_col >= X_train.size(1))
+    throw TrainingBundleError("Index out of bounds");
+
+  std::vector<int64_t> resp;
+  AT_DISPATCH_ALL_TYPES(X_train.scalar_type(), "histogram", [&] -> void {
+    using cpp_type = scalar_t; // C++ type provided by the macro
+    if constexpr (utl::NumericType<cpp_type>) {
+      const auto *train = X_train.data_ptr<cpp_type>() + X_col * X_train.stride(1);
+      resp = binner.histogram(train, X_train.size(0), X_train.stride(0));
+    } else
+      throw TrainingBundleError("Unsupported X type");
+  });
+
+  return resp;
+}
+
 void ttb::TrainingBundle::check_X_index_floating_point(int X_col) {
   auto &X_train = _XY_train.X();
 
@@ -1,6 +1,8 @@
 #include "XYMatrix.h"
 #include "AnalyticTableNumeric.h"
 #include "Converter.h"
+#include "Instrumentation.h"
+#include "TensorPool.h"
 #include "TrainingBundle.h"
 
 #include <algorithm>
@@ -66,20 +68,23 @@ ttb::XYMatrix::XYMatrix(torch::Tensor &&X, torch::Tensor &&Y) {
 }
 
 void ttb::XYMatrix::shuffle(std::optional<unsigned> seed) {
-  auto XY = torch::cat({*_X, *_Y}, 1);
-  auto n_rows = XY.size(0);
+  TTB_TIMED_SCOPE("XYMatrix::shuffle");
+  TTB_COUNT_ROWS(this->n_rows());
+  auto n_rows = _X->size(0);
+  auto index_options = torch::TensorOptions().dtype(torch::kLong);
   torch::Tensor shuffled_indices;
   if (!seed.has_value())
-    shuffled_indices = torch::randperm(n_rows, XY.options().dtype(torch::kLong));
+    shuffled_indices = torch::randperm(n_rows, index_options);
   else {
     auto gen = torch::make_generator<torch::CPUGeneratorImpl>(seed.value());
-    shuffled_indices = torch::randperm(n_rows, gen, XY.options().dtype(torch::kLong));
+    shuffled_indices = torch::randperm(n_rows, gen, index_options);
   }
 
-  XY = XY.index_select(0, shuffled_indices);
-  auto last_col_X = static_cast<int>(_X->size(1) - 1);
-
-  this->update_X_Y(std::move(XY), last_col_X);
+  // X and Y are gathered separately into pooled storage; the previous ones return to the pool
+  auto X = ttb::TensorPool::index_select(*_X, shuffled_indices);
+  auto Y = ttb::TensorPool::index_select(*_Y, shuffled_indices);
+  _X = utl::new_unp<torch::Tensor>(std::move(X));
+  _Y = utl::new_unp<torch::Tensor>(std::move(Y));
 }
 
 namespace stratified_split_from_one_hot {
@@ -114,16 +119,13 @@ auto stratify_row_indices_by_label(const torch::Tensor &Y, int pct_eval,
 
 auto stack_stratified_rows(const std::unordered_map<int64_t, std::vector<int64_t>> &label_rows,
                            const torch::Tensor &X, const torch::Tensor &Y) {
-  std::vector<torch::Tensor> X_row_list;
-  std::vector<torch::Tensor> Y_row_list;
+  std::vector<int64_t> rows_in_order;
   for (auto &[label, rows] : label_rows)
-    for (size_t i{0}; i < rows.size(); ++i) {
-      Y_row_list.emplace_back(Y[rows[i]].clone());
-      X_row_list.emplace_back(X[rows[i]].clone());
-    }
+    rows_in_order.insert(rows_in_order.end(), rows.begin(), rows.end());
 
-  auto stacked_X = torch::vstack(X_row_list);
-  auto stacked_Y = torch::vstack(Y_row_list);
+  auto indices = torch::tensor(rows_in_order, torch::TensorOptions().dtype(torch::kLong));
+  auto stacked_X = ttb::TensorPool::index_select(X, indices);
+  auto stacked_Y = ttb::TensorPool::index_select(Y, indices);
 
   return std::make_pair(stacked_X, stacked_Y);
 }
@@ -132,7 +134,9 @@ auto stack_stratified_rows(const std::unordered_map<int64_t, std::vector<int64_t
 
 ttb::TrainingBundle ttb::XYMatrix::stratified_split_from_one_hot(XYMatrix &&XY_matrix, int pct_eval,
                                                                  std::optional<unsigned> seed) {
+  TTB_TIMED_SCOPE("XYMatrix::stratified_split_from_one_hot");
   auto my_XY_matrix = std::move(XY_matrix);
+  TTB_COUNT_ROWS(my_XY_matrix.n_rows());
 
   if (pct_eval <= 0 || pct_eval >= 100)
     throw ttb::XYMatrixError("Percentage out of bounds");
@@ -166,24 +170,31 @@ ttb::XYMatrix::shuffle_stratified_split_from_one_hot(XYMatrix &&XY_matrix, int p
 }
 
 ttb::TrainingBundle ttb::XYMatrix::split(XYMatrix &&XY_matrix, int pct_eval) {
+  TTB_TIMED_SCOPE("XYMatrix::split");
   auto my_XY_matrix = std::move(XY_matrix);
+  TTB_COUNT_ROWS(my_XY_matrix.n_rows());
 
   if (pct_eval <= 0 || pct_eval >= 100)
     throw ttb::XYMatrixError("Percentage out of bounds");
 
-  auto X = my_XY_matrix.X().clone();
-  auto Y = my_XY_matrix.Y().clone();
+  const auto &X = my_XY_matrix.X();
+  const auto &Y = my_XY_matrix.Y();
 
-  auto train_size = static_cast<int64_t>(X.size(0) * (100 - pct_eval)) / 100;
-  auto X_train = X.narrow_copy(0, 0, train_size);
-  auto Y_train = Y.narrow_copy(0, 0, train_size);
-  auto X_eval = X.narrow_copy(0, train_size, X.size(0) - train_size);
-  auto Y_eval = Y.narrow_copy(0, train_size, X.size(0) - train_size);
+  // Train and eval are views of the moved-in storage, see compact()
+  auto train_size = ttb::XYMatrix::train_rows(X.size(0), pct_eval);
+  auto X_train = X.narrow(0, 0, train_size);
+  auto Y_train = Y.narrow(0, 0, train_size);
+  auto X_eval = X.narrow(0, train_size, X.size(0) - train_size);
+  auto Y_eval = Y.narrow(0, train_size, X.size(0) - train_size);
 
   return {ttb::XYMatrix{std::move(X_train), std::move(Y_train)},
           ttb::XYMatrix{std::move(X_eval), std::move(Y_eval)}};
 }
 
+int64_t ttb::XYMatrix::train_rows(int64_t n_rows, int pct_eval) {
+  return static_cast<int64_t>(n_rows * (100 - pct_eval)) / 100;
+}
+
 ttb::TrainingBundle ttb::XYMatrix::shuffle_split(XYMatrix &&XY_matrix, int pct_eval,
                                                  std::optional<unsigned> seed) {
   auto my_XY_matrix = std::move(XY_matrix);
@@ -196,10 +207,29 @@ ttb::TrainingBundle ttb::XYMatrix::shuffle_split(XYMatrix &&XY_matrix, int pct_e
   return ttb::XYMatrix::split(std::move(my_XY_matrix), pct_eval);
 }
 
+bool ttb::XYMatrix::is_view() const {
+  auto owns = [](const torch::Tensor &tensor) {
+    return tensor.storage_offset() == 0 && tensor.is_contiguous() &&
+           tensor.storage().nbytes() == tensor.nbytes();
+  };
+
+  return !owns(*_X) || !owns(*_Y);
+}
+
+void ttb::XYMatrix::compact() {
+  if (!this->is_view())
+    return;
+
+  auto X = ttb::TensorPool::copy(*_X);
+  auto Y = ttb::TensorPool::copy(*_Y);
+  _X = utl::new_unp<torch::Tensor>(std::move(X));
+  _Y = utl::new_unp<torch::Tensor>(std::move(Y));
+}
+
 void ttb::XYMatrix::update_X_Y(torch::Tensor &&XY, int last_col_X) {
   auto my_XY = std::move(XY);
-  auto X = my_XY.narrow_copy(1, 0, last_col_X + 1);
-  auto Y = my_XY.narrow_copy(1, last_col_X + 1, my_XY.size(1) - last_col_X - 1);
+  auto X = ttb::TensorPool::copy(my_XY.narrow(1, 0, last_col_X + 1));
+  auto Y = ttb::TensorPool::copy(my_XY.narrow(1, last_col_X + 1, my_XY.size(1) - last_col_X - 1));
 
   _X = utl::new_unp<torch::Tensor>(std::move(X));
   _Y = utl::new_unp<torch::Tensor>(std::move(Y));
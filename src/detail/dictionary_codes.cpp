@@ -0,0 +1,57 @@
+#include "detail/dictionary_codes.h"
+
+#include <ATen/Parallel.h>
+#include <arrow/array/array_dict.h>
+#include <arrow/array/util.h>
+#include <arrow/type.h>
+
+namespace dictionary_codes {
+
+/// Minimum number of rows decoded by each parallel task
+constexpr int64_t GRAIN_ROWS{1 << 15};
+
+} // namespace dictionary_codes
+
+arrow::Result<utl::DictionaryCodes> utl::dictionary_codes(const arrow::ChunkedArray &column,
+                                                          arrow::MemoryPool *pool) {
+  if (column.type()->id() != arrow::Type::DICTIONARY)
+    return arrow::Status::TypeError("Not a dictionary column: ", column.type()->ToString());
+
+  const auto &type = static_cast<const arrow::DictionaryType &>(*column.type());
+  utl::DictionaryCodes resp;
+  resp.codes.resize(column.length());
+  if (column.num_chunks() == 0) {
+    ARROW_ASSIGN_OR_RAISE(resp.dictionary, arrow::MakeEmptyArray(type.value_type(), pool));
+    return resp;
+  }
+
+  // Chunks may come from tables with different dictionaries
+  auto chunks = std::make_shared<arrow::ChunkedArray>(column.chunks(), column.type());
+  if (column.num_chunks() > 1) {
+    ARROW_ASSIGN_OR_RAISE(chunks, arrow::DictionaryUnifier::UnifyChunkedArray(chunks, pool));
+  }
+
+  resp.dictionary = static_cast<const arrow::DictionaryArray &>(*chunks->chunk(0)).dictionary();
+  const auto &dictionary = *resp.dictionary;
+  auto dictionary_has_nulls = dictionary.null_count() != 0;
+  int64_t row_offset{0};
+  for (const auto &chunk : chunks->chunks()) {
+    const auto &encoded = static_cast<const arrow::DictionaryArray &>(*chunk);
+    auto *codes = resp.codes.data() + row_offset;
+    auto may_have_nulls = encoded.null_count() != 0;
+    at::parallel_for(0, encoded.length(), dictionary_codes::GRAIN_ROWS,
+                     [&](int64_t begin, int64_t end) {
+                       for (auto i{begin}; i < end; ++i) {
+                         auto code = may_have_nulls && encoded.IsNull(i)
+                                         ? int64_t{-1}
+                                         : encoded.GetValueIndex(i);
+                         if (code >= 0 && dictionary_has_nulls && dictionary.IsNull(code))
+                           code = -1;
+                         codes[i] = static_cast<int32_t>(code);
+                       }
+                     });
+    row_offset += encoded.length();
+  }
+
+  return resp;
+}
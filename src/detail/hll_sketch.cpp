@@ -0,0 +1,50 @@
+#include "detail/hll_sketch.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+
+namespace hll_sketch {
+
+constexpr int MIN_PRECISION{4};
+constexpr int MAX_PRECISION{18};
+
+} // namespace hll_sketch
+
+utl::HllSketch::HllSketch(int precision)
+    : _precision{std::clamp(precision, hll_sketch::MIN_PRECISION, hll_sketch::MAX_PRECISION)},
+      _registers(size_t{1} << _precision, 0) {}
+
+void utl::HllSketch::update(uint64_t hash) {
+  auto index = hash >> (64 - _precision);
+  // Rank of the first set bit among the remaining bits, a sentinel bounding it when all are zero
+  auto rest = (hash << _precision) | (uint64_t{1} << (_precision - 1));
+  auto rank = static_cast<uint8_t>(std::countl_zero(rest) + 1);
+  _registers[index] = std::max(_registers[index], rank);
+}
+
+void utl::HllSketch::merge(const HllSketch &other) {
+  if (other._precision != _precision)
+    throw std::invalid_argument("HyperLogLog sketches of different precisions");
+
+  for (size_t i{0}; i < _registers.size(); ++i)
+    _registers[i] = std::max(_registers[i], other._registers[i]);
+}
+
+double utl::HllSketch::estimate() const {
+  auto m = static_cast<double>(_registers.size());
+  double inverse_sum{0.0};
+  int64_t n_zeros{0};
+  for (auto reg : _registers) {
+    inverse_sum += std::ldexp(1.0, -reg);
+    n_zeros += reg == 0 ? 1 : 0;
+  }
+
+  auto alpha = 0.7213 / (1.0 + 1.079 / m);
+  auto raw = alpha * m * m / inverse_sum;
+  if (raw <= 2.5 * m && n_zeros != 0)
+    return m * std::log(m / static_cast<double>(n_zeros));
+
+  return raw;
+}
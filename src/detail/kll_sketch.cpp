@@ -0,0 +1,122 @@
+#include "detail/kll_sketch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <utility>
+
+namespace kll_sketch {
+
+/// Ratio between the capacities of consecutive levels
+constexpr double CAPACITY_DECAY{2.0 / 3.0};
+
+/// Smallest capacity of any level
+constexpr int64_t MIN_CAPACITY{2};
+
+/// xorshift64, deterministic so that fitting the same data twice gives the same sketch
+bool coin(uint64_t &state) {
+  state ^= state << 13U;
+  state ^= state >> 7U;
+  state ^= state << 17U;
+  return (state & 1U) != 0;
+}
+
+} // namespace kll_sketch
+
+utl::KllSketch::KllSketch(int k) : _k{std::max(k, 8)} { this->add_level(); }
+
+int64_t utl::KllSketch::level_capacity(size_t level) const {
+  auto depth = static_cast<double>(_levels.size() - 1 - level);
+  auto capacity = std::ceil(_k * std::pow(kll_sketch::CAPACITY_DECAY, depth));
+
+  return std::max(kll_sketch::MIN_CAPACITY, static_cast<int64_t>(capacity));
+}
+
+void utl::KllSketch::add_level() {
+  _levels.emplace_back();
+  _capacity = 0;
+  for (size_t h{0}; h < _levels.size(); ++h)
+    _capacity += this->level_capacity(h);
+}
+
+void utl::KllSketch::update(double value) {
+  if (std::isnan(value))
+    return;
+
+  ++_count;
+  _min = std::min(_min, value);
+  _max = std::max(_max, value);
+  _levels[0].emplace_back(value);
+  if (++_size > _capacity)
+    this->compress();
+}
+
+void utl::KllSketch::compress() {
+  while (_size > _capacity) {
+    size_t h{0};
+    while (std::cmp_less(_levels[h].size(), this->level_capacity(h)))
+      ++h;
+    if (h + 1 == _levels.size())
+      this->add_level();
+
+    // Every other sorted value moves up with twice the weight; an odd one out stays
+    auto &level = _levels[h];
+    std::ranges::sort(level);
+    auto kept = level.size() % 2 == 1 ? std::optional<double>{level.back()} : std::nullopt;
+    auto n_paired = level.size() - (kept.has_value() ? 1 : 0);
+    auto &next = _levels[h + 1];
+    for (auto i = static_cast<size_t>(kll_sketch::coin(_random_state)); i < n_paired; i += 2)
+      next.emplace_back(level[i]);
+
+    _size -= static_cast<int64_t>(n_paired / 2);
+    level.clear();
+    if (kept.has_value())
+      level.emplace_back(kept.value());
+  }
+}
+
+void utl::KllSketch::merge(const KllSketch &other) {
+  while (_levels.size() < other._levels.size())
+    this->add_level();
+
+  for (size_t h{0}; h < other._levels.size(); ++h)
+    _levels[h].insert(_levels[h].end(), other._levels[h].begin(), other._levels[h].end());
+
+  _count += other._count;
+  _size += other._size;
+  _min = std::min(_min, other._min);
+  _max = std::max(_max, other._max);
+  this->compress();
+}
+
+std::vector<double> utl::KllSketch::quantiles(const std::vector<double> &fractions) const {
+  std::vector<std::pair<double, int64_t>> weighted;
+  weighted.reserve(_size);
+  for (size_t h{0}; h < _levels.size(); ++h)
+    for (auto value : _levels[h])
+      weighted.emplace_back(value, int64_t{1} << h);
+  std::ranges::sort(weighted);
+
+  // Cumulative weights give the approximate rank of every kept value
+  std::vector<double> ranks(weighted.size());
+  int64_t weight{0};
+  for (size_t i{0}; i < weighted.size(); ++i) {
+    weight += weighted[i].second;
+    ranks[i] = static_cast<double>(weight);
+  }
+
+  std::vector<double> resp;
+  resp.reserve(fractions.size());
+  for (auto fraction : fractions) {
+    if (_count == 0)
+      resp.emplace_back(std::numeric_limits<double>::quiet_NaN());
+    else if (fraction <= 0.0 || fraction >= 1.0)
+      resp.emplace_back(fraction <= 0.0 ? _min : _max);
+    else {
+      auto it = std::ranges::upper_bound(ranks, fraction * static_cast<double>(_count));
+      resp.emplace_back(it == ranks.end() ? _max : weighted[it - ranks.begin()].first);
+    }
+  }
+
+  return resp;
+}
@@ -0,0 +1,226 @@
+#include "detail/row_keys.h"
+#include "detail/hashing.h"
+#include "detail/string_kernels.h"
+
+#include <ATen/Parallel.h>
+#include <arrow/array/array_dict.h>
+#include <arrow/array/concatenate.h>
+#include <arrow/array/util.h>
+#include <arrow/util/bit_util.h>
+#include <array>
+#include <string_view>
+#include <vector>
+
+namespace row_keys {
+
+/// Minimum number of rows hashed by each parallel task
+constexpr int64_t GRAIN_ROWS{1 << 14};
+
+/// Boolean keys are viewed as one of these bytes
+constexpr std::string_view BIT_BYTES{"\0\1", 2};
+
+/// Stands for the hash of a null key, so rows with nulls in the same columns still collide
+constexpr uint64_t NULL_HASH{0x9e3779b97f4a7c15ULL};
+
+arrow::Result<utl::shp<arrow::Array>> combined(const arrow::ChunkedArray &column,
+                                               arrow::MemoryPool *pool) {
+  if (column.num_chunks() == 1)
+    return column.chunk(0);
+  if (column.num_chunks() == 0)
+    return arrow::MakeEmptyArray(column.type(), pool);
+  if (column.type()->id() != arrow::Type::DICTIONARY)
+    return arrow::Concatenate(column.chunks(), pool);
+
+  // Chunks may have different dictionaries, whose indices cannot be concatenated as they are
+  auto chunks = std::make_shared<arrow::ChunkedArray>(column.chunks(), column.type());
+  ARROW_ASSIGN_OR_RAISE(auto unified, arrow::DictionaryUnifier::UnifyChunkedArray(chunks, pool));
+  return arrow::Concatenate(unified->chunks(), pool);
+}
+
+} // namespace row_keys
+
+arrow::Result<utl::RowKeys> utl::RowKeys::Make(const arrow::Table &table,
+                                               const std::vector<int> &indices,
+                                               arrow::MemoryPool *pool) {
+  std::vector<utl::shp<arrow::Array>> columns;
+  columns.reserve(indices.size());
+  for (auto index : indices) {
+    if (index < 0 || index >= table.num_columns())
+      return arrow::Status::IndexError("Key column index out of bounds");
+
+    const auto &column = table.column(index);
+    if (!utl::RowKeys::supports(*column->type()))
+      return arrow::Status::TypeError("Unsupported key column type: ", column->type()->ToString());
+
+    ARROW_ASSIGN_OR_RAISE(auto array, row_keys::combined(*column, pool));
+    columns.emplace_back(std::move(array));
+  }
+
+  return utl::RowKeys{std::move(columns), table.num_rows()};
+}
+
+bool utl::RowKeys::supports(const arrow::DataType &type) {
+  switch (type.id()) {
+  case arrow::Type::BINARY:
+  case arrow::Type::STRING:
+  case arrow::Type::LARGE_BINARY:
+  case arrow::Type::LARGE_STRING:
+    return true;
+  case arrow::Type::DICTIONARY: {
+    const auto &value_type = *static_cast<const arrow::DictionaryType &>(type).value_type();
+    return value_type.id() != arrow::Type::DICTIONARY && utl::RowKeys::supports(value_type);
+  }
+  default:
+    return dynamic_cast<const arrow::FixedWidthType *>(&type) != nullptr;
+  }
+}
+
+utl::RowKeys::RowKeys(std::vector<utl::shp<arrow::Array>> &&columns, int64_t n_rows)
+    : _columns{std::move(columns)}, _n_rows{n_rows} {
+  for (const auto &column : _columns) {
+    if (column->type_id() != arrow::Type::DICTIONARY) {
+      _key_columns.emplace_back(utl::RowKeys::key_column(*column, *column));
+      continue;
+    }
+
+    // Every distinct value is hashed once, rows gather the hash of their index
+    const auto &dictionary = *static_cast<const arrow::DictionaryArray &>(*column).dictionary();
+    auto key_column = utl::RowKeys::key_column(*column, dictionary);
+    key_column.dictionary_hashes.resize(dictionary.length());
+    utl::RowKeys::hash_values(utl::RowKeys::key_column(dictionary, dictionary), 0,
+                              dictionary.length(), key_column.dictionary_hashes.data());
+    _key_columns.emplace_back(std::move(key_column));
+  }
+
+  this->hash_rows();
+}
+
+utl::RowKeys::KeyColumn utl::RowKeys::key_column(const arrow::Array &array,
+                                                 const arrow::Array &values) {
+  const auto &type = *values.type();
+  switch (type.id()) {
+  case arrow::Type::BINARY:
+  case arrow::Type::STRING:
+    return {Kind::BINARY, 0, &array, &values, {}};
+  case arrow::Type::LARGE_BINARY:
+  case arrow::Type::LARGE_STRING:
+    return {Kind::LARGE_BINARY, 0, &array, &values, {}};
+  default: {
+    auto bit_width = dynamic_cast<const arrow::FixedWidthType &>(type).bit_width();
+    auto kind = bit_width == 1 ? Kind::BIT : Kind::FIXED_WIDTH;
+    return {kind, bit_width / 8, &array, &values, {}};
+  }
+  }
+}
+
+std::string_view utl::RowKeys::bytes(const KeyColumn &column, int64_t row) {
+  if (column.values != column.array)
+    row = static_cast<const arrow::DictionaryArray *>(column.array)->GetValueIndex(row);
+
+  const auto &data = *column.values->data();
+  switch (column.kind) {
+  case Kind::BINARY:
+    return static_cast<const arrow::BinaryArray *>(column.values)->GetView(row);
+  case Kind::LARGE_BINARY:
+    return static_cast<const arrow::LargeBinaryArray *>(column.values)->GetView(row);
+  case Kind::BIT: {
+    auto bit = arrow::bit_util::GetBit(data.buffers[1]->data(), data.offset + row);
+    return row_keys::BIT_BYTES.substr(bit ? 1 : 0, 1);
+  }
+  default:
+    const auto *values = reinterpret_cast<const char *>(data.buffers[1]->data());
+    return {values + (data.offset + row) * column.byte_width,
+            static_cast<size_t>(column.byte_width)};
+  }
+}
+
+void utl::RowKeys::hash_values(const KeyColumn &column, int64_t begin, int64_t end,
+                               uint64_t *hashes) {
+  auto n = end - begin;
+  if (column.values != column.array) {
+    const auto &dictionary = static_cast<const arrow::DictionaryArray &>(*column.array);
+    const auto &table = column.dictionary_hashes;
+    auto table_size = static_cast<int64_t>(table.size());
+    if (dictionary.indices()->type_id() == arrow::Type::INT32) {
+      const auto *codes =
+          static_cast<const arrow::Int32Array &>(*dictionary.indices()).raw_values();
+      utl::gather_hashes(table.data(), table_size, codes + begin, n, hashes);
+      return;
+    }
+
+    for (auto i{begin}; i < end; ++i) {
+      auto code = dictionary.GetValueIndex(i);
+      hashes[i - begin] = code >= 0 && code < table_size ? table[code] : 0;
+    }
+    return;
+  }
+
+  const auto &data = *column.values->data();
+  switch (column.kind) {
+  case Kind::BINARY: {
+    const auto &binary = static_cast<const arrow::BinaryArray &>(*column.values);
+    utl::hash_strings(binary.raw_value_offsets() + begin, binary.raw_data(), n, 0, hashes);
+    break;
+  }
+  case Kind::LARGE_BINARY: {
+    const auto &binary = static_cast<const arrow::LargeBinaryArray &>(*column.values);
+    utl::hash_strings(binary.raw_value_offsets() + begin, binary.raw_data(), n, 0, hashes);
+    break;
+  }
+  case Kind::BIT: {
+    std::array<uint64_t, 2> bit_hashes{};
+    utl::hash_fixed(reinterpret_cast<const uint8_t *>(row_keys::BIT_BYTES.data()), 1, 2, 0,
+                    bit_hashes.data());
+    for (auto i{begin}; i < end; ++i)
+      hashes[i - begin] =
+          bit_hashes[arrow::bit_util::GetBit(data.buffers[1]->data(), data.offset + i) ? 1 : 0];
+    break;
+  }
+  default:
+    const auto *values = data.buffers[1]->data() + (data.offset + begin) * column.byte_width;
+    utl::hash_fixed(values, column.byte_width, n, 0, hashes);
+  }
+}
+
+void utl::RowKeys::hash_rows() {
+  _hashes.assign(_n_rows, 0);
+  _null_rows.assign(_n_rows, 0);
+
+  at::parallel_for(0, _n_rows, row_keys::GRAIN_ROWS, [&](int64_t begin, int64_t end) {
+    std::vector<uint64_t> column_hashes(end - begin);
+    for (const auto &column : _key_columns) {
+      utl::RowKeys::hash_values(column, begin, end, column_hashes.data());
+      const auto *array = column.array;
+      auto may_have_nulls = array->null_count() != 0;
+      for (auto i{begin}; i < end; ++i) {
+        if (may_have_nulls && array->IsNull(i)) {
+          _null_rows[i] = 1;
+          _hashes[i] = utl::mix64(_hashes[i] ^ row_keys::NULL_HASH);
+        } else
+          _hashes[i] = utl::mix64(_hashes[i] ^ column_hashes[i - begin]);
+      }
+    }
+  });
+}
+
+bool utl::RowKeys::equal(int64_t row, const RowKeys &other, int64_t other_row) const {
+  for (size_t j{0}; j < _key_columns.size(); ++j) {
+    const auto &column = _key_columns[j];
+    const auto &other_column = other._key_columns[j];
+    auto is_null = column.array->IsNull(row);
+    if (is_null != other_column.array->IsNull(other_row))
+      return false;
+    if (is_null)
+      continue;
+
+    auto lhs = utl::RowKeys::bytes(column, row);
+    auto rhs = utl::RowKeys::bytes(other_column, other_row);
+    if (lhs.size() != rhs.size() ||
+        !utl::bytes_equal(reinterpret_cast<const uint8_t *>(lhs.data()),
+                          reinterpret_cast<const uint8_t *>(rhs.data()),
+                          static_cast<int64_t>(lhs.size())))
+      return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,346 @@
+#include "detail/string_kernels.h"
+#include "detail/hashing.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+#if (defined(__x86_64__) || defined(_M_X64)) && (defined(__GNUC__) || defined(__clang__))
+#define TTB_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace string_kernels {
+
+/// Reversed Castagnoli polynomial, the one of the SSE4.2 crc32 instruction
+constexpr uint32_t CRC32C_POLYNOMIAL{0x82f63b78U};
+
+/// The second lane sees every word multiplied by this odd constant, so it is not a linear
+/// function of the first one
+constexpr uint64_t LANE_MULTIPLIER{0x9e3779b97f4a7c15ULL};
+constexpr uint32_t LANE_SEED{0x5bd1e995U};
+constexpr uint64_t LENGTH_MULTIPLIER{0xc2b2ae3d27d4eb4fULL};
+
+using CrcTables = std::array<std::array<uint32_t, 256>, 8>;
+
+/// Table k gives the CRC of a byte followed by k zero bytes
+constexpr CrcTables make_crc_tables() {
+  CrcTables tables{};
+  for (uint32_t byte{0}; byte < 256; ++byte) {
+    auto crc = byte;
+    for (int bit{0}; bit < 8; ++bit)
+      crc = (crc >> 1U) ^ ((crc & 1U) != 0 ? CRC32C_POLYNOMIAL : 0U);
+    tables[0][byte] = crc;
+  }
+  for (size_t k{1}; k < tables.size(); ++k)
+    for (size_t byte{0}; byte < 256; ++byte)
+      tables[k][byte] = (tables[k - 1][byte] >> 8U) ^ tables[0][tables[k - 1][byte] & 0xffU];
+
+  return tables;
+}
+
+constexpr CrcTables CRC_TABLES{make_crc_tables()};
+
+/// Slicing-by-8 equivalent of _mm_crc32_u64
+inline uint32_t crc_scalar(uint32_t crc, uint64_t word) {
+  word ^= crc;
+  uint32_t resp{0};
+  for (size_t k{0}; k < 8; ++k)
+    resp ^= CRC_TABLES[7 - k][(word >> (8 * k)) & 0xffU];
+
+  return resp;
+}
+
+template <typename Word>
+inline uint64_t load(const uint8_t *data) {
+  Word word;
+  std::memcpy(&word, data, sizeof(Word));
+  return word;
+}
+
+/**
+ * @brief The last n_tail (1 to 7) bytes of a string of n_bytes, zero padded, without a memcpy of
+ * variable size: longer strings shift the overlapping last word, shorter ones combine two
+ * overlapping loads
+ *
+ */
+inline uint64_t load_tail(const uint8_t *data, int64_t n_tail, int64_t n_bytes) {
+  auto n_tail_bits = static_cast<uint64_t>(8 * n_tail);
+  if (n_bytes >= 8)
+    return load<uint64_t>(data + n_tail - 8) >> (64 - n_tail_bits);
+  if (n_tail >= 4)
+    return load<uint32_t>(data) | (load<uint32_t>(data + n_tail - 4) << (n_tail_bits - 32));
+
+  return static_cast<uint64_t>(data[0]) |
+         (static_cast<uint64_t>(data[n_tail / 2]) << (8 * (n_tail / 2))) |
+         (static_cast<uint64_t>(data[n_tail - 1]) << (n_tail_bits - 8));
+}
+
+inline uint64_t finish(uint32_t lane_a, uint32_t lane_b, int64_t n_bytes) {
+  auto lanes = (static_cast<uint64_t>(lane_a) << 32U) | lane_b;
+  return utl::mix64(lanes ^ (static_cast<uint64_t>(n_bytes) * LENGTH_MULTIPLIER));
+}
+
+uint64_t hash_scalar(const uint8_t *data, int64_t n_bytes, uint64_t seed) {
+  auto lane_a = static_cast<uint32_t>(seed);
+  auto lane_b = static_cast<uint32_t>(seed >> 32U) ^ LANE_SEED;
+  auto remaining = n_bytes;
+  for (; remaining >= 8; data += 8, remaining -= 8) {
+    auto word = load<uint64_t>(data);
+    lane_a = crc_scalar(lane_a, word);
+    lane_b = crc_scalar(lane_b, word * LANE_MULTIPLIER);
+  }
+  if (remaining > 0) {
+    auto word = load_tail(data, remaining, n_bytes);
+    lane_a = crc_scalar(lane_a, word);
+    lane_b = crc_scalar(lane_b, word * LANE_MULTIPLIER);
+  }
+
+  return finish(lane_a, lane_b, n_bytes);
+}
+
+template <typename Offset>
+void hash_strings_scalar(const Offset *offsets, const uint8_t *data, int64_t n, uint64_t seed,
+                         uint64_t *hashes) {
+  for (int64_t i{0}; i < n; ++i)
+    hashes[i] = hash_scalar(data + offsets[i], offsets[i + 1] - offsets[i], seed);
+}
+
+void hash_fixed_scalar(const uint8_t *values, int32_t byte_width, int64_t n, uint64_t seed,
+                       uint64_t *hashes) {
+  for (int64_t i{0}; i < n; ++i)
+    hashes[i] = hash_scalar(values + i * byte_width, byte_width, seed);
+}
+
+bool long_equal_scalar(const uint8_t *lhs, const uint8_t *rhs, int64_t n_bytes) {
+  return std::memcmp(lhs, rhs, static_cast<size_t>(n_bytes)) == 0;
+}
+
+void gather_scalar(const uint64_t *table, int64_t table_size, const int32_t *codes, int64_t n,
+                   uint64_t *hashes) {
+  for (int64_t i{0}; i < n; ++i)
+    hashes[i] = static_cast<uint32_t>(codes[i]) < static_cast<uint64_t>(table_size)
+                    ? table[codes[i]]
+                    : 0;
+}
+
+#ifdef TTB_X86_KERNELS
+
+[[gnu::target("sse4.2")]] inline uint64_t hash_sse42(const uint8_t *data, int64_t n_bytes,
+                                                     uint64_t seed) {
+  auto lane_a = static_cast<uint64_t>(static_cast<uint32_t>(seed));
+  auto lane_b = static_cast<uint64_t>(static_cast<uint32_t>(seed >> 32U) ^ LANE_SEED);
+  auto remaining = n_bytes;
+  for (; remaining >= 8; data += 8, remaining -= 8) {
+    auto word = load<uint64_t>(data);
+    lane_a = _mm_crc32_u64(lane_a, word);
+    lane_b = _mm_crc32_u64(lane_b, word * LANE_MULTIPLIER);
+  }
+  if (remaining > 0) {
+    auto word = load_tail(data, remaining, n_bytes);
+    lane_a = _mm_crc32_u64(lane_a, word);
+    lane_b = _mm_crc32_u64(lane_b, word * LANE_MULTIPLIER);
+  }
+
+  return finish(static_cast<uint32_t>(lane_a), static_cast<uint32_t>(lane_b), n_bytes);
+}
+
+[[gnu::target("sse4.2")]] uint64_t hash_one_sse42(const uint8_t *data, int64_t n_bytes,
+                                                  uint64_t seed) {
+  return hash_sse42(data, n_bytes, seed);
+}
+
+template <typename Offset>
+[[gnu::target("sse4.2")]] void hash_strings_sse42(const Offset *offsets, const uint8_t *data,
+                                                  int64_t n, uint64_t seed, uint64_t *hashes) {
+  for (int64_t i{0}; i < n; ++i)
+    hashes[i] = hash_sse42(data + offsets[i], offsets[i + 1] - offsets[i], seed);
+}
+
+[[gnu::target("sse4.2")]] void hash_fixed_sse42(const uint8_t *values, int32_t byte_width,
+                                                int64_t n, uint64_t seed, uint64_t *hashes) {
+  for (int64_t i{0}; i < n; ++i)
+    hashes[i] = hash_sse42(values + i * byte_width, byte_width, seed);
+}
+
+[[gnu::target("sse4.2")]] inline bool equal_16(const uint8_t *lhs, const uint8_t *rhs) {
+  auto lhs_bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lhs));
+  auto rhs_bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rhs));
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(lhs_bytes, rhs_bytes)) == 0xffff;
+}
+
+/// Blocks of 16 bytes, the last one overlapping the previous
+[[gnu::target("sse4.2")]] bool long_equal_sse42(const uint8_t *lhs, const uint8_t *rhs,
+                                                int64_t n_bytes) {
+  for (int64_t i{0}; i + 16 < n_bytes; i += 16)
+    if (!equal_16(lhs + i, rhs + i))
+      return false;
+
+  return equal_16(lhs + n_bytes - 16, rhs + n_bytes - 16);
+}
+
+[[gnu::target("avx2")]] inline bool equal_32(const uint8_t *lhs, const uint8_t *rhs) {
+  auto lhs_bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(lhs));
+  auto rhs_bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rhs));
+  return _mm256_movemask_epi8(_mm256_cmpeq_epi8(lhs_bytes, rhs_bytes)) == -1;
+}
+
+[[gnu::target("avx2")]] bool long_equal_avx2(const uint8_t *lhs, const uint8_t *rhs,
+                                             int64_t n_bytes) {
+  if (n_bytes <= 32)
+    return equal_16(lhs, rhs) && equal_16(lhs + n_bytes - 16, rhs + n_bytes - 16);
+
+  for (int64_t i{0}; i + 32 < n_bytes; i += 32)
+    if (!equal_32(lhs + i, rhs + i))
+      return false;
+
+  return equal_32(lhs + n_bytes - 32, rhs + n_bytes - 32);
+}
+
+[[gnu::target("avx2")]] void gather_avx2(const uint64_t *table, int64_t table_size,
+                                         const int32_t *codes, int64_t n, uint64_t *hashes) {
+  auto limit = _mm256_set1_epi64x(table_size);
+  const auto *base = reinterpret_cast<const long long *>(table);
+  int64_t i{0};
+  for (; i + 4 <= n; i += 4) {
+    auto code_block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(codes + i));
+    auto indices = _mm256_cvtepu32_epi64(code_block);
+    auto in_table = _mm256_cmpgt_epi64(limit, indices);
+    auto values =
+        _mm256_mask_i64gather_epi64(_mm256_setzero_si256(), base, indices, in_table, 8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(hashes + i), values);
+  }
+
+  gather_scalar(table, table_size, codes + i, n - i, hashes + i);
+}
+
+/// Blocks of 64 bytes, the tail through masked loads that cannot fault past the strings
+[[gnu::target("avx512f,avx512bw")]] bool long_equal_avx512(const uint8_t *lhs, const uint8_t *rhs,
+                                                           int64_t n_bytes) {
+  int64_t i{0};
+  for (; i + 64 <= n_bytes; i += 64) {
+    auto lhs_bytes = _mm512_loadu_si512(lhs + i);
+    auto rhs_bytes = _mm512_loadu_si512(rhs + i);
+    if (_mm512_cmpneq_epi8_mask(lhs_bytes, rhs_bytes) != 0)
+      return false;
+  }
+  if (i == n_bytes)
+    return true;
+
+  auto tail = static_cast<__mmask64>((uint64_t{1} << static_cast<uint64_t>(n_bytes - i)) - 1);
+  auto lhs_bytes = _mm512_maskz_loadu_epi8(tail, lhs + i);
+  auto rhs_bytes = _mm512_maskz_loadu_epi8(tail, rhs + i);
+  return _mm512_cmpneq_epi8_mask(lhs_bytes, rhs_bytes) == 0;
+}
+
+[[gnu::target("avx512f")]] void gather_avx512(const uint64_t *table, int64_t table_size,
+                                              const int32_t *codes, int64_t n, uint64_t *hashes) {
+  auto limit = _mm512_set1_epi64(table_size);
+  int64_t i{0};
+  for (; i + 8 <= n; i += 8) {
+    auto code_block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(codes + i));
+    auto indices = _mm512_maskz_cvtepu32_epi64(static_cast<__mmask8>(0xff), code_block);
+    auto in_table = _mm512_cmplt_epi64_mask(indices, limit);
+    auto values = _mm512_mask_i64gather_epi64(_mm512_setzero_si512(), in_table, indices, table, 8);
+    _mm512_storeu_si512(hashes + i, values);
+  }
+
+  gather_scalar(table, table_size, codes + i, n - i, hashes + i);
+}
+
+#endif
+
+/// Implementation of every kernel at one SimdLevel
+struct Kernels {
+    uint64_t (*hash_string)(const uint8_t *, int64_t, uint64_t);
+    void (*hash_strings32)(const int32_t *, const uint8_t *, int64_t, uint64_t, uint64_t *);
+    void (*hash_strings64)(const int64_t *, const uint8_t *, int64_t, uint64_t, uint64_t *);
+    void (*hash_fixed)(const uint8_t *, int32_t, int64_t, uint64_t, uint64_t *);
+    bool (*long_bytes_equal)(const uint8_t *, const uint8_t *, int64_t);
+    void (*gather_hashes)(const uint64_t *, int64_t, const int32_t *, int64_t, uint64_t *);
+};
+
+constexpr Kernels SCALAR_KERNELS{hash_scalar,       hash_strings_scalar<int32_t>,
+                                 hash_strings_scalar<int64_t>, hash_fixed_scalar,
+                                 long_equal_scalar, gather_scalar};
+
+#ifdef TTB_X86_KERNELS
+constexpr std::array<Kernels, 4> KERNELS{
+    SCALAR_KERNELS,
+    Kernels{hash_one_sse42, hash_strings_sse42<int32_t>, hash_strings_sse42<int64_t>,
+            hash_fixed_sse42, long_equal_sse42, gather_scalar},
+    Kernels{hash_one_sse42, hash_strings_sse42<int32_t>, hash_strings_sse42<int64_t>,
+            hash_fixed_sse42, long_equal_avx2, gather_avx2},
+    Kernels{hash_one_sse42, hash_strings_sse42<int32_t>, hash_strings_sse42<int64_t>,
+            hash_fixed_sse42, long_equal_avx512, gather_avx512}};
+#else
+constexpr std::array<Kernels, 4> KERNELS{SCALAR_KERNELS, SCALAR_KERNELS, SCALAR_KERNELS,
+                                         SCALAR_KERNELS};
+#endif
+
+utl::SimdLevel detect() {
+#ifdef TTB_X86_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+    return utl::SimdLevel::AVX512;
+  if (__builtin_cpu_supports("avx2"))
+    return utl::SimdLevel::AVX2;
+  if (__builtin_cpu_supports("sse4.2"))
+    return utl::SimdLevel::SSE4_2;
+#endif
+  return utl::SimdLevel::SCALAR;
+}
+
+std::atomic<const Kernels *> &active() {
+  static std::atomic<const Kernels *> kernels{
+      &KERNELS[static_cast<size_t>(utl::detected_simd_level())]};
+  return kernels;
+}
+
+inline const Kernels &kernels() { return *active().load(std::memory_order_relaxed); }
+
+} // namespace string_kernels
+
+utl::SimdLevel utl::detected_simd_level() {
+  static const utl::SimdLevel level{string_kernels::detect()};
+  return level;
+}
+
+utl::SimdLevel utl::simd_level() {
+  return static_cast<utl::SimdLevel>(string_kernels::active().load() -
+                                     string_kernels::KERNELS.data());
+}
+
+void utl::set_simd_level(utl::SimdLevel level) {
+  auto capped = std::min(static_cast<int>(level), static_cast<int>(utl::detected_simd_level()));
+  string_kernels::active().store(&string_kernels::KERNELS[static_cast<size_t>(capped)]);
+}
+
+uint64_t utl::hash_string(const uint8_t *data, int64_t n_bytes, uint64_t seed) {
+  return string_kernels::kernels().hash_string(data, n_bytes, seed);
+}
+
+void utl::hash_strings(const int32_t *offsets, const uint8_t *data, int64_t n, uint64_t seed,
+                       uint64_t *hashes) {
+  string_kernels::kernels().hash_strings32(offsets, data, n, seed, hashes);
+}
+
+void utl::hash_strings(const int64_t *offsets, const uint8_t *data, int64_t n, uint64_t seed,
+                       uint64_t *hashes) {
+  string_kernels::kernels().hash_strings64(offsets, data, n, seed, hashes);
+}
+
+void utl::hash_fixed(const uint8_t *values, int32_t byte_width, int64_t n, uint64_t seed,
+                     uint64_t *hashes) {
+  string_kernels::kernels().hash_fixed(values, byte_width, n, seed, hashes);
+}
+
+void utl::gather_hashes(const uint64_t *table, int64_t table_size, const int32_t *codes,
+                        int64_t n, uint64_t *hashes) {
+  string_kernels::kernels().gather_hashes(table, table_size, codes, n, hashes);
+}
+
+bool utl::long_bytes_equal(const uint8_t *lhs, const uint8_t *rhs, int64_t n_bytes) {
+  return string_kernels::kernels().long_bytes_equal(lhs, rhs, n_bytes);
+}
@@ -0,0 +1,162 @@
+#include "detail/top_k_sketch.h"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <stdexcept>
+
+utl::CountMinSketch::CountMinSketch(int width, int depth)
+    : _mask{std::bit_ceil(static_cast<uint64_t>(std::max(width, 1))) - 1},
+      _depth{std::max(depth, 1)}, _counters((_mask + 1) * _depth, 0) {}
+
+size_t utl::CountMinSketch::cell(uint64_t hash, int row) const {
+  // Row indices derived from the two halves of the hash (Kirsch and Mitzenmacher)
+  auto low = hash & 0xffffffffULL;
+  auto high = (hash >> 32U) | 1U;
+  auto column = (low + static_cast<uint64_t>(row) * high) & _mask;
+
+  return static_cast<size_t>(row) * (_mask + 1) + column;
+}
+
+void utl::CountMinSketch::update(uint64_t hash, int64_t count) {
+  for (int row{0}; row < _depth; ++row)
+    _counters[this->cell(hash, row)] += count;
+}
+
+void utl::CountMinSketch::merge(const CountMinSketch &other) {
+  if (other._mask != _mask || other._depth != _depth)
+    throw std::invalid_argument("Count-Min sketches of different shapes");
+
+  for (size_t i{0}; i < _counters.size(); ++i)
+    _counters[i] += other._counters[i];
+}
+
+int64_t utl::CountMinSketch::estimate(uint64_t hash) const {
+  auto resp = std::numeric_limits<int64_t>::max();
+  for (int row{0}; row < _depth; ++row)
+    resp = std::min(resp, _counters[this->cell(hash, row)]);
+
+  return resp;
+}
+
+utl::SpaceSaving::SpaceSaving(int capacity) : _capacity{std::max(capacity, 1)} {
+  _heap.reserve(_capacity);
+  _positions.reserve(_capacity);
+}
+
+int64_t utl::SpaceSaving::min_count() const { return this->full() ? _heap.front().count : 0; }
+
+void utl::SpaceSaving::swap_nodes(size_t i, size_t j) {
+  std::swap(_heap[i], _heap[j]);
+  _positions[_heap[i].key] = i;
+  _positions[_heap[j].key] = j;
+}
+
+void utl::SpaceSaving::sift_up(size_t i) {
+  while (i > 0) {
+    auto parent = (i - 1) / 2;
+    if (_heap[parent].count <= _heap[i].count)
+      return;
+    this->swap_nodes(i, parent);
+    i = parent;
+  }
+}
+
+void utl::SpaceSaving::sift_down(size_t i) {
+  auto n = _heap.size();
+  while (true) {
+    auto smallest = i;
+    for (auto child : {2 * i + 1, 2 * i + 2})
+      if (child < n && _heap[child].count < _heap[smallest].count)
+        smallest = child;
+    if (smallest == i)
+      return;
+    this->swap_nodes(i, smallest);
+    i = smallest;
+  }
+}
+
+bool utl::SpaceSaving::update(uint64_t key, int64_t tag) {
+  if (auto it = _positions.find(key); it != _positions.end()) {
+    auto position = it->second;
+    ++_heap[position].count;
+    this->sift_down(position);
+    return false;
+  }
+
+  if (!this->full()) {
+    _heap.push_back({key, 1, 0, tag});
+    _positions[key] = _heap.size() - 1;
+    this->sift_up(_heap.size() - 1);
+    return true;
+  }
+
+  // The least frequent key is evicted, its count becoming the error of the new one
+  auto &root = _heap.front();
+  _positions.erase(root.key);
+  root = {key, root.count + 1, root.count, tag};
+  _positions[key] = 0;
+  this->sift_down(0);
+
+  return true;
+}
+
+void utl::SpaceSaving::merge(const SpaceSaving &other) {
+  // A key missing from a full summary may have occurred up to its min count times
+  auto min_this = this->min_count();
+  auto min_other = other.min_count();
+
+  std::vector<Counter> merged;
+  merged.reserve(_heap.size() + other._heap.size());
+  for (const auto &counter : _heap) {
+    auto it = other._positions.find(counter.key);
+    if (it == other._positions.end())
+      merged.push_back({counter.key, counter.count + min_other, counter.error + min_other,
+                        counter.tag});
+    else {
+      const auto &match = other._heap[it->second];
+      merged.push_back({counter.key, counter.count + match.count, counter.error + match.error,
+                        counter.tag});
+    }
+  }
+  for (const auto &counter : other._heap)
+    if (!_positions.contains(counter.key))
+      merged.push_back(
+          {counter.key, counter.count + min_this, counter.error + min_this, counter.tag});
+
+  if (std::cmp_greater(merged.size(), _capacity)) {
+    auto by_count = [](const Counter &a, const Counter &b) { return a.count > b.count; };
+    std::ranges::nth_element(merged, merged.begin() + _capacity, by_count);
+    merged.resize(_capacity);
+  }
+
+  _heap = std::move(merged);
+  this->rebuild();
+}
+
+void utl::SpaceSaving::rebuild() {
+  auto by_count = [](const Counter &a, const Counter &b) { return a.count > b.count; };
+  std::ranges::make_heap(_heap, by_count);
+  _positions.clear();
+  for (size_t i{0}; i < _heap.size(); ++i)
+    _positions[_heap[i].key] = i;
+}
+
+void utl::SpaceSaving::clear_tags() {
+  for (auto &counter : _heap)
+    counter.tag = -1;
+}
+
+std::vector<utl::SpaceSaving::Counter> utl::SpaceSaving::top(int k) const {
+  auto resp = _heap;
+  auto by_count = [](const Counter &a, const Counter &b) {
+    if (a.count != b.count)
+      return a.count > b.count;
+    return a.error != b.error ? a.error < b.error : a.key < b.key;
+  };
+  std::ranges::sort(resp, by_count);
+  if (std::cmp_greater(resp.size(), std::max(k, 0)))
+    resp.resize(std::max(k, 0));
+
+  return resp;
+}
@@ -4,6 +4,9 @@
 #include "detail/utils.h"
 
 #include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <arrow/compute/expression.h>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -152,6 +155,54 @@ TEST(AnalyticTable_Test, ReturnsNewSlicedTable) {
   EXPECT_EQ(table.n_rows(), 10);
 }
 
+TEST(AnalyticTable_Test, SlicesUpToTheLastRow) {
+  auto table = make_simple_table(10);
+  auto res = table.sliced(5, 5);
+  EXPECT_EQ(res.n_rows(), 5);
+  EXPECT_THROW(auto fail = table.sliced(5, 6), ttb::AnalyticTableError);
+}
+
+TEST(AnalyticTable_Test, SlicedViewSharesBuffers) {
+  auto table = make_simple_table(10);
+  auto res = table.sliced(2, 4);
+
+  auto original = table.arrow_table()->column(0)->chunk(0);
+  auto view = res.arrow_table()->column(0)->chunk(0);
+  EXPECT_EQ(view->data()->buffers[1], original->data()->buffers[1]);
+  EXPECT_EQ(view->offset(), 2);
+}
+
+TEST(AnalyticTable_Test, DeepSlicedCombinesChunks) {
+  auto r_concat = arrow::ConcatenateTables(
+      {make_simple_table(10).arrow_table(), make_simple_table(10).arrow_table()});
+  ASSERT_TRUE(r_concat.ok());
+  ttb::AnalyticTable table{r_concat.MoveValueUnsafe()};
+
+  auto view = table.sliced(5, 10);
+  EXPECT_EQ(view.arrow_table()->column(0)->num_chunks(), 2);
+
+  auto res = table.sliced(5, 10, ttb::CopyMode::DEEP);
+  ASSERT_EQ(res.arrow_table()->column(0)->num_chunks(), 1);
+  EXPECT_TRUE(res.arrow_table()->Equals(*view.arrow_table()));
+
+  view.combine_chunks();
+  EXPECT_EQ(view.arrow_table()->column(1)->num_chunks(), 1);
+}
+
+TEST(AnalyticTable_Test, SplitsRowsIntoParts) {
+  auto table = make_simple_table(10);
+  auto parts = table.split_rows(3);
+  ASSERT_EQ(parts.size(), 3u);
+  EXPECT_EQ(parts[0].n_rows(), 4);
+  EXPECT_EQ(parts[1].n_rows(), 3);
+  EXPECT_EQ(parts[2].n_rows(), 3);
+
+  auto last = parts[2].arrow_table()->column(0)->chunk(0);
+  EXPECT_EQ(std::static_pointer_cast<arrow::Int64Array>(last)->Value(0), 70);
+
+  EXPECT_THROW(auto fail = table.split_rows(0), ttb::AnalyticTableError);
+}
+
 TEST(AnalyticTable_Test, ReordersColumns) {
   auto table = make_simple_table();
   table.reorder_cols({1, 0});
@@ -188,6 +239,38 @@ TEST(AnalyticTable_Test, CreatesIndependentCopy) {
   EXPECT_EQ(table.n_cols(), 2);
 }
 
+TEST(AnalyticTable_Test, DeepCloneCopiesBuffers) {
+  auto table = make_simple_table(1000);
+  auto res = table.clone(ttb::CopyMode::DEEP);
+  EXPECT_TRUE(res.arrow_table()->Equals(*table.arrow_table()));
+
+  auto original = table.arrow_table()->column(0)->chunk(0);
+  auto copied = res.arrow_table()->column(0)->chunk(0);
+  EXPECT_NE(copied->data()->buffers[1]->data(), original->data()->buffers[1]->data());
+}
+
+TEST(AnalyticTable_Test, DeepCloneCompactsSlicedColumns) {
+  auto table = make_simple_table(100);
+  ttb::AnalyticTable view{table.arrow_table()->Slice(10, 20)};
+  auto res = view.clone();
+  EXPECT_TRUE(res.arrow_table()->Equals(*view.arrow_table()));
+
+  auto copied = res.arrow_table()->column(1)->chunk(0);
+  EXPECT_EQ(copied->offset(), 0);
+  EXPECT_EQ(copied->data()->buffers[1]->size(), 20 * int64_t(sizeof(float)));
+}
+
+TEST(AnalyticTable_Test, CopyOnWriteCloneSharesBuffersUntilModified) {
+  auto table = make_simple_table(10);
+  auto res = table.clone(ttb::CopyMode::COPY_ON_WRITE);
+  EXPECT_EQ(res.arrow_table()->column(0)->chunk(0)->data()->buffers[1],
+            table.arrow_table()->column(0)->chunk(0)->data()->buffers[1]);
+
+  res.sort(0, ttb::SortOrder::DESC);
+  auto original = table.arrow_table()->column(0)->chunk(0);
+  EXPECT_EQ(std::static_pointer_cast<arrow::Int64Array>(original)->Value(0), 0);
+}
+
 TEST(AnalyticTable_Test, ExtractsColumnFromIndex) {
   auto table = make_simple_table();
   auto res = table.right_extract_of(0);
@@ -478,6 +561,34 @@ TEST(AnalyticTable_Test, ExpandsCategoricalColumn) {
   EXPECT_EQ(observed_counts, expected_counts);
 }
 
+TEST(AnalyticTable_Test, CapsOneHotExpansionToTopK) {
+  arrow::Int64Builder catb;
+  for (int64_t i = 0; i < 1000; ++i)
+    EXPECT_TRUE(catb.Append(i % 2 == 0 ? 7 : i % 4 == 1 ? 8 : 1000 + i).ok());
+  EXPECT_TRUE(catb.AppendNull().ok());
+  auto schema = arrow::schema({arrow::field("category", arrow::int64())});
+  ttb::AnalyticTable t{arrow::Table::Make(schema, {catb.Finish().ValueOrDie()})};
+
+  t.one_hot_expand(0, 2);
+
+  EXPECT_EQ(t.col_names(),
+            (std::vector<std::string>{"category_7", "category_8", "category_other"}));
+  std::vector<int64_t> sums;
+  for (int c = 0; c < t.n_cols(); ++c) {
+    auto arr = std::static_pointer_cast<arrow::Int32Array>(t.arrow_table()->column(c)->chunk(0));
+    int64_t sum = 0;
+    for (int64_t r = 0; r < arr->length(); ++r)
+      sum += arr->Value(r);
+    sums.push_back(sum);
+  }
+  EXPECT_EQ(sums, (std::vector<int64_t>{500, 250, 251}));
+
+  // Columns with at most top_k values are fully expanded
+  auto small = make_cat_table();
+  small.one_hot_expand(0, 3);
+  EXPECT_EQ(small.n_cols(), 4);
+}
+
 TEST(AnalyticTable_Test, InvalidNegativeIndexFails) {
   auto t = make_cat_table();
   EXPECT_THROW(t.one_hot_expand(-1), ttb::AnalyticTableError);
@@ -593,3 +704,269 @@ TEST(AnalyticTable_Test, SortMaintainsRowIntegrity) {
   EXPECT_EQ(sorted_cat->Value(3), 3);
   EXPECT_EQ(sorted_val->Value(3), 30.0f);
 }
+
+static ttb::AnalyticTable make_dictionary_table(const std::vector<std::string> &values,
+                                                const std::vector<int64_t> &ids) {
+  arrow::StringBuilder sb;
+  arrow::Int64Builder ib;
+  EXPECT_TRUE(sb.AppendValues(values).ok());
+  EXPECT_TRUE(ib.AppendValues(ids).ok());
+  auto encoded = arrow::compute::DictionaryEncode(sb.Finish().ValueOrDie()).ValueOrDie();
+
+  auto schema =
+      arrow::schema({arrow::field("c", encoded.type()), arrow::field("id", arrow::int64())});
+  return ttb::AnalyticTable{
+      arrow::Table::Make(schema, {encoded.make_array(), ib.Finish().ValueOrDie()})};
+}
+
+static std::vector<std::string> decoded_values(const ttb::AnalyticTable &table, int index) {
+  std::vector<std::string> values;
+  for (const auto &chunk : table.arrow_table()->column(index)->chunks()) {
+    const auto &encoded = static_cast<const arrow::DictionaryArray &>(*chunk);
+    for (int64_t i = 0; i < encoded.length(); ++i)
+      values.push_back(
+          encoded.dictionary()->GetScalar(encoded.GetValueIndex(i)).ValueOrDie()->ToString());
+  }
+  return values;
+}
+
+TEST(AnalyticTable_Test, KeepsDictionaryColumnsThroughAppendAndSort) {
+  auto table = make_dictionary_table({"b", "a", "c", "a"}, {1, 2, 3, 4});
+  table.append(make_dictionary_table({"z", "a"}, {5, 6}), ttb::Axis::ROW);
+  auto dictionary_type = table.arrow_table()->column(0)->type();
+  ASSERT_EQ(dictionary_type->id(), arrow::Type::DICTIONARY);
+
+  table.sort(0, ttb::SortOrder::ASC);
+  EXPECT_TRUE(table.arrow_table()->column(0)->type()->Equals(*dictionary_type));
+  EXPECT_EQ(decoded_values(table, 0), (std::vector<std::string>{"a", "a", "a", "b", "c", "z"}));
+  auto ids = std::static_pointer_cast<arrow::Int64Array>(table.arrow_table()->column(1)->chunk(0));
+  EXPECT_EQ(ids->Value(0), 2);
+  EXPECT_EQ(ids->Value(1), 4);
+  EXPECT_EQ(ids->Value(2), 6);
+
+  table.sort(0, ttb::SortOrder::DESC);
+  EXPECT_EQ(decoded_values(table, 0), (std::vector<std::string>{"z", "c", "b", "a", "a", "a"}));
+
+  auto copy = table.copy_cols({0});
+  EXPECT_EQ(copy.arrow_table()->column(0)->type()->id(), arrow::Type::DICTIONARY);
+}
+
+TEST(AnalyticTable_Test, ExpandsDictionaryColumnByDecodedValues) {
+  auto table = make_dictionary_table({"b", "a", "c", "a"}, {1, 2, 3, 4});
+  table.append(make_dictionary_table({"z", "a"}, {5, 6}), ttb::Axis::ROW);
+
+  auto expanded = table.clone(ttb::CopyMode::COPY_ON_WRITE);
+  expanded.one_hot_expand(0);
+  EXPECT_EQ(expanded.col_names(), (std::vector<std::string>{"id", "c_b", "c_a", "c_c", "c_z"}));
+  auto a_flags =
+      std::static_pointer_cast<arrow::Int32Array>(expanded.arrow_table()->column(2)->chunk(0));
+  std::vector<int32_t> flags(a_flags->raw_values(), a_flags->raw_values() + a_flags->length());
+  EXPECT_EQ(flags, (std::vector<int32_t>{0, 1, 0, 1, 0, 1}));
+
+  table.one_hot_expand(0, 1);
+  EXPECT_EQ(table.col_names(), (std::vector<std::string>{"id", "c_a", "c_other"}));
+}
+
+static ttb::AnalyticTable make_keyed_table(const std::vector<int64_t> &keys,
+                                           const std::vector<std::string> &values,
+                                           const std::string &value_name) {
+  arrow::Int64Builder kb;
+  arrow::StringBuilder vb;
+  EXPECT_TRUE(kb.AppendValues(keys).ok());
+  EXPECT_TRUE(vb.AppendValues(values).ok());
+
+  utl::shp<arrow::Array> kcol, vcol;
+  EXPECT_TRUE(kb.Finish(&kcol).ok());
+  EXPECT_TRUE(vb.Finish(&vcol).ok());
+  auto schema =
+      arrow::schema({arrow::field("id", arrow::int64()), arrow::field(value_name, arrow::utf8())});
+  return ttb::AnalyticTable{arrow::Table::Make(schema, {kcol, vcol})};
+}
+
+TEST(AnalyticTable_Test, InnerJoinKeepsLeftOrderAndAllMatches) {
+  auto left = make_keyed_table({1, 2, 3, 2}, {"a", "b", "c", "d"}, "v");
+  auto right = make_keyed_table({2, 1, 2}, {"x", "y", "z"}, "w");
+
+  for (auto strategy : {ttb::JoinStrategy::BROADCAST, ttb::JoinStrategy::PARTITIONED}) {
+    auto res = left.joined(right, {"id"}, ttb::JoinType::INNER, strategy);
+    ASSERT_EQ(res.n_rows(), 5);
+    EXPECT_EQ(res.col_names(), (std::vector<std::string>{"id", "v", "w"}));
+
+    auto v = std::static_pointer_cast<arrow::StringArray>(res.arrow_table()->column(1)->chunk(0));
+    auto w = std::static_pointer_cast<arrow::StringArray>(res.arrow_table()->column(2)->chunk(0));
+    EXPECT_EQ(v->GetString(0), "a");
+    EXPECT_EQ(w->GetString(0), "y");
+    EXPECT_EQ(v->GetString(2), "b");
+    EXPECT_EQ(w->GetString(2), "z");
+    EXPECT_EQ(v->GetString(4), "d");
+  }
+}
+
+TEST(AnalyticTable_Test, LeftJoinFillsUnmatchedWithNulls) {
+  auto left = make_keyed_table({1, 2, 3}, {"a", "b", "c"}, "v");
+  auto right = make_keyed_table({2, 4}, {"x", "y"}, "v");
+
+  left.join(right, {"id"}, ttb::JoinType::LEFT);
+  ASSERT_EQ(left.n_rows(), 3);
+  EXPECT_EQ(left.col_names(), (std::vector<std::string>{"id", "v", "v_right"}));
+  auto joined = left.arrow_table()->column(2);
+  EXPECT_EQ(joined->null_count(), 2);
+  EXPECT_TRUE(joined->GetScalar(1).ValueOrDie()->Equals(*arrow::MakeScalar("x")));
+}
+
+TEST(AnalyticTable_Test, JoinFailsOnMissingOrMismatchedKeys) {
+  auto left = make_keyed_table({1}, {"a"}, "v");
+  auto right = make_keyed_table({1}, {"x"}, "w");
+  auto other = make_simple_table();
+  other.rename_cols({"id", "v"});
+
+  EXPECT_THROW(auto res = left.joined(right, {}), ttb::AnalyticTableError);
+  EXPECT_THROW(auto res = left.joined(right, {"missing"}), ttb::AnalyticTableError);
+  EXPECT_THROW(auto res = left.joined(other, {"id", "v"}), ttb::AnalyticTableError);
+}
+
+static ttb::AnalyticTable make_nullable_table() {
+  arrow::Int64Builder ib;
+  arrow::DoubleBuilder db;
+  for (int64_t i = 0; i < 10; ++i) {
+    EXPECT_TRUE(ib.Append(i).ok());
+    EXPECT_TRUE((i == 3 ? db.AppendNull() : db.Append(static_cast<double>(i) * 1.5)).ok());
+  }
+
+  utl::shp<arrow::Array> icol, dcol;
+  EXPECT_TRUE(ib.Finish(&icol).ok());
+  EXPECT_TRUE(db.Finish(&dcol).ok());
+  auto schema =
+      arrow::schema({arrow::field("id", arrow::int64()), arrow::field("x", arrow::float64())});
+  auto table = arrow::Table::Make(schema, {icol, dcol});
+  return ttb::AnalyticTable{arrow::ConcatenateTables({table, table}).ValueOrDie()};
+}
+
+TEST(AnalyticTable_Test, FilteredKeepsRowsMatchingPredicate) {
+  namespace cp = arrow::compute;
+  auto table = make_nullable_table();
+
+  auto res = table.filtered(cp::and_(cp::greater(cp::field_ref("id"), cp::literal(int64_t{5})),
+                                     cp::not_(cp::is_null(cp::field_ref("x")))));
+  EXPECT_EQ(res.n_rows(), 8);
+
+  arrow::Int64Builder vb;
+  ASSERT_TRUE(vb.AppendValues({1, 3}).ok());
+  auto in = table.filtered(cp::call("is_in", {cp::field_ref("id")},
+                                    cp::SetLookupOptions{vb.Finish().ValueOrDie()}));
+  EXPECT_EQ(in.n_rows(), 4);
+  EXPECT_EQ(table.n_rows(), 20);
+}
+
+TEST(AnalyticTable_Test, FilterInPlaceSlicesWhenFewRowsAreDropped) {
+  namespace cp = arrow::compute;
+  auto table = make_nullable_table();
+  auto expected = table.filtered(cp::is_valid(cp::field_ref("x")));
+
+  table.filter(cp::is_valid(cp::field_ref("x")));
+  EXPECT_EQ(table.n_rows(), 18);
+  EXPECT_GT(table.arrow_table()->column(0)->num_chunks(), 2);
+  EXPECT_TRUE(table.arrow_table()->Equals(*expected.arrow_table()));
+
+  auto shared = table.arrow_table();
+  table.filter(cp::literal(true));
+  EXPECT_EQ(table.arrow_table(), shared);
+
+  table.filter(cp::literal(false));
+  EXPECT_EQ(table.n_rows(), 0);
+  EXPECT_EQ(table.n_cols(), 2);
+}
+
+TEST(AnalyticTable_Test, FilterFailsOnInvalidPredicates) {
+  namespace cp = arrow::compute;
+  auto table = make_nullable_table();
+  EXPECT_THROW(static_cast<void>(table.filtered(cp::field_ref("id"))), ttb::AnalyticTableError);
+  EXPECT_THROW(static_cast<void>(table.filtered(cp::is_null(cp::field_ref("missing")))),
+               ttb::AnalyticTableError);
+}
+
+TEST(AnalyticTable_Test, DropsRowsWithNulls) {
+  auto table = make_nullable_table();
+  table.drop_nulls({"id"});
+  EXPECT_EQ(table.n_rows(), 20);
+
+  table.drop_nulls();
+  EXPECT_EQ(table.n_rows(), 18);
+  EXPECT_EQ(table.arrow_table()->column(1)->null_count(), 0);
+  EXPECT_THROW(table.drop_nulls({"missing"}), ttb::AnalyticTableError);
+}
+
+TEST(AnalyticTable_Test, DropsDuplicatesKeepingFirstOrLast) {
+  auto table = make_nullable_table();
+
+  auto first = table.unique_rows({"id"});
+  auto last = table.unique_rows({"id"}, ttb::Keep::LAST);
+  EXPECT_EQ(first->true_count(), 10);
+  EXPECT_EQ(last->true_count(), 10);
+  for (int64_t i = 0; i < 20; ++i) {
+    EXPECT_EQ(first->Value(i), i < 10);
+    EXPECT_EQ(last->Value(i), i >= 10);
+  }
+
+  // Nulls equal nulls, all columns being the default keys
+  EXPECT_EQ(table.deduplicated().n_rows(), 10);
+  EXPECT_EQ(table.deduplicated({"id", "x"}, ttb::Keep::LAST).n_rows(), 10);
+
+  table.drop_duplicates({"x"});
+  EXPECT_EQ(table.n_rows(), 10);
+  EXPECT_EQ(table.arrow_table()->column(1)->null_count(), 1);
+  EXPECT_THROW(table.drop_duplicates({"missing"}), ttb::AnalyticTableError);
+}
+
+TEST(AnalyticTable_Test, DropsDuplicatesOfSortedTableLikeUnsortedOnes) {
+  arrow::Int64Builder kb;
+  arrow::Int64Builder sb;
+  std::map<int64_t, int64_t> last_rows;
+  for (int64_t i = 0; i < 100000; ++i) {
+    auto key = (i * 7919) % 1013;
+    EXPECT_TRUE(kb.Append(key).ok());
+    EXPECT_TRUE(sb.Append(i).ok());
+    last_rows[key] = i;
+  }
+  auto schema =
+      arrow::schema({arrow::field("key", arrow::int64()), arrow::field("seq", arrow::int64())});
+  ttb::AnalyticTable table{
+      arrow::Table::Make(schema, {kb.Finish().ValueOrDie(), sb.Finish().ValueOrDie()})};
+
+  auto unsorted = table.deduplicated({"key"}, ttb::Keep::LAST);
+  ASSERT_EQ(unsorted.n_rows(), 1013);
+  std::vector<int64_t> expected;
+  for (auto [key, last_row] : last_rows)
+    expected.push_back(last_row);
+  std::ranges::sort(expected);
+  auto kept = std::static_pointer_cast<arrow::Int64Array>(
+      unsorted.arrow_table()->column(1)->chunk(0));
+  EXPECT_EQ(std::vector<int64_t>(kept->raw_values(), kept->raw_values() + kept->length()),
+            expected);
+
+  // Sorting is stable, so the last row of every run of equal keys is its last occurrence
+  table.sort(0);
+  table.drop_duplicates({"key"}, ttb::Keep::LAST);
+  ASSERT_EQ(table.n_rows(), 1013);
+  auto keys = std::static_pointer_cast<arrow::Int64Array>(table.arrow_table()->column(0)->chunk(0));
+  auto seqs = std::static_pointer_cast<arrow::Int64Array>(table.arrow_table()->column(1)->chunk(0));
+  int64_t r = 0;
+  for (auto [key, last_row] : last_rows) {
+    EXPECT_EQ(keys->Value(r), key);
+    EXPECT_EQ(seqs->Value(r), last_row);
+    ++r;
+  }
+}
+
+TEST(AnalyticTable_Test, DropsDuplicatesOfSortedFloatsLikeUnsortedOnes) {
+  arrow::DoubleBuilder db;
+  EXPECT_TRUE(db.AppendValues({0.0, -0.0, 0.0, 1.0, -0.0}).ok());
+  auto schema = arrow::schema({arrow::field("x", arrow::float64())});
+  ttb::AnalyticTable table{arrow::Table::Make(schema, {db.Finish().ValueOrDie()})};
+  EXPECT_EQ(table.deduplicated().n_rows(), 3);
+
+  // Sorting leaves -0.0 and 0.0 interleaved, as equal
+  table.sort(0);
+  table.drop_duplicates();
+  EXPECT_EQ(table.n_rows(), 3);
+}
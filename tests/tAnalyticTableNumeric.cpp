@@ -54,6 +54,30 @@ std::shared_ptr<arrow::Table> make_mixed_type_table() {
   return arrow::Table::Make(schema, {int_array, float_array});
 }
 
+// Column with nulls at rows 0 and 2, doubled into two chunks
+std::shared_ptr<arrow::Table> make_nullable_table() {
+  arrow::DoubleBuilder builder;
+  EXPECT_TRUE(builder.AppendNull().ok());
+  EXPECT_TRUE(builder.Append(1.0).ok());
+  EXPECT_TRUE(builder.AppendNull().ok());
+  EXPECT_TRUE(builder.AppendValues({3.0, 8.0}).ok());
+
+  std::shared_ptr<arrow::Array> array;
+  EXPECT_TRUE(builder.Finish(&array).ok());
+  auto table = arrow::Table::Make(arrow::schema({arrow::field("x", arrow::float64())}), {array});
+  return arrow::ConcatenateTables({table, table}).ValueOrDie();
+}
+
+std::vector<double> column_values(const ttb::AnalyticTable &table) {
+  std::vector<double> resp;
+  for (const auto &chunk : table.arrow_table()->column(0)->chunks()) {
+    auto values = std::static_pointer_cast<arrow::DoubleArray>(chunk);
+    for (int64_t i = 0; i < values->length(); ++i)
+      resp.push_back(values->Value(i));
+  }
+  return resp;
+}
+
 } // namespace
 
 // ------------ Constructor tests ------------
@@ -449,4 +473,26 @@ TEST(AnalyticTableNumeric_Test, WorksWithTypeAliases) {
     ttb::TbDouble tb(std::move(data));
     EXPECT_EQ(tb.n_rows(), 2);
   }
-}
\ No newline at end of file
+}
+
+// ------------ Null handling tests ------------
+
+TEST(AnalyticTableNumeric_Test, FillsNullsWithConstantMeanAndMedian) {
+  TbNumeric<double> constant{make_nullable_table()};
+  constant.fill_nulls(ttb::FillStrategy::CONSTANT, -1.0);
+  EXPECT_EQ(constant.arrow_table()->column(0)->null_count(), 0);
+  EXPECT_EQ(column_values(constant), (std::vector<double>{-1, 1, -1, 3, 8, -1, 1, -1, 3, 8}));
+
+  TbNumeric<double> mean{make_nullable_table()};
+  mean.fill_nulls(ttb::FillStrategy::MEAN);
+  EXPECT_DOUBLE_EQ(column_values(mean)[0], 4.0);
+
+  TbNumeric<int64_t> median{make_nullable_table()};
+  EXPECT_EQ(median.null_fill(0, ttb::FillStrategy::MEDIAN), 3);
+}
+
+TEST(AnalyticTableNumeric_Test, FillsNullsForwardAcrossChunks) {
+  TbNumeric<double> table{make_nullable_table()};
+  table.fill_nulls(ttb::FillStrategy::FORWARD, -1.0);
+  EXPECT_EQ(column_values(table), (std::vector<double>{-1, 1, 1, 3, 8, 8, 1, 1, 3, 8}));
+}
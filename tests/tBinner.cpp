@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+
+#include "AnalyticTableNumeric.h"
+#include "Binner.h"
+#include "detail/utils.h"
+
+#include <arrow/api.h>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+TEST(Binner_Test, EqualWidthEdgesSpanMinToMax) {
+  std::vector<double> values{2.0, 4.0, 10.0, 6.0};
+  ttb::Binner binner{ttb::Binning::EQUAL_WIDTH, 4};
+  binner.update(values.data(), static_cast<int64_t>(values.size()));
+
+  EXPECT_EQ(binner.count(), 4);
+  EXPECT_EQ(binner.edges(), (std::vector<double>{2.0, 4.0, 6.0, 8.0, 10.0}));
+
+  std::vector<double> bins(values.size());
+  binner.transform(values.data(), bins.data(), static_cast<int64_t>(values.size()));
+  EXPECT_EQ(bins, (std::vector<double>{0.0, 1.0, 3.0, 2.0}));
+}
+
+TEST(Binner_Test, QuantileBinsHoldSimilarCountsAcrossBatches) {
+  std::vector<int64_t> values(1 << 18);
+  std::iota(values.begin(), values.end(), 0);
+
+  // Fitted in two batches, as if streamed
+  ttb::Binner binner{ttb::Binning::QUANTILE, 4};
+  auto half = static_cast<int64_t>(values.size() / 2);
+  binner.update(values.data(), half);
+  binner.update(values.data() + half, half);
+  EXPECT_EQ(binner.count(), 1 << 18);
+
+  auto edges = binner.edges();
+  ASSERT_EQ(edges.size(), 5);
+  EXPECT_EQ(edges.front(), 0.0);
+  EXPECT_EQ(edges.back(), static_cast<double>((1 << 18) - 1));
+  EXPECT_NEAR(edges[2], 1 << 17, (1 << 18) * 0.02);
+
+  auto counts = binner.histogram(values.data(), static_cast<int64_t>(values.size()));
+  for (auto count : counts)
+    EXPECT_NEAR(static_cast<double>(count), 1 << 16, (1 << 18) * 0.04);
+}
+
+TEST(Binner_Test, CustomEdgesClampOutOfRangeValues) {
+  ttb::Binner binner{std::vector<double>{0.0, 1.0, 5.0}};
+  EXPECT_EQ(binner.n_bins(), 2);
+
+  std::vector<float> values{-3.0f, 0.5f, 1.0f, 7.0f, NAN};
+  EXPECT_EQ(binner.histogram(values.data(), 5), (std::vector<int64_t>{2, 2}));
+
+  EXPECT_THROW(ttb::Binner(std::vector<double>{1.0, 0.0}), ttb::BinnerError);
+  EXPECT_THROW(ttb::Binner(ttb::Binning::QUANTILE, 0), ttb::BinnerError);
+  EXPECT_THROW(static_cast<void>(ttb::Binner(ttb::Binning::QUANTILE, 2).edges()),
+               ttb::BinnerError);
+}
+
+TEST(Binner_Test, BinsTableColumnKeepingNulls) {
+  arrow::DoubleBuilder builder;
+  ASSERT_TRUE(builder.AppendValues({1.0, 2.0, 3.0}).ok());
+  ASSERT_TRUE(builder.AppendNull().ok());
+  ASSERT_TRUE(builder.Append(4.0).ok());
+  auto column = builder.Finish().ValueOrDie();
+  auto schema = arrow::schema({arrow::field("x", arrow::float64())});
+  ttb::TbDouble table{arrow::Table::Make(schema, {column})};
+
+  auto binner = table.fit_binner(0, ttb::Binning::EQUAL_WIDTH, 3);
+  EXPECT_EQ(binner.count(), 4);
+  table.bin(0, binner);
+
+  auto binned =
+      std::static_pointer_cast<arrow::DoubleArray>(table.arrow_table()->column(0)->chunk(0));
+  EXPECT_EQ(binned->null_count(), 1);
+  EXPECT_DOUBLE_EQ(binned->Value(0), 0.0);
+  EXPECT_DOUBLE_EQ(binned->Value(1), 1.0);
+  EXPECT_DOUBLE_EQ(binned->Value(4), 2.0);
+  EXPECT_TRUE(binned->IsNull(3));
+}
@@ -4,9 +4,13 @@
 #include "CSV_IO.h"
 
 #include <arrow/api.h>
+#include <arrow/util/thread_pool.h>
+#include <array>
 #include <filesystem>
 #include <fstream>
+#include <iterator>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace fs = std::filesystem;
@@ -109,3 +113,310 @@ TEST(CSV_IO_Test, WritesFileAndIsReadable) {
 
   fs::remove(path);
 }
+
+TEST(CSV_IO_Test, ReadsExplicitColumnTypes) {
+  auto path = tcsv_io::unique_path("explicit_types");
+  tcsv_io::write_text(path, "a,b\n1,2\n3,4\n");
+
+  ttb::CSVOptions options;
+  options.column_types = {{"a", arrow::float32()}};
+  ttb::CSV_IO reader(path, /*has_header=*/true, options);
+  auto res = reader.read();
+
+  auto types = res.col_dtypes();
+  ASSERT_EQ(types.size(), 2u);
+  EXPECT_EQ(types[0], "float");
+  EXPECT_EQ(types[1], "int64");
+
+  fs::remove(path);
+}
+
+TEST(CSV_IO_Test, ReadsOnlyIncludedColumns) {
+  auto path = tcsv_io::unique_path("include_columns");
+  tcsv_io::write_text(path, "a,b,c\n1,x,2.5\n3,y,4.5\n");
+
+  ttb::CSVOptions options;
+  options.include_columns = {"c", "a"};
+  ttb::CSV_IO reader(path, /*has_header=*/true, options);
+  auto res = reader.read();
+
+  EXPECT_EQ(res.n_rows(), 2);
+  auto names = res.col_names();
+  ASSERT_EQ(names.size(), 2u);
+  EXPECT_EQ(names[0], "c");
+  EXPECT_EQ(names[1], "a");
+
+  fs::remove(path);
+}
+
+TEST(CSV_IO_Test, ReadsCustomNullValues) {
+  auto path = tcsv_io::unique_path("null_values");
+  tcsv_io::write_text(path, "a,b\n1,?\n?,4\n");
+
+  ttb::CSVOptions options;
+  options.null_values = {"?"};
+  ttb::CSV_IO reader(path, /*has_header=*/true, options);
+  auto res = reader.read();
+
+  EXPECT_EQ(res.arrow_table()->column(0)->null_count(), 1);
+  EXPECT_EQ(res.arrow_table()->column(1)->null_count(), 1);
+  EXPECT_EQ(res.col_dtypes()[0], "int64");
+
+  fs::remove(path);
+}
+
+TEST(CSV_IO_Test, ReadNumericParsesDirectlyAsTargetType) {
+  auto path = tcsv_io::unique_path("numeric_fast_path");
+  tcsv_io::write_text(path, "a,b,c\n1,2,3\n4,5,6\n");
+
+  ttb::CSVOptions options;
+  options.include_columns = {"a", "c"};
+  options.parse_numeric_directly = true;
+  ttb::CSV_IO reader(path, /*has_header=*/true, options);
+  auto res = reader.read_numeric<float>();
+
+  EXPECT_EQ(res.n_cols(), 2);
+  for (const auto &type : res.col_dtypes())
+    EXPECT_EQ(type, "float");
+
+  auto col = std::static_pointer_cast<arrow::FloatArray>(res.arrow_table()->column(1)->chunk(0));
+  EXPECT_FLOAT_EQ(col->Value(1), 6.0f);
+
+  fs::remove(path);
+}
+
+TEST(CSV_IO_Test, ReadNumericCastsInferredTypesByDefault) {
+  auto path = tcsv_io::unique_path("numeric_cast");
+  tcsv_io::write_text(path, "a,b\n1.5,true\n2.7,false\n");
+
+  ttb::CSV_IO reader(path);
+  auto res = reader.read_numeric<int>();
+  auto a = std::static_pointer_cast<arrow::Int32Array>(res.arrow_table()->column(0)->chunk(0));
+  auto b = std::static_pointer_cast<arrow::Int32Array>(res.arrow_table()->column(1)->chunk(0));
+  EXPECT_EQ(a->Value(1), 2);
+  EXPECT_EQ(b->Value(0), 1);
+  EXPECT_EQ(b->Value(1), 0);
+
+  // Parsing directly as int rejects the same values
+  ttb::CSVOptions options;
+  options.parse_numeric_directly = true;
+  ttb::CSV_IO typed_reader(path, /*has_header=*/true, options);
+  EXPECT_THROW(auto x = typed_reader.read_numeric<int>(), ttb::CSV_IOError);
+
+  fs::remove(path);
+}
+
+TEST(CSV_IO_Test, ReadNumericWithoutHeader) {
+  auto path = tcsv_io::unique_path("numeric_no_header");
+  tcsv_io::write_text(path, "1.5,2\n3.5,4\n");
+
+  ttb::CSV_IO reader(path, /*has_header=*/false);
+  auto res = reader.read_numeric<double>();
+
+  EXPECT_EQ(res.n_rows(), 2);
+  EXPECT_EQ(res.n_cols(), 2);
+  EXPECT_EQ(res.col_dtypes()[1], "double");
+
+  fs::remove(path);
+}
+
+TEST(CSV_IO_Test, ReadsWithSmallBlocksAndDedicatedIOPool) {
+  auto path = tcsv_io::unique_path("tuned_read");
+  std::string content{"a,b\n"};
+  for (int i = 0; i < 1000; ++i)
+    content += std::to_string(i) + "," + std::to_string(2 * i) + "\n";
+  tcsv_io::write_text(path, content);
+
+  ttb::CSVOptions options;
+  options.block_size = 256;
+  options.io_threads = 2;
+  ttb::CSV_IO reader(path, /*has_header=*/true, options);
+  ttb::CSVReadStats stats;
+  auto res = reader.read_numeric<int64_t>(',', &stats);
+
+  EXPECT_EQ(res.n_rows(), 1000);
+  EXPECT_GT(res.arrow_table()->column(0)->num_chunks(), 1);
+
+  EXPECT_EQ(stats.n_rows, 1000);
+  EXPECT_EQ(stats.n_bytes, static_cast<int64_t>(content.size()));
+  EXPECT_GE(stats.mb_per_second(), 0.0);
+
+  fs::remove(path);
+}
+
+TEST(CSV_IO_Test, ConcurrentReadsReportTheirOwnStats) {
+  auto short_path = tcsv_io::unique_path("stats_short");
+  auto long_path = tcsv_io::unique_path("stats_long");
+  tcsv_io::write_text(short_path, "a\n1\n");
+  std::string content{"a\n"};
+  for (int i = 0; i < 500; ++i)
+    content += std::to_string(i) + "\n";
+  tcsv_io::write_text(long_path, content);
+
+  // The pool is process-wide, so later tests get back its capacity
+  auto cpu_threads = arrow::GetCpuThreadPoolCapacity();
+  ttb::CSV_IO::set_cpu_threads(2);
+  ttb::CSV_IO short_reader(short_path, /*has_header=*/true);
+  ttb::CSV_IO long_reader(long_path, /*has_header=*/true);
+  std::array<ttb::CSVReadStats, 8> stats{};
+  std::vector<std::thread> readers;
+  for (size_t i = 0; i < stats.size(); ++i)
+    readers.emplace_back([&, i] {
+      const auto &reader = i % 2 == 0 ? short_reader : long_reader;
+      (void)reader.read(',', &stats[i]);
+    });
+  for (auto &reader : readers)
+    reader.join();
+  ttb::CSV_IO::set_cpu_threads(cpu_threads);
+
+  for (size_t i = 0; i < stats.size(); ++i)
+    EXPECT_EQ(stats[i].n_rows, i % 2 == 0 ? 1 : 500);
+
+  fs::remove(short_path);
+  fs::remove(long_path);
+}
+
+TEST(CSV_IO_Test, ReadsSerially) {
+  auto path = tcsv_io::unique_path("serial_read");
+  tcsv_io::write_text(path, "a,b\n1,2\n3,4\n");
+
+  ttb::CSVOptions options;
+  options.use_threads = false;
+  ttb::CSV_IO reader(path, /*has_header=*/true, options);
+  auto res = reader.read();
+  EXPECT_EQ(res.n_rows(), 2);
+
+  fs::remove(path);
+}
+
+TEST(CSV_IO_Test, WritesBlocksInOrder) {
+  auto path = tcsv_io::unique_path("write_blocks");
+
+  arrow::Int64Builder ib;
+  for (int64_t i = 0; i < 1000; ++i)
+    ASSERT_TRUE(ib.Append(i).ok());
+  utl::shp<arrow::Array> icol;
+  ASSERT_TRUE(ib.Finish(&icol).ok());
+  auto table = ttb::AnalyticTable{
+      arrow::Table::Make(arrow::schema({arrow::field("i", arrow::int64())}), {icol})};
+
+  ttb::CSVOptions options;
+  options.batch_size = 7;
+  ttb::CSV_IO writer(path, /*has_header=*/true, options);
+  writer.write(table);
+
+  ttb::CSV_IO reader(path, /*has_header=*/true);
+  auto res = reader.read_numeric<int64_t>();
+  ASSERT_EQ(res.n_rows(), 1000);
+
+  auto values = res.arrow_table()->CombineChunks().ValueOrDie()->column(0)->chunk(0);
+  const auto &ints = static_cast<const arrow::Int64Array &>(*values);
+  for (int64_t i = 0; i < 1000; ++i)
+    EXPECT_EQ(ints.Value(i), i);
+
+  fs::remove(path);
+}
+
+TEST(CSV_IO_Test, WritesQuotedStringsNullsAndFloatPrecision) {
+  auto path = tcsv_io::unique_path("write_format");
+
+  arrow::DoubleBuilder db;
+  arrow::StringBuilder sb;
+  ASSERT_TRUE(db.AppendValues({1.0 / 3.0, 2.5, 1234567.0}).ok());
+  ASSERT_TRUE(db.AppendNull().ok());
+  ASSERT_TRUE(sb.AppendValues({"plain", "a,\"b\"", "big", "c"}).ok());
+  utl::shp<arrow::Array> dcol;
+  utl::shp<arrow::Array> scol;
+  ASSERT_TRUE(db.Finish(&dcol).ok());
+  ASSERT_TRUE(sb.Finish(&scol).ok());
+  auto table = ttb::AnalyticTable{arrow::Table::Make(
+      arrow::schema({arrow::field("d", arrow::float64()), arrow::field("s", arrow::utf8())}),
+      {dcol, scol})};
+
+  ttb::CSVOptions options;
+  options.float_precision = 3;
+  ttb::CSV_IO writer(path, /*has_header=*/true, options);
+  writer.write(table);
+
+  std::ifstream ifs(path, std::ios::binary);
+  std::string content{std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()};
+  EXPECT_EQ(content, "d,s\n0.333,plain\n2.500,\"a,\"\"b\"\"\"\n1234567.000,big\n,c\n");
+
+  fs::remove(path);
+}
+
+TEST(CSV_IO_Test, WritesCompressedByExtension) {
+  auto path = tcsv_io::unique_path("write_gzip", ".csv.gz");
+
+  auto table = tcsv_io::make_simple_table();
+  ttb::CSV_IO writer(path, /*has_header=*/true);
+  writer.write(table);
+
+  std::ifstream ifs(path, std::ios::binary);
+  std::array<unsigned char, 2> magic{};
+  ifs.read(reinterpret_cast<char *>(magic.data()), magic.size());
+  EXPECT_EQ(magic[0], 0x1f);
+  EXPECT_EQ(magic[1], 0x8b);
+
+  fs::remove(path);
+}
+
+TEST(CSV_IO_Test, ReadsGzipByExtension) {
+  auto path = tcsv_io::unique_path("read_gzip", ".csv.gz");
+
+  auto table = tcsv_io::make_simple_table();
+  ttb::CSV_IO(path, /*has_header=*/true).write(table);
+
+  ttb::CSV_IO reader(path, /*has_header=*/true);
+  auto res = reader.read();
+  EXPECT_EQ(res.n_rows(), 3);
+  EXPECT_EQ(res.col_names(), (std::vector<std::string>{"f32", "i64"}));
+
+  fs::remove(path);
+}
+
+TEST(CSV_IO_Test, ReadsZstdByMagicBytes) {
+  auto path = tcsv_io::unique_path("read_zstd");
+
+  ttb::CSVOptions options;
+  options.compression = arrow::Compression::ZSTD;
+  options.batch_size = 2;
+  auto table = tcsv_io::make_simple_table();
+  ttb::CSV_IO(path, /*has_header=*/true, options).write(table);
+
+  /// Plain .csv extension, compression detected from the file content
+  ttb::CSV_IO reader(path, /*has_header=*/true);
+  auto res = reader.read_numeric<double>();
+  EXPECT_EQ(res.n_rows(), 3);
+  EXPECT_EQ(res.n_cols(), 2);
+
+  fs::remove(path);
+}
+
+TEST(CSV_IO_Test, ReadsPlainFileStartingLikeBzip2) {
+  auto path = tcsv_io::unique_path("bzh_header");
+  tcsv_io::write_text(path, "BZh9,b\n1,2\n3,4\n");
+
+  ttb::CSV_IO reader(path, /*has_header=*/true);
+  auto res = reader.read();
+  EXPECT_EQ(res.n_rows(), 2);
+  EXPECT_EQ(res.col_names(), (std::vector<std::string>{"BZh9", "b"}));
+
+  fs::remove(path);
+}
+
+TEST(CSV_IO_Test, ReadsBzip2ByMagicBytes) {
+  auto path = tcsv_io::unique_path("read_bzip2");
+
+  ttb::CSVOptions options;
+  options.compression = arrow::Compression::BZ2;
+  auto table = tcsv_io::make_simple_table();
+  ttb::CSV_IO(path, /*has_header=*/true, options).write(table);
+
+  ttb::CSV_IO reader(path, /*has_header=*/true);
+  auto res = reader.read();
+  EXPECT_EQ(res.n_rows(), 3);
+  EXPECT_EQ(res.col_names(), (std::vector<std::string>{"f32", "i64"}));
+
+  fs::remove(path);
+}
@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+
+#include "CategoryEncoder.h"
+#include "detail/utils.h"
+
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <cmath>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+static ttb::AnalyticTable make_table(const std::vector<std::optional<std::string>> &categories,
+                                     const std::vector<double> &targets) {
+  arrow::StringBuilder strings;
+  for (const auto &category : categories)
+    EXPECT_TRUE((category ? strings.Append(*category) : strings.AppendNull()).ok());
+  arrow::DoubleBuilder doubles;
+  EXPECT_TRUE(doubles.AppendValues(targets).ok());
+
+  auto schema =
+      arrow::schema({arrow::field("c", arrow::utf8()), arrow::field("y", arrow::float64())});
+  return ttb::AnalyticTable{arrow::Table::Make(
+      schema, {strings.Finish().ValueOrDie(), doubles.Finish().ValueOrDie()})};
+}
+
+static std::vector<double> column_values(const ttb::AnalyticTable &table, int index) {
+  std::vector<double> values;
+  for (const auto &chunk : table.arrow_table()->column(index)->chunks()) {
+    auto typed = std::static_pointer_cast<arrow::DoubleArray>(chunk);
+    values.insert(values.end(), typed->raw_values(), typed->raw_values() + typed->length());
+  }
+  return values;
+}
+
+TEST(CategoryEncoder_Test, EncodesTrainingRowsOutOfFold) {
+  auto table = make_table({"a", "a", "b", "b", "a", "a", "b", "b"}, {1, 2, 3, 4, 5, 6, 7, 8});
+  ttb::CategoryEncoder encoder{ttb::CategoryEncoding::MEAN_TARGET, 2, 0.0};
+  encoder.fit_transform(table, "c", "y");
+
+  EXPECT_EQ(table.col_names(), (std::vector<std::string>{"c_mean_target", "y"}));
+  EXPECT_EQ(column_values(table, 0), (std::vector<double>{4, 3, 6, 5, 4, 3, 6, 5}));
+  EXPECT_DOUBLE_EQ(encoder.unseen_value(), 4.5);
+}
+
+TEST(CategoryEncoder_Test, EncodesEvalRowsWithTrainingStatistics) {
+  auto table = make_table({"a", "a", "b", "b", "a", "a", "b", "b"}, {1, 2, 3, 4, 5, 6, 7, 8});
+  ttb::CategoryEncoder encoder{ttb::CategoryEncoding::MEAN_TARGET, 2, 0.0};
+  encoder.fit_transform(table, "c", "y", 25);
+
+  // Rows 6 and 7 are held out: their targets are never used
+  EXPECT_EQ(column_values(table, 0), (std::vector<double>{4, 3, 4, 3, 4, 3, 3.5, 3.5}));
+  EXPECT_DOUBLE_EQ(encoder.unseen_value(), 3.5);
+}
+
+TEST(CategoryEncoder_Test, FitsOnExplicitTrainingRows) {
+  auto table = make_table({"a", "a", "b", "b", "a", "a", "b", "b"}, {1, 2, 3, 4, 5, 6, 7, 8});
+  auto leading = make_table({"a", "a", "b", "b", "a", "a", "b", "b"}, {1, 2, 3, 4, 5, 6, 7, 8});
+  ttb::CategoryEncoder encoder{ttb::CategoryEncoding::MEAN_TARGET, 2, 0.0};
+  encoder.fit_transform(leading, "c", "y", 25);
+
+  // The same training rows, listed in any order, encode alike
+  ttb::CategoryEncoder explicit_encoder{ttb::CategoryEncoding::MEAN_TARGET, 2, 0.0};
+  explicit_encoder.fit_transform(table, "c", "y", {5, 0, 3, 1, 4, 2});
+  EXPECT_EQ(column_values(table, 0), column_values(leading, 0));
+
+  // Holding out rows 0 and 2 instead: eval rows get the values fitted on rows 1 and 3 to 7
+  auto shuffled = make_table({"a", "a", "b", "b", "a", "a", "b", "b"}, {1, 2, 3, 4, 5, 6, 7, 8});
+  explicit_encoder.fit_transform(shuffled, "c", "y", {1, 3, 4, 5, 6, 7});
+  auto values = column_values(shuffled, 0);
+  EXPECT_DOUBLE_EQ(values[0], 13.0 / 3.0);
+  EXPECT_DOUBLE_EQ(values[2], 19.0 / 3.0);
+  EXPECT_DOUBLE_EQ(explicit_encoder.unseen_value(), 32.0 / 6.0);
+
+  auto out_of_bounds = make_table({"a", "b"}, {1, 2});
+  EXPECT_THROW(explicit_encoder.fit_transform(out_of_bounds, "c", "y", std::vector<int64_t>{2}),
+               ttb::CategoryEncoderError);
+}
+
+TEST(CategoryEncoder_Test, FallsBackToPriorWithoutRowsOrSmoothing) {
+  auto table = make_table({"a", "a", "b", "a", "c"}, {1, 3, 5, 2, 0});
+  ttb::CategoryEncoder encoder{ttb::CategoryEncoding::MEAN_TARGET, 2, 0.0};
+  encoder.fit_transform(table, "c", "y", 20);
+
+  // "b" has no out-of-fold row and "c" no training row: both get the (fold) prior
+  auto values = column_values(table, 0);
+  EXPECT_DOUBLE_EQ(values[2], 2.5);
+  EXPECT_DOUBLE_EQ(values[4], 2.75);
+  for (auto value : values)
+    EXPECT_FALSE(std::isnan(value));
+}
+
+TEST(CategoryEncoder_Test, SmoothsTowardsPriorAndEncodesUnseenCategories) {
+  auto table = make_table({"a", "a", "a", "b"}, {1, 1, 1, 5});
+  ttb::CategoryEncoder encoder{ttb::CategoryEncoding::MEAN_TARGET, 2, 2.0};
+  encoder.fit_transform(table, "c", "y");
+  EXPECT_DOUBLE_EQ(encoder.unseen_value(), 2.0);
+
+  auto new_rows = make_table({"b", "z", std::nullopt, "a"}, {0, 0, 0, 0});
+  encoder.transform(new_rows, "c");
+  auto values = column_values(new_rows, 0);
+  EXPECT_DOUBLE_EQ(values[0], 3.0);
+  EXPECT_DOUBLE_EQ(values[1], 2.0);
+  EXPECT_DOUBLE_EQ(values[2], 2.0);
+  EXPECT_DOUBLE_EQ(values[3], 1.4);
+
+  // A restored mapping encodes the same way
+  ttb::CategoryEncoder restored{ttb::CategoryEncoding::MEAN_TARGET, encoder.mapping(),
+                                encoder.unseen_value()};
+  auto again = make_table({"b", "z", std::nullopt, "a"}, {0, 0, 0, 0});
+  restored.transform(again, "c");
+  EXPECT_EQ(column_values(again, 0), values);
+  EXPECT_EQ(encoder.mapping().n_rows(), 2);
+}
+
+TEST(CategoryEncoder_Test, EncodesFrequencies) {
+  auto table = make_table({"a", "a", "a", "b"}, {0, 0, 0, 0});
+  ttb::CategoryEncoder encoder{ttb::CategoryEncoding::FREQUENCY};
+  encoder.fit_transform(table, "c", "");
+
+  EXPECT_EQ(table.col_names(), (std::vector<std::string>{"c_frequency", "y"}));
+  EXPECT_EQ(column_values(table, 0), (std::vector<double>{0.75, 0.75, 0.75, 0.25}));
+
+  auto new_rows = make_table({"z", "b"}, {0, 0});
+  encoder.transform(new_rows, "c");
+  EXPECT_EQ(column_values(new_rows, 0), (std::vector<double>{0.0, 0.25}));
+}
+
+TEST(CategoryEncoder_Test, EncodesDictionaryColumnsLikeTheirValues) {
+  auto dictionary_encoded = [](const ttb::AnalyticTable &table) {
+    auto column = table.arrow_table()->column(0);
+    auto encoded = arrow::compute::DictionaryEncode(column).ValueOrDie().chunked_array();
+    auto field = arrow::field("c", encoded->type());
+    return ttb::AnalyticTable{table.arrow_table()->SetColumn(0, field, encoded).ValueOrDie()};
+  };
+
+  auto plain = make_table({"a", "a", "b", "b", "a", "a", "b", "b"}, {1, 2, 3, 4, 5, 6, 7, 8});
+  auto table = dictionary_encoded(plain);
+  ttb::CategoryEncoder encoder{ttb::CategoryEncoding::MEAN_TARGET, 2, 0.0};
+  encoder.fit_transform(table, "c", "y");
+  EXPECT_EQ(column_values(table, 0), (std::vector<double>{4, 3, 6, 5, 4, 3, 6, 5}));
+  EXPECT_EQ(encoder.mapping().col_dtypes()[0], "string");
+
+  auto new_rows = dictionary_encoded(make_table({"z", "b", std::nullopt, "a"}, {0, 0, 0, 0}));
+  encoder.transform(new_rows, "c");
+  EXPECT_EQ(column_values(new_rows, 0), (std::vector<double>{4.5, 5.5, 4.5, 3.5}));
+}
+
+TEST(CategoryEncoder_Test, RejectsInvalidInput) {
+  EXPECT_THROW(ttb::CategoryEncoder(ttb::CategoryEncoding::MEAN_TARGET, 1),
+               ttb::CategoryEncoderError);
+
+  auto table = make_table({"a", "b"}, {1, 2});
+  ttb::CategoryEncoder encoder;
+  EXPECT_THROW(encoder.transform(table, "c"), ttb::CategoryEncoderError);
+  EXPECT_THROW(encoder.fit_transform(table, "missing", "y"), ttb::CategoryEncoderError);
+  EXPECT_THROW(encoder.fit_transform(table, "y", "c"), ttb::CategoryEncoderError);
+  EXPECT_THROW(encoder.fit_transform(table, "c", "y", 100), ttb::CategoryEncoderError);
+}
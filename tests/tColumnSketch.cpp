@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+
+#include "AnalyticTable.h"
+#include "ColumnSketch.h"
+#include "detail/utils.h"
+
+#include <arrow/api.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+static utl::shp<arrow::Array> make_int_array(int64_t begin, int64_t end, int64_t modulo) {
+  arrow::Int64Builder builder;
+  for (auto i = begin; i < end; ++i)
+    EXPECT_TRUE(builder.Append(i % modulo).ok());
+
+  return builder.Finish().ValueOrDie();
+}
+
+/// 30000 "a", 20000 "b", 10000 "c" and 100000 distinct ids, interleaved
+static utl::shp<arrow::Array> make_skewed_strings() {
+  arrow::StringBuilder builder;
+  for (int i = 0; i < 160000; ++i) {
+    auto slot = i % 16;
+    auto value = slot < 3 ? "a" : slot < 5 ? "b" : slot < 6 ? "c" : "id" + std::to_string(i);
+    EXPECT_TRUE(builder.Append(value).ok());
+  }
+
+  return builder.Finish().ValueOrDie();
+}
+
+TEST(ColumnSketch_Test, EstimatesDistinctCountAcrossChunks) {
+  auto schema = arrow::schema({arrow::field("x", arrow::int64())});
+  auto column = std::make_shared<arrow::ChunkedArray>(
+      arrow::ArrayVector{make_int_array(0, 120000, 50000), make_int_array(120000, 200000, 50000)});
+  ttb::AnalyticTable table{arrow::Table::Make(schema, {column})};
+
+  auto sketch = table.sketch(0);
+  EXPECT_EQ(sketch.count(), 200000);
+  EXPECT_EQ(sketch.null_count(), 0);
+  EXPECT_NEAR(static_cast<double>(sketch.distinct_count()), 50000.0, 50000.0 * 0.02);
+
+  ttb::ColumnSketch small;
+  small.update(make_int_array(0, 100, 7));
+  EXPECT_EQ(small.distinct_count(), 7);
+}
+
+TEST(ColumnSketch_Test, FindsHeavyHittersWithBoundedCounts) {
+  ttb::ColumnSketch sketch{3};
+  sketch.update(make_skewed_strings());
+
+  auto heavy_hitters = sketch.heavy_hitters();
+  ASSERT_EQ(heavy_hitters.size(), 3);
+  std::vector<std::string> expected_values{"a", "b", "c"};
+  std::vector<int64_t> expected_counts{30000, 20000, 10000};
+  for (size_t j = 0; j < 3; ++j) {
+    EXPECT_EQ(heavy_hitters[j].value->ToString(), expected_values[j]);
+    EXPECT_GE(heavy_hitters[j].count, expected_counts[j]);
+    EXPECT_LE(heavy_hitters[j].count - heavy_hitters[j].error, expected_counts[j]);
+  }
+
+  EXPECT_GE(sketch.frequency(arrow::StringScalar{"a"}), 30000);
+  EXPECT_LE(sketch.frequency(arrow::StringScalar{"a"}), 30000 + 160000 / 100);
+  EXPECT_LE(sketch.frequency(arrow::StringScalar{"id7"}), 160000 / 12);
+  EXPECT_NEAR(static_cast<double>(sketch.distinct_count()), 100003.0, 100003.0 * 0.02);
+
+  auto values = sketch.heavy_hitter_values();
+  EXPECT_EQ(values->type_id(), arrow::Type::STRING);
+  EXPECT_EQ(values->length(), 3);
+}
+
+TEST(ColumnSketch_Test, MergesStreamedBatches) {
+  auto strings = make_skewed_strings();
+  ttb::ColumnSketch first{3};
+  ttb::ColumnSketch second{3};
+  first.update(strings->Slice(0, 70000));
+  second.update(strings->Slice(70000));
+
+  arrow::StringBuilder builder;
+  ASSERT_TRUE(builder.AppendNull().ok());
+  ASSERT_TRUE(builder.Append("a").ok());
+  second.update(builder.Finish().ValueOrDie());
+
+  first.merge(second);
+  EXPECT_EQ(first.count(), 160001);
+  EXPECT_EQ(first.null_count(), 1);
+  ASSERT_EQ(first.heavy_hitters().size(), 3);
+  EXPECT_EQ(first.heavy_hitters()[0].value->ToString(), "a");
+  EXPECT_GE(first.heavy_hitters()[0].count, 30001);
+
+  EXPECT_THROW(first.update(make_int_array(0, 10, 10)), ttb::ColumnSketchError);
+  EXPECT_THROW(static_cast<void>(first.frequency(arrow::Int64Scalar{1})), ttb::ColumnSketchError);
+  EXPECT_THROW(ttb::ColumnSketch{0}, ttb::ColumnSketchError);
+}
@@ -4,6 +4,7 @@
 #include "CSV_IO.h"
 #include "Converter.h"
 #include "Parquet_IO.h"
+#include "XYMatrix.h"
 #include "detail/utils.h"
 
 #include <arrow/api.h>
@@ -171,3 +172,100 @@ TEST(Converter_Test, RoundTripPreservesData) {
   EXPECT_EQ(recovered_table.n_rows(), 4);
   EXPECT_EQ(recovered_table.n_cols(), 3);
 }
+
+TEST(Converter_Test, TransposesLargeRowMajorTensor) {
+  // Dimensions not multiple of the transpose tile size
+  constexpr int64_t rows = 131;
+  constexpr int64_t cols = 70;
+  auto tensor = torch::arange(rows * cols, torch::dtype(torch::kFloat64)).reshape({rows, cols});
+
+  auto table = ttb::Converter::analytic_table<double>(std::move(tensor));
+  ASSERT_EQ(table.n_rows(), rows);
+  ASSERT_EQ(table.n_cols(), cols);
+
+  for (int j : {0, 1, 63, 64, 69}) {
+    auto arr =
+        std::static_pointer_cast<arrow::DoubleArray>(table.arrow_table()->column(j)->chunk(0));
+    for (int64_t i : {0L, 1L, 63L, 64L, 130L})
+      EXPECT_DOUBLE_EQ(arr->Value(i), static_cast<double>(i * cols + j));
+  }
+}
+
+TEST(Converter_Test, WrapsColumnMajorTensorWithoutCopy) {
+  auto base =
+      torch::tensor({{1.0f, 2.0f, 3.0f}, {4.0f, 5.0f, 6.0f}}, torch::dtype(torch::kFloat32));
+  // Transposed view: 3 rows x 2 cols stored column by column
+  auto tensor = base.t();
+  const auto *base_ptr = base.data_ptr<float>();
+
+  auto table = ttb::Converter::analytic_table<float>(std::move(tensor));
+  ASSERT_EQ(table.n_rows(), 3);
+  ASSERT_EQ(table.n_cols(), 2);
+
+  auto &arrow_tb = table.arrow_table();
+  auto col_0 = std::static_pointer_cast<arrow::FloatArray>(arrow_tb->column(0)->chunk(0));
+  auto col_1 = std::static_pointer_cast<arrow::FloatArray>(arrow_tb->column(1)->chunk(0));
+  EXPECT_EQ(col_0->raw_values(), base_ptr);
+  EXPECT_FLOAT_EQ(col_0->Value(2), 3.0f);
+  EXPECT_FLOAT_EQ(col_1->Value(0), 4.0f);
+
+  // Table keeps the storage alive after the tensor goes away
+  base = torch::Tensor{};
+  EXPECT_FLOAT_EQ(col_1->Value(2), 6.0f);
+}
+
+TEST(Converter_Test, ConvertsXYMatrixColumnsSideBySide) {
+  auto X = torch::tensor({{1.0, 2.0}, {3.0, 4.0}, {5.0, 6.0}}, torch::dtype(torch::kFloat64));
+  auto Y = torch::tensor({{7.0}, {8.0}, {9.0}}, torch::dtype(torch::kFloat64));
+  ttb::XYMatrix xy{std::move(X), std::move(Y)};
+
+  auto table = ttb::Converter::analytic_table<double>(std::move(xy));
+  ASSERT_EQ(table.n_rows(), 3);
+  ASSERT_EQ(table.n_cols(), 3);
+  EXPECT_EQ(table.arrow_table()->field(2)->name(), "col_3");
+
+  auto &arrow_tb = table.arrow_table();
+  auto col_1 = std::static_pointer_cast<arrow::DoubleArray>(arrow_tb->column(1)->chunk(0));
+  auto col_2 = std::static_pointer_cast<arrow::DoubleArray>(arrow_tb->column(2)->chunk(0));
+  EXPECT_DOUBLE_EQ(col_1->Value(2), 6.0);
+  EXPECT_DOUBLE_EQ(col_2->Value(0), 7.0);
+}
+
+TEST(Converter_Test, ConvertsMultiChunkColumns) {
+  auto first = tconverter::make_numeric_table_float(3, 2);
+  auto second = tconverter::make_numeric_table_float(4, 2);
+  auto r_concat = arrow::ConcatenateTables({first.arrow_table(), second.arrow_table()});
+  ASSERT_TRUE(r_concat.ok());
+  ttb::AnalyticTableNumeric<float> table{r_concat.MoveValueUnsafe()};
+  auto view = table.sliced(1, 5);
+  ASSERT_EQ(view.arrow_table()->column(0)->num_chunks(), 2);
+
+  auto expected = torch::cat({ttb::Converter::torch_tensor(std::move(first)),
+                              ttb::Converter::torch_tensor(std::move(second))})
+                      .narrow(0, 1, 5);
+  auto tensor = ttb::Converter::torch_tensor(ttb::AnalyticTableNumeric<float>{std::move(view)});
+  EXPECT_TRUE(torch::equal(tensor, expected));
+}
+
+TEST(Converter_Test, FillsNullsWhileConverting) {
+  arrow::FloatBuilder fb;
+  ASSERT_TRUE(fb.AppendNull().ok());
+  ASSERT_TRUE(fb.Append(2.0f).ok());
+  ASSERT_TRUE(fb.AppendNull().ok());
+  ASSERT_TRUE(fb.Append(4.0f).ok());
+  auto column = fb.Finish().ValueOrDie();
+  auto schema = arrow::schema({arrow::field("a", arrow::float32())});
+  auto table = arrow::Table::Make(schema, {column});
+  auto chunked = arrow::ConcatenateTables({table, table}).ValueOrDie();
+
+  auto mask = ttb::Converter::validity_mask(ttb::AnalyticTable{std::move(table)});
+  EXPECT_TRUE(torch::equal(mask, torch::tensor({false, true, false, true}).view({4, 1})));
+
+  auto shared = chunked;
+  EXPECT_THROW(ttb::Converter::torch_tensor(ttb::AnalyticTableNumeric<float>{std::move(shared)}),
+               std::runtime_error);
+  auto tensor = ttb::Converter::torch_tensor(ttb::AnalyticTableNumeric<float>{std::move(chunked)},
+                                             ttb::FillStrategy::FORWARD, -1.0f);
+  auto expected = torch::tensor({-1.0f, 2.0f, 2.0f, 4.0f, 4.0f, 2.0f, 2.0f, 4.0f}).view({8, 1});
+  EXPECT_TRUE(torch::equal(tensor, expected));
+}
@@ -0,0 +1,196 @@
+#include <gtest/gtest.h>
+
+#include "AnalyticTable.h"
+#include "GroupBy.h"
+#include "detail/string_kernels.h"
+#include "detail/utils.h"
+
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+static ttb::AnalyticTable make_sales_table() {
+  arrow::StringBuilder sb;
+  arrow::Int32Builder ab;
+  EXPECT_TRUE(sb.AppendValues({"b", "a", "b", "c", "a", "b"}).ok());
+  EXPECT_TRUE(sb.AppendNull().ok());
+  EXPECT_TRUE(ab.AppendValues({1, 2, 3, 4, 2, 5, 7}).ok());
+
+  utl::shp<arrow::Array> scol, acol;
+  EXPECT_TRUE(sb.Finish(&scol).ok());
+  EXPECT_TRUE(ab.Finish(&acol).ok());
+  auto schema =
+      arrow::schema({arrow::field("store", arrow::utf8()), arrow::field("amount", arrow::int32())});
+  return ttb::AnalyticTable{arrow::Table::Make(schema, {scol, acol})};
+}
+
+static double value_at(const ttb::AnalyticTable &table, int col, int64_t row) {
+  auto scalar = table.arrow_table()->column(col)->GetScalar(row).ValueOrDie();
+  return std::static_pointer_cast<arrow::DoubleScalar>(scalar)->value;
+}
+
+TEST(GroupBy_Test, GroupsInOrderOfFirstAppearanceWithNullGroup) {
+  auto table = make_sales_table();
+  auto groups = table.group_by({"store"});
+  EXPECT_EQ(groups.n_groups(), 4);
+
+  auto res = groups.agg({{"amount", ttb::Aggregation::COUNT}});
+  ASSERT_EQ(res.n_rows(), 4);
+  EXPECT_EQ(res.col_names(), (std::vector<std::string>{"store", "amount_count"}));
+
+  auto keys = std::static_pointer_cast<arrow::StringArray>(res.arrow_table()->column(0)->chunk(0));
+  EXPECT_EQ(keys->GetString(0), "b");
+  EXPECT_EQ(keys->GetString(1), "a");
+  EXPECT_EQ(keys->GetString(2), "c");
+  EXPECT_TRUE(keys->IsNull(3));
+
+  auto counts = std::static_pointer_cast<arrow::Int64Array>(res.arrow_table()->column(1)->chunk(0));
+  EXPECT_EQ(counts->Value(0), 3);
+  EXPECT_EQ(counts->Value(1), 2);
+  EXPECT_EQ(counts->Value(2), 1);
+  EXPECT_EQ(counts->Value(3), 1);
+}
+
+TEST(GroupBy_Test, ComputesNumericAggregates) {
+  auto table = make_sales_table();
+  auto res = table.group_by({"store"}).agg({{"amount", ttb::Aggregation::SUM},
+                                            {"amount", ttb::Aggregation::MEAN, "avg"},
+                                            {"amount", ttb::Aggregation::MIN},
+                                            {"amount", ttb::Aggregation::MAX},
+                                            {"amount", ttb::Aggregation::STD},
+                                            {"amount", ttb::Aggregation::COUNT_DISTINCT}});
+  EXPECT_EQ(res.col_names(),
+            (std::vector<std::string>{"store", "amount_sum", "avg", "amount_min", "amount_max",
+                                      "amount_std", "amount_count_distinct"}));
+
+  // Group "b" holds 1, 3 and 5
+  EXPECT_DOUBLE_EQ(value_at(res, 1, 0), 9.0);
+  EXPECT_DOUBLE_EQ(value_at(res, 2, 0), 3.0);
+  EXPECT_DOUBLE_EQ(value_at(res, 3, 0), 1.0);
+  EXPECT_DOUBLE_EQ(value_at(res, 4, 0), 5.0);
+  EXPECT_DOUBLE_EQ(value_at(res, 5, 0), 2.0);
+
+  // Group "a" holds 2 twice, group "c" a single value with no sample std
+  auto distinct = res.arrow_table()->column(6);
+  EXPECT_TRUE(distinct->GetScalar(1).ValueOrDie()->Equals(*arrow::MakeScalar(int64_t{1})));
+  EXPECT_DOUBLE_EQ(value_at(res, 5, 1), 0.0);
+  EXPECT_TRUE(res.arrow_table()->column(5)->GetScalar(2).ValueOrDie()->is_valid == false);
+}
+
+TEST(GroupBy_Test, AggregatesInt64BeyondDoublePrecision) {
+  arrow::Int32Builder kb;
+  arrow::Int64Builder vb;
+  constexpr int64_t LARGE{(int64_t{1} << 53) + 1};
+  EXPECT_TRUE(kb.AppendValues({1, 1, 2}).ok());
+  EXPECT_TRUE(vb.AppendValues({LARGE, 1, 3}).ok());
+
+  utl::shp<arrow::Array> kcol, vcol;
+  EXPECT_TRUE(kb.Finish(&kcol).ok());
+  EXPECT_TRUE(vb.Finish(&vcol).ok());
+  auto schema =
+      arrow::schema({arrow::field("key", arrow::int32()), arrow::field("value", arrow::int64())});
+  ttb::AnalyticTable table{arrow::Table::Make(schema, {kcol, vcol})};
+
+  auto res = table.group_by({"key"}).agg({{"value", ttb::Aggregation::MAX},
+                                          {"value", ttb::Aggregation::SUM}});
+  EXPECT_DOUBLE_EQ(value_at(res, 1, 0), static_cast<double>(LARGE));
+  EXPECT_DOUBLE_EQ(value_at(res, 2, 1), 3.0);
+}
+
+TEST(GroupBy_Test, AggregatesEmptyTableIntoNoGroups) {
+  auto schema =
+      arrow::schema({arrow::field("key", arrow::utf8()), arrow::field("value", arrow::int64())});
+  ttb::AnalyticTable table{arrow::Table::Make(
+      schema, {std::make_shared<arrow::ChunkedArray>(arrow::ArrayVector{}, arrow::utf8()),
+               std::make_shared<arrow::ChunkedArray>(arrow::ArrayVector{}, arrow::int64())})};
+
+  auto res = table.group_by({"key"}).agg({{"value", ttb::Aggregation::SUM},
+                                          {"value", ttb::Aggregation::MEAN},
+                                          {"value", ttb::Aggregation::MIN},
+                                          {"value", ttb::Aggregation::MAX},
+                                          {"value", ttb::Aggregation::STD}});
+  EXPECT_EQ(res.n_rows(), 0);
+  EXPECT_EQ(res.n_cols(), 6);
+}
+
+TEST(GroupBy_Test, GroupsOnSeveralKeysAcrossChunks) {
+  auto table = make_sales_table();
+  table.append(make_sales_table(), ttb::Axis::ROW);
+  ASSERT_GT(table.arrow_table()->column(0)->num_chunks(), 1);
+
+  auto res = table.group_by({"store", "amount"}).agg({{"amount", ttb::Aggregation::COUNT}});
+  EXPECT_EQ(res.n_rows(), 6);
+  auto counts = std::static_pointer_cast<arrow::Int64Array>(res.arrow_table()->column(2)->chunk(0));
+  EXPECT_EQ(counts->Value(0), 2);
+  EXPECT_EQ(counts->Value(1), 4);
+}
+
+TEST(GroupBy_Test, GroupsDictionaryKeysLikeTheirValues) {
+  auto table = make_sales_table();
+  auto stores = table.arrow_table()->column(0)->chunk(0);
+
+  // Each chunk gets its own dictionary, e.g. [b, a] then [c, a, b]
+  arrow::ArrayVector chunks;
+  for (const auto &slice : {stores->Slice(0, 3), stores->Slice(3)})
+    chunks.push_back(arrow::compute::DictionaryEncode(slice).ValueOrDie().make_array());
+  auto encoded = std::make_shared<arrow::ChunkedArray>(chunks);
+  auto schema = arrow::schema(
+      {arrow::field("store", encoded->type()), arrow::field("amount", arrow::int32())});
+  ttb::AnalyticTable dictionary_table{
+      arrow::Table::Make(schema, {encoded, table.arrow_table()->column(1)})};
+
+  auto groups = table.group_by({"store"});
+  auto dictionary_groups = dictionary_table.group_by({"store"});
+  EXPECT_EQ(dictionary_groups.n_groups(), 4);
+  EXPECT_EQ(dictionary_groups.row_groups(), groups.row_groups());
+
+  // Every instruction set hashes and compares alike
+  auto level = utl::simd_level();
+  utl::set_simd_level(utl::SimdLevel::SCALAR);
+  EXPECT_EQ(table.group_by({"store"}).row_groups(), groups.row_groups());
+  EXPECT_EQ(dictionary_table.group_by({"store"}).row_groups(), groups.row_groups());
+  utl::set_simd_level(level);
+}
+
+TEST(GroupBy_Test, SeparatesLongKeysDifferingInTheLastByteAtEverySimdLevel) {
+  // Keys of 17 to 100 bytes go through the out-of-line comparison and its tail; each one is
+  // repeated, and differs from the next only in its last byte
+  arrow::StringBuilder sb;
+  std::vector<int64_t> expected;
+  for (int n_bytes = 17; n_bytes <= 100; ++n_bytes) {
+    auto prefix = std::string(n_bytes - 1, 'k');
+    auto group = static_cast<int64_t>(2 * (n_bytes - 17));
+    for (auto last : {'a', 'b', 'a', 'b'})
+      EXPECT_TRUE(sb.Append(prefix + last).ok());
+    expected.insert(expected.end(), {group, group + 1, group, group + 1});
+  }
+  utl::shp<arrow::Array> keys;
+  EXPECT_TRUE(sb.Finish(&keys).ok());
+  ttb::AnalyticTable table{
+      arrow::Table::Make(arrow::schema({arrow::field("key", arrow::utf8())}), {keys})};
+
+  auto level = utl::simd_level();
+  for (auto other : {utl::SimdLevel::SCALAR, utl::SimdLevel::SSE4_2, utl::SimdLevel::AVX2,
+                     utl::SimdLevel::AVX512}) {
+    utl::set_simd_level(other);
+    auto groups = table.group_by({"key"});
+    EXPECT_EQ(groups.n_groups(), 2 * (100 - 17 + 1));
+    EXPECT_EQ(groups.row_groups(), expected);
+  }
+  utl::set_simd_level(level);
+}
+
+TEST(GroupBy_Test, FailsOnMissingColumnsOrNonNumericAggregates) {
+  auto table = make_sales_table();
+  EXPECT_THROW(static_cast<void>(table.group_by({"missing"})), ttb::GroupByError);
+  EXPECT_THROW(static_cast<void>(table.group_by({})), ttb::GroupByError);
+
+  auto groups = table.group_by({"store"});
+  EXPECT_THROW(static_cast<void>(groups.agg({{"missing", ttb::Aggregation::SUM}})),
+               ttb::GroupByError);
+  EXPECT_THROW(static_cast<void>(groups.agg({{"store", ttb::Aggregation::MEAN}})),
+               ttb::GroupByError);
+}
@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+
+#include "AnalyticTableNumeric.h"
+#include "HashingEncoder.h"
+#include "detail/string_kernels.h"
+#include "detail/utils.h"
+
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+static utl::shp<arrow::ChunkedArray> make_city_column() {
+  arrow::StringBuilder builder;
+  EXPECT_TRUE(builder.AppendValues({"paris", "tokyo", "lima", "paris"}).ok());
+  EXPECT_TRUE(builder.AppendNull().ok());
+  EXPECT_TRUE(builder.Append("oslo").ok());
+
+  auto array = builder.Finish().ValueOrDie();
+  return std::make_shared<arrow::ChunkedArray>(
+      arrow::ArrayVector{array->Slice(0, 3), array->Slice(3)});
+}
+
+TEST(HashingEncoder_Test, MapsEqualValuesToTheSameBucket) {
+  ttb::HashingEncoder encoder{8};
+  auto buckets = encoder.buckets(*make_city_column());
+  ASSERT_EQ(buckets->length(), 6);
+  EXPECT_EQ(buckets->null_count(), 1);
+
+  std::vector<int64_t> values;
+  for (const auto &chunk : buckets->chunks()) {
+    auto typed = std::static_pointer_cast<arrow::Int64Array>(chunk);
+    for (int64_t i = 0; i < typed->length(); ++i)
+      values.push_back(typed->IsNull(i) ? -1 : typed->Value(i));
+  }
+  EXPECT_EQ(values[0], values[3]);
+  EXPECT_EQ(values[4], -1);
+  for (auto value : values)
+    EXPECT_TRUE(value >= -1 && value < 8);
+
+  // Integers of any width, and dictionary-encoded values, hash like their values
+  arrow::Int32Builder int32s;
+  arrow::Int64Builder int64s;
+  ASSERT_TRUE(int32s.AppendValues({7, 42}).ok());
+  ASSERT_TRUE(int64s.AppendValues({7, 42}).ok());
+  auto from_int32 = encoder.buckets(arrow::ChunkedArray{int32s.Finish().ValueOrDie()});
+  auto from_int64 = encoder.buckets(arrow::ChunkedArray{int64s.Finish().ValueOrDie()});
+  EXPECT_TRUE(from_int32->Equals(*from_int64));
+
+  auto encoded = arrow::compute::DictionaryEncode(make_city_column()).ValueOrDie();
+  EXPECT_TRUE(encoder.buckets(*encoded.chunked_array())->Equals(*buckets));
+}
+
+TEST(HashingEncoder_Test, HashesAlikeAtEverySimdLevel) {
+  // Long values go through several words and the tail of the string kernels
+  arrow::StringBuilder builder;
+  for (int i = 0; i < 200; ++i)
+    ASSERT_TRUE(builder.Append(std::string(i % 40, 'x') + std::to_string(i)).ok());
+  arrow::ChunkedArray values{builder.Finish().ValueOrDie()};
+
+  ttb::HashingEncoder encoder{1 << 20, true, 3};
+  auto level = utl::simd_level();
+  auto expected = encoder.buckets(values);
+  for (auto other : {utl::SimdLevel::SCALAR, utl::SimdLevel::SSE4_2, utl::SimdLevel::AVX2,
+                     utl::SimdLevel::AVX512}) {
+    utl::set_simd_level(other);
+    EXPECT_TRUE(encoder.buckets(values)->Equals(*expected));
+  }
+  utl::set_simd_level(level);
+}
+
+TEST(HashingEncoder_Test, HashesLongValuesDifferingInTheLastByteApart) {
+  // Values of 17 to 100 bytes, in pairs that only differ in their last byte
+  std::vector<std::string> values;
+  for (int n_bytes = 17; n_bytes <= 100; ++n_bytes)
+    for (auto last : {'a', 'b'})
+      values.push_back(std::string(n_bytes - 1, 'v') + last);
+
+  auto hash = [](const std::string &value) {
+    return utl::hash_string(reinterpret_cast<const uint8_t *>(value.data()),
+                            static_cast<int64_t>(value.size()), 3);
+  };
+
+  auto level = utl::simd_level();
+  utl::set_simd_level(utl::SimdLevel::SCALAR);
+  std::vector<uint64_t> expected;
+  for (const auto &value : values)
+    expected.push_back(hash(value));
+
+  for (auto other : {utl::SimdLevel::SCALAR, utl::SimdLevel::SSE4_2, utl::SimdLevel::AVX2,
+                     utl::SimdLevel::AVX512}) {
+    utl::set_simd_level(other);
+    for (size_t i = 0; i < values.size(); i += 2) {
+      auto a_hash = hash(values[i]);
+      auto b_hash = hash(values[i + 1]);
+      EXPECT_EQ(a_hash, expected[i]);
+      EXPECT_EQ(b_hash, expected[i + 1]);
+      EXPECT_NE(a_hash, b_hash);
+      EXPECT_FALSE(utl::bytes_equal(reinterpret_cast<const uint8_t *>(values[i].data()),
+                                    reinterpret_cast<const uint8_t *>(values[i + 1].data()),
+                                    static_cast<int64_t>(values[i].size())));
+    }
+  }
+  utl::set_simd_level(level);
+}
+
+TEST(HashingEncoder_Test, BuildsDenseBlockOfSignedFlags) {
+  ttb::HashingEncoder encoder{4, true, 17};
+  auto block = encoder.dense<float>(*make_city_column(), "city_");
+  EXPECT_EQ(block.n_rows(), 6);
+  EXPECT_EQ(block.col_names(), (std::vector<std::string>{"city_0", "city_1", "city_2", "city_3"}));
+
+  for (int64_t r = 0; r < 6; ++r) {
+    int n_set = 0;
+    for (int c = 0; c < 4; ++c) {
+      auto column =
+          std::static_pointer_cast<arrow::FloatArray>(block.arrow_table()->column(c)->chunk(0));
+      auto value = column->Value(r);
+      EXPECT_TRUE(value == 0.0f || value == 1.0f || value == -1.0f);
+      n_set += value != 0.0f ? 1 : 0;
+    }
+    EXPECT_EQ(n_set, r == 4 ? 0 : 1);
+  }
+}
+
+TEST(HashingEncoder_Test, ExpandsTableColumnIntoBuckets) {
+  auto schema = arrow::schema({arrow::field("city", arrow::utf8())});
+  ttb::AnalyticTable table{arrow::Table::Make(schema, {make_city_column()})};
+  table.hash_expand(0, ttb::HashingEncoder{3});
+
+  EXPECT_EQ(table.col_names(), (std::vector<std::string>{"city_0", "city_1", "city_2"}));
+  EXPECT_EQ(table.col_dtypes(), (std::vector<std::string>{"int32", "int32", "int32"}));
+  EXPECT_EQ(table.n_rows(), 6);
+}
+
+TEST(HashingEncoder_Test, BuildsSparseTensor) {
+  ttb::HashingEncoder encoder{16};
+  auto tensor = encoder.sparse<float>(*make_city_column());
+  EXPECT_TRUE(tensor.is_sparse());
+  EXPECT_EQ(tensor.size(0), 6);
+  EXPECT_EQ(tensor.size(1), 16);
+  EXPECT_EQ(tensor._nnz(), 5);
+
+  auto dense = tensor.to_dense();
+  EXPECT_EQ(dense.sum().item<float>(), 5.0f);
+  EXPECT_EQ(dense[4].sum().item<float>(), 0.0f);
+  EXPECT_TRUE(dense[0].equal(dense[3]));
+}
+
+TEST(HashingEncoder_Test, RejectsInvalidInput) {
+  EXPECT_THROW(ttb::HashingEncoder{0}, ttb::HashingEncoderError);
+
+  arrow::DoubleBuilder builder;
+  ASSERT_TRUE(builder.Append(1.5).ok());
+  arrow::ChunkedArray doubles{builder.Finish().ValueOrDie()};
+  EXPECT_THROW(static_cast<void>(ttb::HashingEncoder{4}.buckets(doubles)),
+               ttb::HashingEncoderError);
+}
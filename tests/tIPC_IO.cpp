@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+
+#include "AnalyticTable.h"
+#include "AnalyticTableNumeric.h"
+#include "IPC_IO.h"
+#include "Parquet_IO.h"
+#include "detail/utils.h"
+
+#include <arrow/api.h>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <torch/torch.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace tipc_io {
+static fs::path temp_dir() {
+  auto p = fs::temp_directory_path() / "torchtb_ipc_tests";
+  fs::create_directories(p);
+  return p;
+}
+
+static fs::path unique_arrow(const std::string &stem) {
+  static std::mt19937_64 rng{std::random_device{}()};
+  return temp_dir() / fs::path(stem + "_" + std::to_string(rng()) + ".arrow");
+}
+
+static ttb::AnalyticTable make_table() {
+  arrow::FloatBuilder fb;
+  arrow::StringBuilder sb;
+  EXPECT_TRUE(fb.AppendValues({1.0f, 2.0f, 3.0f}).ok());
+  EXPECT_TRUE(sb.AppendValues({"a", "b", "c"}).ok());
+
+  utl::shp<arrow::Array> fcol;
+  utl::shp<arrow::Array> scol;
+  EXPECT_TRUE(fb.Finish(&fcol).ok());
+  EXPECT_TRUE(sb.Finish(&scol).ok());
+
+  auto schema = arrow::schema({
+      arrow::field("feat", arrow::float32()),
+      arrow::field("label", arrow::utf8()),
+  });
+  auto tbl = arrow::Table::Make(schema, {fcol, scol});
+  return ttb::AnalyticTable{std::move(tbl)};
+}
+
+/// Parquet read of a low-cardinality string column, dictionary encoded with its own values
+static ttb::AnalyticTable read_parquet_strings(const std::vector<std::string> &values) {
+  arrow::StringBuilder sb;
+  for (int i = 0; i < 300; ++i)
+    EXPECT_TRUE(sb.Append(values[i % values.size()]).ok());
+  auto schema = arrow::schema({arrow::field("label", arrow::utf8())});
+  ttb::AnalyticTable table{arrow::Table::Make(schema, {sb.Finish().ValueOrDie()})};
+
+  auto path = unique_arrow("strings").replace_extension(".parquet");
+  ttb::Parquet_IO io(path);
+  io.write(table);
+  auto resp = io.read();
+  fs::remove(path);
+  return resp;
+}
+
+} // namespace tipc_io
+
+TEST(IPC_IO_Test, MissingFileFails) {
+  auto path = tipc_io::unique_arrow("missing");
+  ttb::IPC_IO io(path);
+  EXPECT_THROW(auto x = io.read(), ttb::IPC_IOError);
+}
+
+TEST(IPC_IO_Test, RoundTripTable) {
+  auto path = tipc_io::unique_arrow("roundtrip_tbl");
+  auto table = tipc_io::make_table();
+
+  ttb::IPC_IO io(path);
+  io.write(table);
+  ASSERT_TRUE(fs::exists(path));
+
+  auto r = io.read();
+  EXPECT_EQ(r.n_rows(), 3);
+  EXPECT_EQ(r.n_cols(), 2);
+  EXPECT_TRUE(r.arrow_table()->Equals(*table.arrow_table()));
+
+  fs::remove(path);
+}
+
+TEST(IPC_IO_Test, WritesAppendedDictionaryColumns) {
+  auto path = tipc_io::unique_arrow("dictionaries");
+  auto table = tipc_io::read_parquet_strings({"a", "b"});
+  table.append(tipc_io::read_parquet_strings({"c", "b"}), ttb::Axis::ROW);
+  ASSERT_EQ(table.arrow_table()->column(0)->type()->id(), arrow::Type::DICTIONARY);
+
+  // Each chunk has its own dictionary, an IPC file a single one per column
+  ttb::IPC_IO io(path);
+  io.write(table);
+  auto r = io.read();
+  ASSERT_EQ(r.n_rows(), 600);
+  auto column = r.arrow_table()->column(0);
+  auto value_at = [&column](int64_t row) {
+    auto scalar = column->GetScalar(row).ValueOrDie();
+    return std::static_pointer_cast<arrow::DictionaryScalar>(scalar)
+        ->GetEncodedValue()
+        .ValueOrDie()
+        ->ToString();
+  };
+  EXPECT_EQ(value_at(0), "a");
+  EXPECT_EQ(value_at(300), "c");
+  EXPECT_EQ(value_at(301), "b");
+
+  fs::remove(path);
+}
+
+TEST(IPC_IO_Test, RoundTripCompressedTable) {
+  for (auto compression : {arrow::Compression::LZ4_FRAME, arrow::Compression::ZSTD}) {
+    auto path = tipc_io::unique_arrow("roundtrip_compressed");
+    auto table = tipc_io::make_table();
+
+    ttb::IPC_IO io(path, compression);
+    io.write(table);
+
+    auto r = io.read();
+    EXPECT_TRUE(r.arrow_table()->Equals(*table.arrow_table()));
+
+    fs::remove(path);
+  }
+}
+
+TEST(IPC_IO_Test, UnsupportedCompressionFails) {
+  auto path = tipc_io::unique_arrow("gzip");
+  ttb::IPC_IO io(path, arrow::Compression::GZIP);
+  EXPECT_THROW(io.write(tipc_io::make_table()), ttb::IPC_IOError);
+}
+
+TEST(IPC_IO_Test, WriteThenReadNumericFloat) {
+  auto path = tipc_io::unique_arrow("tensor_float");
+  torch::Tensor t =
+      torch::tensor({{1.0f, 5.0f}, {2.0f, 6.0f}, {3.0f, 7.0f}}, torch::dtype(torch::kFloat32));
+
+  ttb::IPC_IO io(path);
+  io.write<float>(std::move(t));
+
+  auto rn = io.read_numeric<float>();
+  EXPECT_EQ(rn.n_rows(), 3);
+  EXPECT_EQ(rn.n_cols(), 2);
+
+  auto col = std::static_pointer_cast<arrow::FloatArray>(rn.arrow_table()->column(1)->chunk(0));
+  EXPECT_FLOAT_EQ(col->Value(2), 7.0f);
+
+  fs::remove(path);
+}
+
+TEST(IPC_IO_Test, WritesXYMatrix) {
+  auto path = tipc_io::unique_arrow("xy_matrix");
+  auto X = torch::rand({20, 3}, torch::dtype(torch::kFloat64));
+  auto Y = torch::rand({20, 4}, torch::dtype(torch::kFloat64));
+  ttb::XYMatrix xy(std::move(X), std::move(Y));
+
+  ttb::IPC_IO io(path, arrow::Compression::ZSTD);
+  io.write<double>(std::move(xy));
+
+  auto result = io.read();
+  EXPECT_EQ(result.n_rows(), 20);
+  EXPECT_EQ(result.n_cols(), 7);
+
+  fs::remove(path);
+}
+
+TEST(IPC_IO_Test, FailsWithInvalidPath) {
+  ttb::IPC_IO io(fs::path("/nonexistent/directory/test.arrow"));
+  EXPECT_THROW(io.write(tipc_io::make_table()), ttb::IPC_IOError);
+}
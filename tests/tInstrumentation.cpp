@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include "CSV_IO.h"
+#include "Instrumentation.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace tinstrumentation {
+fs::path temp_dir() {
+  auto base = fs::temp_directory_path() / "torchtb_instrumentation_tests";
+  fs::create_directories(base);
+  return base;
+}
+
+fs::path unique_path(const std::string &stem, const std::string &ext) {
+  return temp_dir() / fs::path(stem + "_" + std::to_string(::getpid()) + "_" +
+                               std::to_string(std::rand()) + ext);
+}
+
+void timed_work(int64_t n_rows) {
+  TTB_TIMED_SCOPE("tInstrumentation::timed_work");
+  TTB_COUNT_ROWS(n_rows);
+  TTB_COUNT_BYTES(8 * n_rows);
+}
+} // namespace tinstrumentation
+
+TEST(Instrumentation_Test, AggregatesScopesAcrossThreads) {
+  ttb::Instrumentation::reset();
+
+  std::thread worker([] { tinstrumentation::timed_work(10); });
+  tinstrumentation::timed_work(5);
+  worker.join();
+
+  auto summary = ttb::Instrumentation::summary();
+  if (!ttb::Instrumentation::enabled()) {
+    EXPECT_TRUE(summary.empty());
+    EXPECT_TRUE(ttb::Instrumentation::events().empty());
+    return;
+  }
+
+  auto it = std::ranges::find(summary, std::string{"tInstrumentation::timed_work"},
+                              &ttb::TimedSummary::name);
+  ASSERT_NE(it, summary.end());
+  EXPECT_EQ(it->calls, 2);
+  EXPECT_EQ(it->n_rows, 15);
+  EXPECT_EQ(it->n_bytes, 120);
+  EXPECT_GE(it->seconds, it->max_seconds);
+
+  auto events = ttb::Instrumentation::events();
+  ASSERT_EQ(events.size(), 2u);
+  EXPECT_NE(events[0].thread, events[1].thread);
+}
+
+TEST(Instrumentation_Test, RecordsReadsAndDumpsTraces) {
+  ttb::Instrumentation::reset();
+
+  auto path = tinstrumentation::unique_path("read", ".csv");
+  {
+    std::ofstream ofs(path);
+    ofs << "a,b\n1,2\n3,4\n";
+  }
+  auto table = ttb::CSV_IO{path}.read();
+  EXPECT_EQ(table.n_rows(), 2);
+
+  auto json = ttb::Instrumentation::to_json();
+  auto trace = ttb::Instrumentation::to_chrome_trace();
+  EXPECT_EQ(json.front(), '[');
+  EXPECT_TRUE(trace.starts_with(R"({"displayTimeUnit":"ms","traceEvents":[)"));
+
+  if (ttb::Instrumentation::enabled()) {
+    EXPECT_NE(json.find(R"("name":"CSV_IO::read","calls":1)"), std::string::npos);
+    EXPECT_NE(trace.find(R"("ph":"X")"), std::string::npos);
+  } else
+    EXPECT_EQ(json, "[]");
+
+  auto trace_path = tinstrumentation::unique_path("trace", ".json");
+  ttb::Instrumentation::dump_chrome_trace(trace_path);
+  EXPECT_EQ(fs::file_size(trace_path), trace.size());
+
+  fs::remove(path);
+  fs::remove(trace_path);
+}
@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+
+#include "AnalyticTable.h"
+#include "AnalyticTableNumeric.h"
+#include "CSV_IO.h"
+#include "Converter.h"
+#include "MemoryPool.h"
+
+#include <arrow/api.h>
+#include <arrow/compute/expression.h>
+#include <arrow/memory_pool.h>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace tmemory_pool {
+fs::path unique_path(const std::string &stem) {
+  auto base = fs::temp_directory_path() / "torchtb_memory_pool_tests";
+  fs::create_directories(base);
+  return base / fs::path(stem + "_" + std::to_string(::getpid()) + "_" +
+                         std::to_string(std::rand()) + ".csv");
+}
+} // namespace tmemory_pool
+
+TEST(MemoryPool_Test, ScopeOverridesGlobalPool) {
+  ttb::TrackingMemoryPool global;
+  ttb::TrackingMemoryPool scoped;
+
+  ttb::set_memory_pool(&global);
+  EXPECT_EQ(ttb::memory_pool(), &global);
+  {
+    ttb::MemoryPoolScope scope{&scoped};
+    EXPECT_EQ(ttb::memory_pool(), &scoped);
+  }
+  EXPECT_EQ(ttb::memory_pool(), &global);
+
+  ttb::set_memory_pool(nullptr);
+  EXPECT_EQ(ttb::memory_pool(), arrow::default_memory_pool());
+}
+
+TEST(MemoryPool_Test, TracksPeakPerOperation) {
+  auto path = tmemory_pool::unique_path("peak");
+  {
+    std::ofstream ofs(path);
+    ofs << "a,b\n";
+    for (int i = 0; i < 10000; ++i)
+      ofs << i << "," << 2 * i << "\n";
+  }
+
+  ttb::TrackingMemoryPool pool;
+  {
+    ttb::MemoryPoolScope scope{&pool};
+    auto table = ttb::CSV_IO{path}.read_numeric<double>();
+    EXPECT_EQ(table.n_rows(), 10000);
+    EXPECT_GT(pool.bytes_allocated(), 0);
+  }
+
+  auto peaks = pool.operation_peaks();
+  ASSERT_TRUE(peaks.contains("CSV_IO::read"));
+  EXPECT_GT(peaks["CSV_IO::read"], 0);
+  EXPECT_GE(pool.max_memory(), peaks["CSV_IO::read"]);
+  EXPECT_EQ(pool.bytes_allocated(), 0);
+
+  fs::remove(path);
+}
+
+TEST(MemoryPool_Test, RaisesTypedErrorOverBudget) {
+  ttb::TrackingMemoryPool pool{1 << 10};
+  ttb::MemoryPoolScope scope{&pool};
+
+  auto tensor = torch::rand({1000, 8}, torch::kDouble);
+  EXPECT_THROW(auto x = ttb::Converter::analytic_table<double>(std::move(tensor)),
+               ttb::MemoryBudgetError);
+  EXPECT_EQ(pool.bytes_allocated(), 0);
+
+  pool.set_limit(std::nullopt);
+  auto table = ttb::Converter::analytic_table<double>(torch::rand({1000, 8}, torch::kDouble));
+  EXPECT_EQ(table.n_rows(), 1000);
+}
+
+TEST(MemoryPool_Test, DeduplicationStaysWithinBudget) {
+  arrow::Int64Builder builder;
+  for (int64_t i = 0; i < 100000; ++i)
+    ASSERT_TRUE(builder.Append(i % 1000).ok());
+  auto schema = arrow::schema({arrow::field("k", arrow::int64())});
+  ttb::AnalyticTable table{arrow::Table::Make(schema, {builder.Finish().ValueOrDie()})};
+
+  // Row partitions take 400 kB, the selection bitmap 12.5 kB
+  ttb::TrackingMemoryPool pool{1 << 16};
+  ttb::MemoryPoolScope scope{&pool};
+  EXPECT_THROW(static_cast<void>(table.unique_rows()), ttb::MemoryBudgetError);
+  EXPECT_EQ(pool.bytes_allocated(), 0);
+
+  // Hash slots, two per row across partitions, are allocated by worker threads
+  pool.set_limit(std::nullopt);
+  static_cast<void>(table.unique_rows());
+  EXPECT_GE(pool.total_bytes_allocated(), 400000 + 12500 + 8 * 100000);
+  EXPECT_EQ(table.deduplicated().n_rows(), 1000);
+}
+
+TEST(MemoryPool_Test, FiltersFromScopedPool) {
+  namespace cp = arrow::compute;
+  arrow::ArrayVector chunks;
+  for (int c = 0; c < 4; ++c) {
+    arrow::Int64Builder builder;
+    for (int64_t i = 0; i < 25000; ++i)
+      ASSERT_TRUE(builder.Append(i).ok());
+    chunks.emplace_back(builder.Finish().ValueOrDie());
+  }
+  auto schema = arrow::schema({arrow::field("k", arrow::int64())});
+  ttb::AnalyticTable table{
+      arrow::Table::Make(schema, {std::make_shared<arrow::ChunkedArray>(chunks)})};
+
+  // Every batch is selected by a worker thread, a bit per row, and no row is kept
+  ttb::TrackingMemoryPool pool;
+  ttb::MemoryPoolScope scope{&pool};
+  auto kept = table.filtered(cp::greater(cp::field_ref("k"), cp::literal(int64_t{25000})));
+  EXPECT_EQ(kept.n_rows(), 0);
+  EXPECT_GE(pool.total_bytes_allocated(), 100000 / 8);
+}
+
+TEST(MemoryPool_Test, FillsNullsFromScopedPool) {
+  std::vector<utl::shp<arrow::Array>> columns;
+  std::vector<utl::shp<arrow::Field>> fields;
+  for (int j = 0; j < 4; ++j) {
+    arrow::DoubleBuilder builder;
+    for (int64_t i = 0; i < 10000; ++i)
+      ASSERT_TRUE((i % 2 == 0 ? builder.AppendNull() : builder.Append(1.0)).ok());
+    columns.emplace_back(builder.Finish().ValueOrDie());
+    fields.emplace_back(arrow::field("c" + std::to_string(j), arrow::float64()));
+  }
+  ttb::TbDouble table{arrow::Table::Make(arrow::schema(fields), columns)};
+
+  // Columns are filled by worker threads, their outputs held until the table is rebuilt
+  ttb::TrackingMemoryPool pool;
+  ttb::MemoryPoolScope scope{&pool};
+  table.fill_nulls(ttb::FillStrategy::MEAN);
+  EXPECT_GE(pool.operation_peaks()["AnalyticTableNumeric::fill_nulls"], 4 * 10000 * 8);
+}
+
+TEST(MemoryPool_Test, NullUpstreamFails) {
+  EXPECT_THROW(ttb::TrackingMemoryPool(std::nullopt, nullptr), std::invalid_argument);
+}
+
+TEST(MemoryPool_Test, TracksConcurrentOperationsSeparately) {
+  ttb::TrackingMemoryPool pool;
+  ttb::MemoryPoolScope outer_scope{&pool};
+
+  uint8_t *held{nullptr};
+  {
+    ttb::MemoryOperation outer{"outer"};
+    ASSERT_TRUE(pool.Allocate(1024, &held).ok());
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < 4; ++i)
+      workers.emplace_back([&pool] {
+        ttb::MemoryPoolScope scope{&pool};
+        ttb::MemoryOperation inner{"inner"};
+        for (int j = 0; j < 100; ++j) {
+          uint8_t *buffer{nullptr};
+          ASSERT_TRUE(pool.Allocate(256, &buffer).ok());
+          pool.Free(buffer, 256);
+        }
+      });
+    for (auto &worker : workers)
+      worker.join();
+  }
+  pool.Free(held, 1024);
+
+  auto peaks = pool.operation_peaks();
+  EXPECT_GE(peaks["outer"], 1024 + 256);
+  EXPECT_LE(peaks["outer"], 1024 + 4 * 256);
+  EXPECT_GE(peaks["inner"], 256);
+  EXPECT_LE(peaks["inner"], 1024 + 4 * 256);
+  EXPECT_EQ(pool.bytes_allocated(), 0);
+}
@@ -43,6 +43,29 @@ static ttb::AnalyticTable make_table() {
   return ttb::AnalyticTable{std::move(tbl)};
 }
 
+/// Table of a low-cardinality string column "c" and an int64 column "x", which Parquet reads
+/// back with "c" dictionary encoded
+static ttb::AnalyticTable make_dictionary_table(int64_t n_rows) {
+  arrow::StringBuilder sb;
+  arrow::Int64Builder ib;
+  for (int64_t i = 0; i < n_rows; ++i) {
+    EXPECT_TRUE(sb.Append(i % 3 == 0 ? "a" : "b").ok());
+    EXPECT_TRUE(ib.Append(i).ok());
+  }
+  auto schema =
+      arrow::schema({arrow::field("c", arrow::utf8()), arrow::field("x", arrow::int64())});
+  return ttb::AnalyticTable{
+      arrow::Table::Make(schema, {sb.Finish().ValueOrDie(), ib.Finish().ValueOrDie()})};
+}
+
+static ttb::AnalyticTable read_back(const ttb::AnalyticTable &table, const std::string &stem) {
+  ttb::Parquet_IO io(unique_parquet(stem));
+  io.write(table);
+  auto resp = io.read();
+  EXPECT_EQ(resp.arrow_table()->column(0)->type()->id(), arrow::Type::DICTIONARY);
+  return resp;
+}
+
 // Helper to create test XYMatrix
 ttb::XYMatrix make_test_xy_matrix(int64_t rows, int64_t x_cols, int64_t y_cols) {
   auto X = torch::rand({rows, x_cols}, torch::dtype(torch::kFloat32));
@@ -97,6 +120,72 @@ TEST(Parquet_IO_Test, RoundTripTable) {
   EXPECT_EQ(names[1], "label");
 }
 
+TEST(Parquet_IO_Test, ReadsDictionaryEncodedStringsAsDictionaries) {
+  auto path = tparquet_io::unique_parquet("dictionary");
+  arrow::StringBuilder sb;
+  arrow::Int64Builder ib;
+  for (int64_t i = 0; i < 1000; ++i) {
+    EXPECT_TRUE(sb.Append(i % 3 == 0 ? "a" : "b").ok());
+    EXPECT_TRUE(ib.Append(i).ok());
+  }
+  auto schema =
+      arrow::schema({arrow::field("c", arrow::utf8()), arrow::field("x", arrow::int64())});
+  ttb::AnalyticTable table{
+      arrow::Table::Make(schema, {sb.Finish().ValueOrDie(), ib.Finish().ValueOrDie()})};
+
+  ttb::Parquet_IO io(path);
+  io.write(table);
+  auto r = io.read();
+
+  // Parquet writes low-cardinality strings as dictionary pages, read back as codes
+  auto column = r.arrow_table()->column(0);
+  ASSERT_EQ(column->type()->id(), arrow::Type::DICTIONARY);
+  EXPECT_EQ(r.arrow_table()->column(1)->type()->id(), arrow::Type::INT64);
+  const auto &encoded = static_cast<const arrow::DictionaryArray &>(*column->chunk(0));
+  EXPECT_EQ(encoded.dictionary()->length(), 2);
+  EXPECT_EQ(encoded.dictionary()->GetScalar(encoded.GetValueIndex(3)).ValueOrDie()->ToString(),
+            "a");
+}
+
+TEST(Parquet_IO_Test, JoinsDictionaryKeysWithPlainKeys) {
+  auto table = tparquet_io::read_back(tparquet_io::make_dictionary_table(1000), "join");
+
+  // Plain strings, as read from CSV
+  arrow::StringBuilder sb;
+  arrow::Int64Builder ib;
+  EXPECT_TRUE(sb.AppendValues({"b", "a"}).ok());
+  EXPECT_TRUE(ib.AppendValues({20, 10}).ok());
+  auto schema =
+      arrow::schema({arrow::field("c", arrow::utf8()), arrow::field("y", arrow::int64())});
+  ttb::AnalyticTable right{
+      arrow::Table::Make(schema, {sb.Finish().ValueOrDie(), ib.Finish().ValueOrDie()})};
+
+  auto res = table.joined(right, {"c"});
+  ASSERT_EQ(res.n_rows(), 1000);
+  EXPECT_EQ(res.col_names(), (std::vector<std::string>{"c", "x", "y"}));
+  auto y = res.arrow_table()->column(2);
+  EXPECT_EQ(y->GetScalar(3).ValueOrDie()->ToString(), "10");
+  EXPECT_EQ(y->GetScalar(4).ValueOrDie()->ToString(), "20");
+}
+
+TEST(Parquet_IO_Test, AppendsDictionaryColumnsToPlainColumns) {
+  auto plain = tparquet_io::make_dictionary_table(3);
+  auto parquet = tparquet_io::read_back(tparquet_io::make_dictionary_table(1000), "append");
+
+  plain.append(parquet, ttb::Axis::ROW);
+  ASSERT_EQ(plain.n_rows(), 1003);
+  auto column = plain.arrow_table()->column(0);
+  EXPECT_EQ(column->type()->id(), arrow::Type::STRING);
+  EXPECT_EQ(column->GetScalar(6).ValueOrDie()->ToString(), "a");
+  EXPECT_EQ(column->GetScalar(7).ValueOrDie()->ToString(), "b");
+
+  // The other way round, the dictionary column is decoded alike
+  parquet.append(tparquet_io::make_dictionary_table(3), ttb::Axis::ROW);
+  ASSERT_EQ(parquet.n_rows(), 1003);
+  EXPECT_EQ(parquet.arrow_table()->column(0)->type()->id(), arrow::Type::STRING);
+  EXPECT_EQ(parquet.arrow_table()->column(0)->GetScalar(1000).ValueOrDie()->ToString(), "a");
+}
+
 TEST(Parquet_IO_Test, WriteThenReadNumericFloat) {
   auto path = tparquet_io::unique_parquet("tensor_float");
   // 3 rows x 2 cols tensor
@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+
+#include "Snapshot_IO.h"
+#include "TrainingBundle.h"
+#include "XYMatrix.h"
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <torch/torch.h>
+
+namespace fs = std::filesystem;
+
+namespace tsnapshot_io {
+static fs::path temp_dir() {
+  auto p = fs::temp_directory_path() / "torchtb_snapshot_tests";
+  fs::create_directories(p);
+  return p;
+}
+
+static fs::path unique_snapshot(const std::string &stem) {
+  static std::mt19937_64 rng{std::random_device{}()};
+  return temp_dir() / fs::path(stem + "_" + std::to_string(rng()) + ".ttb");
+}
+
+static ttb::TrainingBundle make_bundle() {
+  auto X_train = torch::arange(12, torch::dtype(torch::kFloat32)).reshape({4, 3});
+  auto Y_train = torch::eye(4, 2, torch::dtype(torch::kFloat32));
+  auto X_eval = torch::arange(6, torch::dtype(torch::kFloat32)).reshape({2, 3});
+  auto Y_eval = torch::eye(2, 2, torch::dtype(torch::kFloat32));
+
+  return {ttb::XYMatrix{std::move(X_train), std::move(Y_train)},
+          ttb::XYMatrix{std::move(X_eval), std::move(Y_eval)}};
+}
+
+/// Overwrites the bytes of a value at a position of the file, as a corrupted write would
+template <typename T>
+static void patch(const fs::path &path, std::streamoff position, T value) {
+  std::fstream fs(path, std::ios::binary | std::ios::in | std::ios::out);
+  fs.seekp(position);
+  fs.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+} // namespace tsnapshot_io
+
+TEST(Snapshot_IO_Test, RoundTripXYMatrix) {
+  auto path = tsnapshot_io::unique_snapshot("xy");
+  auto X = torch::rand({10, 4}, torch::dtype(torch::kFloat64));
+  auto Y = torch::randint(0, 3, {10, 1}, torch::dtype(torch::kInt64));
+  ttb::XYMatrix xy{X.clone(), Y.clone()};
+
+  ttb::Snapshot_IO io(path);
+  io.write(xy);
+  auto read = io.read_xy_matrix();
+
+  EXPECT_TRUE(torch::equal(read.X(), X));
+  EXPECT_TRUE(torch::equal(read.Y(), Y));
+  EXPECT_EQ(read.Y().scalar_type(), torch::kInt64);
+
+  fs::remove(path);
+}
+
+TEST(Snapshot_IO_Test, RoundTripTrainingBundleWithStats) {
+  auto path = tsnapshot_io::unique_snapshot("bundle");
+  auto bundle = tsnapshot_io::make_bundle();
+  bundle.min_max_normz(0);
+
+  ttb::Snapshot_IO io(path);
+  io.write(bundle);
+  auto read = io.read_training_bundle();
+
+  EXPECT_TRUE(torch::equal(read.X_train(), bundle.X_train()));
+  EXPECT_TRUE(torch::equal(read.Y_train(), bundle.Y_train()));
+  EXPECT_TRUE(torch::equal(read.X_eval(), bundle.X_eval()));
+  EXPECT_TRUE(torch::equal(read.Y_eval(), bundle.Y_eval()));
+
+  ASSERT_EQ(read.normz_stats().size(), 1u);
+  EXPECT_EQ(read.normz_stats()[0].normalization, ttb::Normalization::MIN_MAX);
+  EXPECT_DOUBLE_EQ(read.normz_stats()[0].second, 9.0);
+
+  fs::remove(path);
+}
+
+TEST(Snapshot_IO_Test, MappedTensorsAreWritableWithoutTouchingFile) {
+  auto path = tsnapshot_io::unique_snapshot("cow");
+  ttb::Snapshot_IO io(path);
+  io.write(tsnapshot_io::make_bundle());
+
+  {
+    auto read = io.read_training_bundle();
+    read.z_score_normz(1);
+  }
+
+  auto reread = io.read_training_bundle();
+  EXPECT_TRUE(torch::equal(reread.X_train(), tsnapshot_io::make_bundle().X_train()));
+  EXPECT_TRUE(reread.normz_stats().empty());
+
+  fs::remove(path);
+}
+
+TEST(Snapshot_IO_Test, RoundTripEmptyXYMatrix) {
+  auto path = tsnapshot_io::unique_snapshot("empty");
+  ttb::XYMatrix xy{torch::empty({0, 3}), torch::empty({0, 1})};
+
+  ttb::Snapshot_IO io(path);
+  io.write(xy);
+  auto read = io.read_xy_matrix();
+  EXPECT_EQ(read.n_rows(), 0);
+  EXPECT_EQ(read.n_cols(), 4);
+
+  fs::remove(path);
+}
+
+TEST(Snapshot_IO_Test, FailsOnKindMismatch) {
+  auto path = tsnapshot_io::unique_snapshot("kind");
+  ttb::Snapshot_IO io(path);
+  io.write(tsnapshot_io::make_bundle());
+
+  EXPECT_THROW(auto x = io.read_xy_matrix(), ttb::Snapshot_IOError);
+
+  fs::remove(path);
+}
+
+TEST(Snapshot_IO_Test, FailsOnForeignFile) {
+  auto path = tsnapshot_io::unique_snapshot("foreign");
+  std::ofstream ofs(path, std::ios::binary);
+  ofs << "this is definitely not a snapshot file";
+  ofs.close();
+
+  ttb::Snapshot_IO io(path);
+  EXPECT_THROW(auto x = io.read_xy_matrix(), ttb::Snapshot_IOError);
+
+  fs::remove(path);
+}
+
+TEST(Snapshot_IO_Test, FailsOnCorruptedBlobHeaders) {
+  // The first blob header follows the 24-byte file header: dtype, element size, rows, columns,
+  // offset and size
+  constexpr std::streamoff BLOB{24};
+  auto corrupted = [](auto patch_file) {
+    auto path = tsnapshot_io::unique_snapshot("corrupted");
+    ttb::Snapshot_IO io(path);
+    io.write(ttb::XYMatrix{torch::ones({4, 3}), torch::ones({4, 1})});
+    patch_file(path);
+    EXPECT_THROW(auto x = io.read_xy_matrix(), ttb::Snapshot_IOError);
+    fs::remove(path);
+  };
+
+  corrupted([](const fs::path &path) { tsnapshot_io::patch(path, BLOB, int32_t{1000}); });
+  corrupted([](const fs::path &path) { tsnapshot_io::patch(path, BLOB, int32_t{-1}); });
+  // 2^62 + 4 rows of 3 floats wrap around to the 48 bytes stored
+  corrupted([](const fs::path &path) {
+    tsnapshot_io::patch(path, BLOB + 8, (int64_t{1} << 62) + 4);
+  });
+  corrupted([](const fs::path &path) { tsnapshot_io::patch(path, BLOB + 24, uint64_t{4097}); });
+}
+
+TEST(Snapshot_IO_Test, MissingFileFails) {
+  ttb::Snapshot_IO io(tsnapshot_io::unique_snapshot("missing"));
+  EXPECT_THROW(auto x = io.read_training_bundle(), ttb::Snapshot_IOError);
+}
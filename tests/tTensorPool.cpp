@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+
+#include "TensorPool.h"
+#include "XYMatrix.h"
+
+#include <torch/torch.h>
+
+using ttb::TensorPool;
+
+TEST(TensorPool_Test, ReusesReleasedBuffers) {
+  TensorPool::enable();
+  auto before = TensorPool::stats();
+  {
+    auto tensor = TensorPool::empty({1 << 18, 4}, torch::kFloat);
+    EXPECT_EQ(tensor.size(0), 1 << 18);
+    EXPECT_EQ(TensorPool::stats().live_bytes - before.live_bytes, 4 << 20);
+  }
+  EXPECT_EQ(TensorPool::stats().idle_bytes - before.idle_bytes, 4 << 20);
+
+  auto tensor = TensorPool::empty({1 << 20}, torch::kFloat);
+  auto after = TensorPool::stats();
+  EXPECT_EQ(after.hits - before.hits, 1);
+  EXPECT_EQ(after.misses - before.misses, 1);
+
+  TensorPool::disable();
+  EXPECT_EQ(TensorPool::stats().idle_bytes, 0);
+}
+
+TEST(TensorPool_Test, SmallTensorsBypassThePool) {
+  TensorPool::enable();
+  auto before = TensorPool::stats();
+  auto tensor = TensorPool::empty({16, 4}, torch::kDouble);
+  auto after = TensorPool::stats();
+  EXPECT_EQ(after.hits, before.hits);
+  EXPECT_EQ(after.misses, before.misses);
+  TensorPool::disable();
+}
+
+TEST(TensorPool_Test, ShufflesReuseBuffersAcrossEpochs) {
+  auto X = torch::arange(1 << 19, torch::kFloat).reshape({-1, 4});
+  auto Y = torch::arange(1 << 17, torch::kFloat).reshape({-1, 1});
+  ttb::XYMatrix XY{X.clone(), Y.clone()};
+
+  TensorPool::enable();
+  XY.shuffle(7);
+  auto first = TensorPool::stats();
+  for (int epoch{0}; epoch < 3; ++epoch)
+    XY.shuffle(epoch);
+  auto last = TensorPool::stats();
+  EXPECT_EQ(last.hits - first.hits, 2);
+
+  // Rows stay paired after reshuffling: Y holds the row index
+  auto rows = XY.Y().squeeze(1).to(torch::kLong);
+  EXPECT_TRUE(torch::equal(XY.X(), X.index_select(0, rows)));
+  TensorPool::disable();
+}
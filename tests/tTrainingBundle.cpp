@@ -149,3 +149,53 @@ TEST(TrainingBundle_Test, ZScoreNormzThrowsOnNonFloatingPoint) {
 
   EXPECT_THROW(tb.z_score_normz(/*X_col=*/0), ttb::TrainingBundleError);
 }
+
+// ------------ normz_stats ------------
+
+TEST(TrainingBundle_Test, RecordsNormalizationStats) {
+  auto Xtr = make_X({{0.f, 1.f}, {5.f, 2.f}, {10.f, 3.f}});
+  auto Ytr = createOneHotEncoding({0, 1, 2}, 3);
+  auto Xev = make_X({{2.5f, 4.f}, {7.5f, 5.f}});
+  auto Yev = createOneHotEncoding({1, 0}, 3);
+
+  TrainingBundle tb(XYMatrix(std::move(Xtr), std::move(Ytr)),
+                    XYMatrix(std::move(Xev), std::move(Yev)));
+  EXPECT_TRUE(tb.normz_stats().empty());
+
+  tb.min_max_normz(/*X_col=*/0);
+  tb.z_score_normz(/*X_col=*/1);
+
+  const auto &stats = tb.normz_stats();
+  ASSERT_EQ(stats.size(), 2u);
+  EXPECT_EQ(stats[0].X_col, 0);
+  EXPECT_EQ(stats[0].normalization, ttb::Normalization::MIN_MAX);
+  EXPECT_DOUBLE_EQ(stats[0].first, 0.0);
+  EXPECT_DOUBLE_EQ(stats[0].second, 10.0);
+  EXPECT_EQ(stats[1].X_col, 1);
+  EXPECT_EQ(stats[1].normalization, ttb::Normalization::Z_SCORE);
+  EXPECT_DOUBLE_EQ(stats[1].first, 2.0);
+}
+
+// ------------ quantile_bin ------------
+
+TEST(TrainingBundle_Test, QuantileBinFitsOnTrainAndBinsBoth) {
+  auto Xtr = make_X({{0.f, 1.f}, {1.f, 2.f}, {2.f, 3.f}, {3.f, 4.f}});
+  auto Ytr = createOneHotEncoding({0, 1, 2, 0}, 3);
+  auto Xev = make_X({{-5.f, 4.f}, {2.5f, 5.f}});
+  auto Yev = createOneHotEncoding({1, 0}, 3);
+
+  TrainingBundle tb(XYMatrix(std::move(Xtr), std::move(Ytr)),
+                    XYMatrix(std::move(Xev), std::move(Yev)));
+  auto edges = tb.quantile_bin(0, 2);
+  ASSERT_EQ(edges.size(), 3);
+
+  auto binned = tb.X_train().select(1, 0);
+  EXPECT_TRUE(torch::equal(binned, torch::tensor({0.f, 0.f, 1.f, 1.f})));
+  EXPECT_FLOAT_EQ(tb.X_eval()[0][0].item<float>(), 0.f);
+  EXPECT_FLOAT_EQ(tb.X_eval()[1][0].item<float>(), 1.f);
+  EXPECT_FLOAT_EQ(tb.X_train()[0][1].item<float>(), 1.f);
+
+  EXPECT_EQ(tb.histogram(0, ttb::Binner{std::vector<double>{0.0, 0.5, 1.0}}),
+            (std::vector<int64_t>{2, 2}));
+  EXPECT_THROW(tb.quantile_bin(2, 2), ttb::TrainingBundleError);
+}
@@ -381,4 +381,30 @@ TEST(XYMatrix_Test, SplitHandlesEdgeCases) {
 
   EXPECT_THROW(auto result = XYMatrix::split(std::move(xy_matrix), 0), ttb::XYMatrixError);
   EXPECT_THROW(auto result = XYMatrix::split(std::move(xy_matrix), 100), ttb::XYMatrixError);
-}
\ No newline at end of file
+}
+
+TEST(XYMatrix_Test, SplitReturnsViewsOfMovedInStorage) {
+  auto [X, Y] = create_test_data(100, 5, 2);
+  const auto *X_data = X.data_ptr<float>();
+  XYMatrix xy_matrix(std::move(X), std::move(Y));
+
+  auto result = XYMatrix::split(std::move(xy_matrix), 20);
+  EXPECT_TRUE(result.XY_train().is_view());
+  EXPECT_TRUE(result.XY_eval().is_view());
+  EXPECT_EQ(result.XY_train().X().data_ptr<float>(), X_data);
+  EXPECT_EQ(result.XY_eval().X().data_ptr<float>(), X_data + 80 * 5);
+}
+
+TEST(XYMatrix_Test, CompactGivesViewsStorageOfTheirOwn) {
+  auto [X, Y] = create_test_data(100, 5, 2);
+  auto X_expected = X.narrow(0, 80, 20).clone();
+  XYMatrix xy_matrix(std::move(X), std::move(Y));
+
+  auto result = XYMatrix::split(std::move(xy_matrix), 20);
+  auto eval = XYMatrix{torch::Tensor{result.XY_eval().X()}, torch::Tensor{result.XY_eval().Y()}};
+  eval.compact();
+
+  EXPECT_FALSE(eval.is_view());
+  EXPECT_NE(eval.X().data_ptr<float>(), result.XY_eval().X().data_ptr<float>());
+  EXPECT_TRUE(torch::equal(eval.X(), X_expected));
+}